@@ -17,28 +17,50 @@
 #include <algorithm>
 #include <utility>
 
+#include "editing/line_operators.h"
+#include "editing/motions.h"
 #include "terminal/term.h"
+#include "text/char_class.h"
+#include "text/undo_history.h"
+#include "zen/trace_event.h"
 
 namespace zi {
+namespace {
 
-Editor::Editor() {}
+// How far ">>" and "<<" shift a line.
+constexpr size_t kShiftWidth = 2;
+
+}  // namespace
+
+Editor::Editor() : text_(new TextBuffer()) {}
 
 Editor::~Editor() {}
 
 void Editor::SetText(std::unique_ptr<TextBuffer> text) {
+  ClearExtraCursors();
   text_ = std::move(text);
   lines_.Clear();
+  MarkLinesDirty();
+  base_line_ = 0;
+  cursor_row_ = 0;
+  line_start_ = 0;
+  SetCursorColumn(0);
 }
 
 void Editor::Display(CommandBuffer* commands) {
-  lines_.UpdateLines(text_.get());
-  for (size_t i = 0; i < lines_.size(); ++i) {
+  TRACE_EVENT0("editing", "Editor::Display");
+  UpdateLines();
+  const size_t line_count = lines_.size() - std::min(base_line_, lines_.size());
+  const size_t visible_count = std::min(line_count, height_);
+  for (size_t i = 0; i < visible_count; ++i) {
     commands->MoveCursorTo(0, i);
     *commands << text_->GetTextForRange(lines_.GetLine(i + base_line_));
   }
-  if (height_ > lines_.size()) {
+  if (!extra_cursors_.empty())
+    DisplayExtraCursors(commands, visible_count);
+  if (height_ > visible_count) {
     *commands << term::kSetLowIntensity;
-    for (size_t i = lines_.size(); i < height_; ++i) {
+    for (size_t i = visible_count; i < height_; ++i) {
       commands->MoveCursorTo(0, i);
       *commands << "~" << term::kEraseToEndOfLine;
     }
@@ -66,34 +88,75 @@ void Editor::ScrollBy(int delta) {
     ScrollTo(base_line_ + delta);
 }
 
+void Editor::AppendText(StringView text) {
+  text_->Append(text);
+  if (!lines_dirty_)
+    lines_.ExtendLines(text_.get());
+}
+
 void Editor::InsertCharacter(char c) {
+  if (!extra_cursors_.empty()) {
+    EditAtCursors(false, StringView(&c, &c + 1));
+    return;
+  }
   text_->InsertCharacter(GetCurrentTextPosition(), c);
   SetCursorColumn(cursor_col_ + 1);
+  MarkLinesDirty();
 }
 
 void Editor::InsertLineBreak() {
-  text_->InsertCharacter(GetCurrentTextPosition(), '\n');
+  if (!extra_cursors_.empty()) {
+    const char c = '\n';
+    EditAtCursors(false, StringView(&c, &c + 1));
+    return;
+  }
+  TextPosition position = GetCurrentTextPosition();
+  text_->InsertCharacter(position, '\n');
   ++cursor_row_;
+  line_start_ = position.offset() + 1;
   SetCursorColumn(0);
+  EnsureCursorVisible();
+  MarkLinesDirty();
 }
 
 bool Editor::Backspace() {
+  if (!extra_cursors_.empty())
+    return EditAtCursors(true, StringView());
   size_t position = GetCurrentTextPosition().offset();
   if (position > 0) {
     if (cursor_col_ > 0) {
       SetCursorColumn(cursor_col_ - 1);
     } else {
       // We must not be in the first row because our position is non-zero and
-      // our column is zero.
+      // our column is zero. The cursor lands where the line break used to be.
       --cursor_row_;
-      SetCursorColumn(GetMaxCursorColumn());
+      line_start_ = FindLineStart(position - 1);
+      SetCursorColumn(position - 1 - line_start_);
+      EnsureCursorVisible();
     }
     text_->DeleteRange(TextBufferRange(position - 1, position));
+    MarkLinesDirty();
     return true;
   }
   return false;
 }
 
+bool Editor::Undo(UndoHistory* history) {
+  size_t offset = 0;
+  if (!history->Undo(text_.get(), &offset))
+    return false;
+  MoveCursorToOffset(offset);
+  return true;
+}
+
+bool Editor::Redo(UndoHistory* history) {
+  size_t offset = 0;
+  if (!history->Redo(text_.get(), &offset))
+    return false;
+  MoveCursorToOffset(offset);
+  return true;
+}
+
 void Editor::SetCursorMode(CursorMode mode) {
   cursor_mode_ = mode;
   cursor_col_ = std::min(cursor_col_, GetMaxCursorColumn());
@@ -109,8 +172,10 @@ bool Editor::MoveCursorLeft() {
 }
 
 bool Editor::MoveCursorDown() {
-  if (cursor_row_ + 1 < lines_.size()) {
+  size_t end = GetCurrentLineEnd();
+  if (end + 1 < text_->size()) {
     ++cursor_row_;
+    line_start_ = end + 1;
     EnsureCursorVisible();
     cursor_col_ = std::min(preferred_cursor_col_, GetMaxCursorColumn());
     return true;
@@ -121,6 +186,7 @@ bool Editor::MoveCursorDown() {
 bool Editor::MoveCursorUp() {
   if (cursor_row_ > 0) {
     --cursor_row_;
+    line_start_ = FindLineStart(line_start_ - 1);
     EnsureCursorVisible();
     cursor_col_ = std::min(preferred_cursor_col_, GetMaxCursorColumn());
     return true;
@@ -137,26 +203,203 @@ bool Editor::MoveCursorRight() {
   return false;
 }
 
+bool Editor::MoveCursorToNextWord() {
+  const size_t position = GetCurrentTextPosition().offset();
+  return MoveCursorWithinText(
+      FindNextWordStart(text_->GetText(), position, false));
+}
+
+bool Editor::MoveCursorToNextBigWord() {
+  const size_t position = GetCurrentTextPosition().offset();
+  return MoveCursorWithinText(
+      FindNextWordStart(text_->GetText(), position, true));
+}
+
+bool Editor::MoveCursorToPreviousWord() {
+  const size_t position = GetCurrentTextPosition().offset();
+  return MoveCursorWithinText(
+      FindPreviousWordStart(text_->GetText(), position, false));
+}
+
+bool Editor::MoveCursorToPreviousBigWord() {
+  const size_t position = GetCurrentTextPosition().offset();
+  return MoveCursorWithinText(
+      FindPreviousWordStart(text_->GetText(), position, true));
+}
+
+bool Editor::MoveCursorToWordEnd() {
+  const size_t position = GetCurrentTextPosition().offset();
+  return MoveCursorWithinText(FindWordEnd(text_->GetText(), position, false));
+}
+
+bool Editor::MoveCursorToBigWordEnd() {
+  const size_t position = GetCurrentTextPosition().offset();
+  return MoveCursorWithinText(FindWordEnd(text_->GetText(), position, true));
+}
+
+bool Editor::MoveCursorToNextParagraph() {
+  const size_t position = GetCurrentTextPosition().offset();
+  return MoveCursorWithinText(FindNextParagraph(text_->GetText(), position));
+}
+
+bool Editor::MoveCursorToPreviousParagraph() {
+  const size_t position = GetCurrentTextPosition().offset();
+  return MoveCursorWithinText(
+      FindPreviousParagraph(text_->GetText(), position));
+}
+
+bool Editor::MoveCursorToLine(size_t line) {
+  if (line >= GetLineCount())
+    return false;
+  cursor_row_ = line;
+  line_start_ = lines_.GetLine(line)->start();
+  EnsureCursorVisible();
+  SetCursorColumn(0);
+  return true;
+}
+
+size_t Editor::GetLineCount() {
+  UpdateLines();
+  return lines_.size();
+}
+
+TextRange Editor::GetLineRange(size_t first_line, size_t last_line) {
+  last_line = std::min(last_line, GetLineCount() - 1);
+  if (!lines_.size() || first_line > last_line)
+    return TextRange();
+  const size_t end = lines_.GetLine(last_line)->end();
+  return TextRange(lines_.GetLine(first_line)->start(),
+                   std::min(end + 1, text_->size()));
+}
+
+void Editor::ReplaceText(const TextRange& range, StringView text) {
+  text_->ReplaceRange(TextBufferRange(range), text);
+  MoveCursorToOffset(range.start());
+}
+
+Substitution Editor::Substitute(size_t first_line,
+                                size_t last_line,
+                                StringView pattern,
+                                StringView replacement,
+                                bool global) {
+  const TextRange range = GetLineRange(first_line, last_line);
+  const Substitution result =
+      zi::Substitute(text_.get(), range.start(), range.end(), pattern,
+                     replacement, global);
+  if (result.count) {
+    MoveCursorToOffset(result.last_offset);
+    SetCursorColumn(0);
+  }
+  return result;
+}
+
+void Editor::SortLines(size_t first_line,
+                       size_t last_line,
+                       const SortOptions& options) {
+  const TextRange range = GetLineRange(first_line, last_line);
+  const std::vector<char> sorted = zi::SortLines(
+      text_->GetText().Slice(range.start(), range.end()), options);
+  ReplaceText(range, StringView(sorted.data(), sorted.data() + sorted.size()));
+}
+
+void Editor::IndentLines(size_t first_line, size_t last_line) {
+  const TextRange range = GetLineRange(first_line, last_line);
+  zi::IndentLines(text_.get(), range.start(), range.end(), kShiftWidth);
+  MoveCursorToIndentation(first_line);
+}
+
+void Editor::OutdentLines(size_t first_line, size_t last_line) {
+  const TextRange range = GetLineRange(first_line, last_line);
+  zi::OutdentLines(text_.get(), range.start(), range.end(), kShiftWidth);
+  MoveCursorToIndentation(first_line);
+}
+
+bool Editor::ToggleComment(size_t first_line,
+                           size_t last_line,
+                           StringView prefix) {
+  const TextRange range = GetLineRange(first_line, last_line);
+  const bool commented =
+      zi::ToggleComment(text_.get(), range.start(), range.end(), prefix);
+  MoveCursorToIndentation(first_line);
+  return commented;
+}
+
+bool Editor::JoinLines(size_t first_line, size_t last_line) {
+  if (last_line == first_line)
+    ++last_line;
+  if (last_line >= GetLineCount())
+    return false;
+  // Leave out the line break after the last line.
+  const size_t begin = lines_.GetLine(first_line)->start();
+  const size_t end = lines_.GetLine(last_line)->start();
+  MoveCursorToOffset(zi::JoinLines(text_.get(), begin, end));
+  return true;
+}
+
+bool Editor::AddCursorBelow() {
+  const size_t offset = GetCurrentTextPosition().offset();
+  if (!MoveCursorDown())
+    return false;
+  auto it = FindExtraCursor(offset);
+  if (it == extra_cursors_.end() || (*it)->start() != offset) {
+    TextBufferRange* cursor = cursor_ranges_.New(offset, offset);
+    text_->AddRange(cursor);
+    extra_cursors_.insert(it, cursor);
+  }
+  // The cursor might have landed on an extra cursor.
+  const size_t position = GetCurrentTextPosition().offset();
+  it = FindExtraCursor(position);
+  if (it != extra_cursors_.end() && (*it)->start() == position) {
+    text_->RemoveRange(*it);
+    cursor_ranges_.Delete(*it);
+    extra_cursors_.erase(it);
+  }
+  return true;
+}
+
+bool Editor::ClearExtraCursors() {
+  if (extra_cursors_.empty())
+    return false;
+  text_->RemoveRanges(extra_cursors_.begin(), extra_cursors_.end());
+  extra_cursors_.clear();
+  cursor_ranges_.Clear();
+  return true;
+}
+
 void Editor::EnsureCursorVisible() {
   if (cursor_row_ < base_line_)
     ScrollTo(cursor_row_);
-  else if (cursor_row_ > base_line_ + height_)
+  else if (cursor_row_ >= base_line_ + height_)
     ScrollTo(cursor_row_ - height_ + 1);
 }
 
-TextBufferRange* Editor::GetCurrentLine() const {
-  return lines_.GetLine(cursor_row_);
+size_t Editor::FindLineStart(size_t offset) const {
+  if (offset == 0)
+    return 0;
+  size_t line_break = text_->RFind('\n', offset - 1);
+  return line_break == std::string::npos ? 0 : line_break + 1;
+}
+
+size_t Editor::GetCurrentLineEnd() const {
+  return std::min(text_->Find('\n', line_start_), text_->size());
 }
 
 size_t Editor::GetMaxCursorColumn() const {
-  size_t length = GetCurrentLine()->length();
+  size_t length = GetCurrentLineEnd() - line_start_;
   if (length > 0 && cursor_mode_ == CursorMode::Block)
     length -= 1;
   return length;
 }
 
 TextPosition Editor::GetCurrentTextPosition() {
-  return TextPosition(GetCurrentLine()->start() + cursor_col_);
+  return TextPosition(line_start_ + cursor_col_);
+}
+
+void Editor::UpdateLines() {
+  if (!lines_dirty_)
+    return;
+  lines_.UpdateLines(text_.get());
+  lines_dirty_ = false;
 }
 
 void Editor::SetCursorColumn(size_t column) {
@@ -164,4 +407,169 @@ void Editor::SetCursorColumn(size_t column) {
   preferred_cursor_col_ = column;
 }
 
+// Deletes the character before each cursor if |backspace| is true and then
+// inserts |text| at each cursor. The text makes all of the edits in one pass,
+// so the cost depends on the number of cursors and the size of the text but
+// not on how far apart the cursors are.
+bool Editor::EditAtCursors(bool backspace, StringView text) {
+  TRACE_EVENT0("editing", "Editor::EditAtCursors");
+  const size_t position = GetCurrentTextPosition().offset();
+  const size_t line_breaks = std::count(text.begin(), text.end(), '\n');
+  // The edits at or before the cursor move it.
+  size_t new_position = position;
+  size_t new_row = cursor_row_;
+  bool edited = false;
+  auto edit_at = [&](size_t offset) {
+    if (backspace && offset > 0) {
+      if (offset <= position) {
+        --new_position;
+        if (text_->At(offset - 1) == '\n')
+          --new_row;
+      }
+      text_->DeleteRange(TextBufferRange(offset - 1, offset));
+      edited = true;
+    }
+    if (!text.is_empty()) {
+      if (offset <= position) {
+        new_position += text.length();
+        new_row += line_breaks;
+      }
+      text_->InsertText(TextPosition(offset), text);
+      edited = true;
+    }
+  };
+  text_->BeginEdit();
+  edit_at(position);
+  for (TextBufferRange* cursor : extra_cursors_) {
+    if (cursor->start() != position)
+      edit_at(cursor->start());
+  }
+  text_->Commit();
+  if (!edited)
+    return false;
+  RemoveExtraCursors(new_position);
+  cursor_row_ = new_row;
+  line_start_ = FindLineStart(new_position);
+  SetCursorColumn(new_position - line_start_);
+  EnsureCursorVisible();
+  MarkLinesDirty();
+  return true;
+}
+
+// Returns the first extra cursor at or after |offset|.
+std::vector<TextBufferRange*>::iterator Editor::FindExtraCursor(
+    size_t offset) {
+  return std::lower_bound(extra_cursors_.begin(), extra_cursors_.end(),
+                          offset,
+                          [](const TextBufferRange* cursor, size_t offset) {
+                            return cursor->start() < offset;
+                          });
+}
+
+// Removes the extra cursors at |offset| and all but one of the extra cursors
+// that ran into each other.
+void Editor::RemoveExtraCursors(size_t offset) {
+  merged_cursors_.clear();
+  size_t previous = std::string::npos;
+  auto out = extra_cursors_.begin();
+  for (TextBufferRange* cursor : extra_cursors_) {
+    if (cursor->start() == offset || cursor->start() == previous) {
+      merged_cursors_.push_back(cursor);
+      continue;
+    }
+    previous = cursor->start();
+    *out++ = cursor;
+  }
+  extra_cursors_.erase(out, extra_cursors_.end());
+  if (merged_cursors_.empty())
+    return;
+  text_->RemoveRanges(merged_cursors_.begin(), merged_cursors_.end());
+  for (TextBufferRange* cursor : merged_cursors_)
+    cursor_ranges_.Delete(cursor);
+}
+
+// The terminal shows the cursor itself, so the extra cursors are painted in
+// reverse video.
+void Editor::DisplayExtraCursors(CommandBuffer* commands,
+                                 size_t visible_count) {
+  if (!visible_count)
+    return;
+  size_t line_index = base_line_;
+  const size_t end_index = base_line_ + visible_count;
+  auto it = FindExtraCursor(lines_.GetLine(line_index)->start());
+  for (; it != extra_cursors_.end(); ++it) {
+    const size_t offset = (*it)->start();
+    while (line_index < end_index &&
+           offset > lines_.GetLine(line_index)->end())
+      ++line_index;
+    if (line_index == end_index)
+      break;
+    const TextBufferRange* line = lines_.GetLine(line_index);
+    const size_t col = offset - line->start();
+    if (col >= width_)
+      continue;
+    const char c = offset < line->end() ? text_->At(offset) : ' ';
+    commands->MoveCursorTo(col, line_index - base_line_);
+    *commands << term::kSetReverseVideo;
+    commands->Write(&c, 1);
+    *commands << term::kClearCharacterAttributes;
+  }
+}
+
+// Reindexes the lines because the text changed in ways the cursor did not
+// follow.
+void Editor::MoveCursorToIndentation(size_t line) {
+  MarkLinesDirty();
+  if (!MoveCursorToLine(line))
+    return;
+  const size_t line_end = GetCurrentLineEnd();
+  size_t offset = line_start_;
+  while (offset < line_end &&
+         (text_->At(offset) == ' ' || text_->At(offset) == '\t'))
+    ++offset;
+  SetCursorColumn(std::min(offset - line_start_, GetMaxCursorColumn()));
+}
+
+// Unlike MoveCursorToOffset(), this counts the line breaks between the cursor
+// and |offset| rather than reindexing the lines, and it never looks past
+// |offset| for the end of its line.
+bool Editor::MoveCursorWithinText(size_t offset) {
+  const size_t size = text_->size();
+  if (!size)
+    return false;
+  const TextView text = text_->GetText();
+  offset = std::min(offset, size - 1);
+  // In block mode, the cursor rests on the last character of a line rather
+  // than on its line break.
+  if (cursor_mode_ == CursorMode::Block && offset > 0 &&
+      text.At(offset) == '\n' && text.At(offset - 1) != '\n')
+    --offset;
+  const size_t position = GetCurrentTextPosition().offset();
+  if (offset == position)
+    return false;
+  const TextView between =
+      text.Slice(std::min(position, offset), std::max(position, offset));
+  const size_t line_breaks =
+      std::count(between.left().begin(), between.left().end(), '\n') +
+      std::count(between.right().begin(), between.right().end(), '\n');
+  if (line_breaks) {
+    cursor_row_ = offset > position ? cursor_row_ + line_breaks
+                                    : cursor_row_ - line_breaks;
+    line_start_ =
+        SkipClassesBackward(text, offset, kBlank | kPunctuation | kWord);
+    EnsureCursorVisible();
+  }
+  SetCursorColumn(offset - line_start_);
+  return true;
+}
+
+void Editor::MoveCursorToOffset(size_t offset) {
+  MarkLinesDirty();
+  UpdateLines();
+  cursor_row_ = lines_.FindLine(offset);
+  line_start_ = lines_.size() ? lines_.GetLine(cursor_row_)->start() : 0;
+  EnsureCursorVisible();
+  SetCursorColumn(std::min(offset - line_start_, GetMaxCursorColumn()));
+}
+
 }  // namespace zi
@@ -18,14 +18,19 @@
 #include <vector>
 
 #include "editing/cursor_mode.h"
+#include "editing/line_sort.h"
 #include "editing/line_tracker.h"
+#include "editing/substitute.h"
 #include "terminal/command_buffer.h"
 #include "text/text_buffer.h"
 #include "text/text_position.h"
+#include "text/text_range.h"
 #include "text/text_buffer_range.h"
+#include "text/text_buffer_range_pool.h"
 #include "zen/macros.h"
 
 namespace zi {
+class UndoHistory;
 
 class Editor {
  public:
@@ -34,6 +39,9 @@ class Editor {
 
   void SetText(std::unique_ptr<TextBuffer> text);
 
+  // Reindexes the lines of the text if it changed. Display does this itself;
+  // callers can use this to do it separately.
+  void UpdateLines();
   void Display(CommandBuffer* commands);
   void UpdateCursor(CommandBuffer* commands);
 
@@ -45,28 +53,107 @@ class Editor {
   size_t width() const { return width_; }
   size_t height() const { return height_; }
 
+  // Adds |text| to the end, e.g., as a file loads. Cheaper than an edit
+  // because the lines before the end stay as they are.
+  void AppendText(StringView text);
+
   void InsertCharacter(char c);
   void InsertLineBreak();
   bool Backspace();
 
+  // Reverts or reapplies a step of |history| and moves the cursor to where
+  // the step starts. Returns false if there is no such step.
+  bool Undo(UndoHistory* history);
+  bool Redo(UndoHistory* history);
+
   void SetCursorMode(CursorMode mode);
 
+  size_t cursor_row() const { return cursor_row_; }
+  size_t cursor_col() const { return cursor_col_; }
+
   bool MoveCursorLeft();
   bool MoveCursorDown();
   bool MoveCursorUp();
   bool MoveCursorRight();
+  // Word and paragraph motions, as in vi's "w", "W", "b", "B", "e", "E", "}"
+  // and "{". They cost as much as the distance they move, however long the
+  // lines are. Each returns false if the cursor cannot move.
+  bool MoveCursorToNextWord();
+  bool MoveCursorToNextBigWord();
+  bool MoveCursorToPreviousWord();
+  bool MoveCursorToPreviousBigWord();
+  bool MoveCursorToWordEnd();
+  bool MoveCursorToBigWordEnd();
+  bool MoveCursorToNextParagraph();
+  bool MoveCursorToPreviousParagraph();
+  // Moves the cursor to the start of the zero-based |line|. Returns false if
+  // the text has no such line.
+  bool MoveCursorToLine(size_t line);
+  size_t GetLineCount();
+  // Returns the text of the zero-based lines [first_line, last_line], along
+  // with the line break after the last one.
+  TextRange GetLineRange(size_t first_line, size_t last_line);
+
+  // Replaces |range| with |text| and moves the cursor to where it starts.
+  void ReplaceText(const TextRange& range, StringView text);
+  // Substitutes |replacement| for |pattern| in the zero-based lines
+  // [first_line, last_line] and moves the cursor to the start of the last line
+  // that changed.
+  Substitution Substitute(size_t first_line,
+                          size_t last_line,
+                          StringView pattern,
+                          StringView replacement,
+                          bool global);
+  // Sorts the zero-based lines [first_line, last_line] and moves the cursor to
+  // the first of them.
+  void SortLines(size_t first_line,
+                 size_t last_line,
+                 const SortOptions& options);
+
+  // These change the zero-based lines [first_line, last_line] in one pass
+  // through the text and move the cursor to the indentation of the first one.
+  void IndentLines(size_t first_line, size_t last_line);
+  void OutdentLines(size_t first_line, size_t last_line);
+  // Returns true if it commented the lines and false if it uncommented them.
+  bool ToggleComment(size_t first_line, size_t last_line, StringView prefix);
+  // Joins the zero-based lines [first_line, last_line] into one, or the line
+  // and the one after it if they are the same, and moves the cursor to the
+  // last join. Returns false if there is nothing to join.
+  bool JoinLines(size_t first_line, size_t last_line);
+
+  // Extra cursors type, break lines and delete along with the cursor, all in
+  // one pass through the text. Leaves an extra cursor where the cursor is and
+  // moves the cursor down a line. Returns false if there is no line below.
+  bool AddCursorBelow();
+  // Returns false if there were no extra cursors.
+  bool ClearExtraCursors();
+  size_t extra_cursor_count() const { return extra_cursors_.size(); }
 
  private:
-  TextBufferRange* GetCurrentLine() const;
+  size_t FindLineStart(size_t offset) const;
+  size_t GetCurrentLineEnd() const;
   size_t GetMaxCursorColumn() const;
   void EnsureCursorVisible();
   TextPosition GetCurrentTextPosition();
-  void UpdateLines();
+  void MarkLinesDirty() { lines_dirty_ = true; }
 
   void SetCursorColumn(size_t column);
+  void MoveCursorToOffset(size_t offset);
+  void MoveCursorToIndentation(size_t line);
+  bool MoveCursorWithinText(size_t offset);
+
+  bool EditAtCursors(bool backspace, StringView text);
+  std::vector<TextBufferRange*>::iterator FindExtraCursor(size_t offset);
+  void RemoveExtraCursors(size_t offset);
+  void DisplayExtraCursors(CommandBuffer* commands, size_t visible_count);
 
   std::unique_ptr<TextBuffer> text_;
+
+  // The line index is only needed for painting. Editing operations keep the
+  // cursor's line start up to date themselves, which lets a long run of edits
+  // (e.g., a macro replay) go by without reindexing the buffer.
   LineTracker lines_;
+  bool lines_dirty_ = true;
 
   size_t width_ = 0;
   size_t height_ = 0;
@@ -78,6 +165,16 @@ class Editor {
   size_t cursor_row_ = 0;
   size_t preferred_cursor_col_ = 0;
 
+  // The offset in |text_| of the first character of the line |cursor_row_|.
+  size_t line_start_ = 0;
+
+  // Empty ranges that |text_| keeps up to date, in order of offset. None of
+  // them is where the cursor is once an edit is done.
+  TextBufferRangePool cursor_ranges_;
+  std::vector<TextBufferRange*> extra_cursors_;
+  // Scratch space for the extra cursors that ran into others.
+  std::vector<TextBufferRange*> merged_cursors_;
+
   DISALLOW_COPY_AND_ASSIGN(Editor);
 };
 
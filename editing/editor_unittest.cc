@@ -0,0 +1,131 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/editor.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+std::unique_ptr<TextBuffer> MakeText(const std::string& text) {
+  return std::unique_ptr<TextBuffer>(
+      new TextBuffer(std::vector<char>(text.begin(), text.end())));
+}
+
+TEST(Editor, MoveCursor) {
+  Editor editor;
+  editor.Resize(80, 24);
+  editor.SetText(MakeText("abc\nde\n\nfghij\n"));
+  EXPECT_FALSE(editor.MoveCursorUp());
+  EXPECT_TRUE(editor.MoveCursorRight());
+  EXPECT_TRUE(editor.MoveCursorRight());
+  EXPECT_FALSE(editor.MoveCursorRight());
+  EXPECT_TRUE(editor.MoveCursorDown());
+  EXPECT_EQ(1u, editor.cursor_row());
+  EXPECT_EQ(1u, editor.cursor_col());
+  EXPECT_TRUE(editor.MoveCursorDown());
+  EXPECT_EQ(0u, editor.cursor_col());
+  EXPECT_TRUE(editor.MoveCursorDown());
+  EXPECT_EQ(3u, editor.cursor_row());
+  EXPECT_EQ(2u, editor.cursor_col());
+  EXPECT_FALSE(editor.MoveCursorDown());
+  EXPECT_TRUE(editor.MoveCursorUp());
+  EXPECT_TRUE(editor.MoveCursorUp());
+  EXPECT_TRUE(editor.MoveCursorUp());
+  EXPECT_EQ(0u, editor.cursor_row());
+  EXPECT_EQ(2u, editor.cursor_col());
+}
+
+TEST(Editor, EditWithoutDisplay) {
+  Editor editor;
+  editor.Resize(80, 24);
+  editor.SetText(MakeText("abc\ndef"));
+  EXPECT_TRUE(editor.MoveCursorDown());
+  editor.InsertCharacter('x');
+  editor.InsertLineBreak();
+  editor.InsertCharacter('y');
+  EXPECT_EQ("abc\nx\nydef", editor.text()->ToString());
+  EXPECT_EQ(2u, editor.cursor_row());
+  EXPECT_EQ(1u, editor.cursor_col());
+  EXPECT_TRUE(editor.Backspace());
+  EXPECT_TRUE(editor.Backspace());
+  EXPECT_EQ(1u, editor.cursor_row());
+  EXPECT_EQ(1u, editor.cursor_col());
+  EXPECT_TRUE(editor.MoveCursorUp());
+  editor.InsertCharacter('z');
+  EXPECT_EQ("azbc\nxdef", editor.text()->ToString());
+}
+
+TEST(Editor, ExtraCursors) {
+  Editor editor;
+  editor.Resize(80, 24);
+  editor.SetText(MakeText("abc\nde\n\nfghij\n"));
+  EXPECT_TRUE(editor.MoveCursorRight());
+  EXPECT_TRUE(editor.AddCursorBelow());
+  EXPECT_TRUE(editor.AddCursorBelow());
+  EXPECT_TRUE(editor.AddCursorBelow());
+  EXPECT_FALSE(editor.AddCursorBelow());
+  EXPECT_EQ(3u, editor.extra_cursor_count());
+  EXPECT_EQ(3u, editor.cursor_row());
+
+  editor.InsertCharacter('x');
+  EXPECT_EQ("axbc\ndxe\nx\nfxghij\n", editor.text()->ToString());
+  EXPECT_EQ(3u, editor.cursor_row());
+  EXPECT_EQ(2u, editor.cursor_col());
+  editor.InsertLineBreak();
+  EXPECT_EQ("ax\nbc\ndx\ne\nx\n\nfx\nghij\n", editor.text()->ToString());
+  EXPECT_EQ(7u, editor.cursor_row());
+  EXPECT_EQ(0u, editor.cursor_col());
+  EXPECT_TRUE(editor.Backspace());
+  EXPECT_TRUE(editor.Backspace());
+  EXPECT_EQ("abc\nde\n\nfghij\n", editor.text()->ToString());
+  EXPECT_EQ(3u, editor.cursor_row());
+  EXPECT_EQ(1u, editor.cursor_col());
+
+  // Cursors that run into each other merge, and the first cursor has nothing
+  // to delete.
+  EXPECT_TRUE(editor.Backspace());
+  EXPECT_EQ("bc\ne\nghij\n", editor.text()->ToString());
+  EXPECT_EQ(3u, editor.extra_cursor_count());
+  EXPECT_EQ(2u, editor.cursor_row());
+  EXPECT_TRUE(editor.Backspace());
+  EXPECT_EQ("bcghij\n", editor.text()->ToString());
+  EXPECT_EQ(1u, editor.extra_cursor_count());
+  EXPECT_EQ(0u, editor.cursor_row());
+  EXPECT_EQ(2u, editor.cursor_col());
+  editor.InsertCharacter('-');
+  EXPECT_EQ("-bc-ghij\n", editor.text()->ToString());
+
+  EXPECT_TRUE(editor.ClearExtraCursors());
+  EXPECT_FALSE(editor.ClearExtraCursors());
+  editor.InsertCharacter('+');
+  EXPECT_EQ("-bc-+ghij\n", editor.text()->ToString());
+}
+
+TEST(Editor, EmptyText) {
+  Editor editor;
+  EXPECT_FALSE(editor.MoveCursorDown());
+  EXPECT_FALSE(editor.Backspace());
+  editor.InsertCharacter('a');
+  EXPECT_EQ("a", editor.text()->ToString());
+}
+
+}  // namespace
+}  // namespace zi
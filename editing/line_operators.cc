@@ -0,0 +1,174 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/line_operators.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "text/text_buffer.h"
+#include "text/text_view.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+namespace {
+
+bool IsBlank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+// Returns where the line that starts at |offset| ends, before its line break.
+size_t FindLineEnd(const TextView& view, size_t offset) {
+  const size_t line_end = view.Find('\n', offset);
+  return line_end == std::string::npos ? view.length() : line_end;
+}
+
+// Calls |visit| with where each line that starts in [begin, end) starts and
+// ends.
+template <typename Visitor>
+void ForEachLine(const TextView& view,
+                 size_t begin,
+                 size_t end,
+                 Visitor visit) {
+  size_t offset = begin;
+  while (offset < end) {
+    const size_t line_end = FindLineEnd(view, offset);
+    visit(offset, line_end);
+    offset = line_end + 1;
+  }
+}
+
+// Returns where the indentation of the line in [offset, line_end) ends.
+size_t SkipBlanks(const TextView& view, size_t offset, size_t line_end) {
+  while (offset < line_end && IsBlank(view.At(offset)))
+    ++offset;
+  return offset;
+}
+
+bool HasPrefix(const TextView& view, size_t offset, StringView prefix) {
+  if (offset + prefix.length() > view.length())
+    return false;
+  for (char c : prefix) {
+    if (view.At(offset++) != c)
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+void IndentLines(TextBuffer* text, size_t begin, size_t end, size_t width) {
+  TRACE_EVENT0("editing", "IndentLines");
+  const std::string indent(width, ' ');
+  text->BeginEdit();
+  ForEachLine(text->GetText(), begin, end,
+              [text, &indent](size_t offset, size_t line_end) {
+                if (line_end > offset)
+                  text->InsertText(TextPosition(offset), StringView(indent));
+              });
+  text->Commit();
+}
+
+void OutdentLines(TextBuffer* text, size_t begin, size_t end, size_t width) {
+  TRACE_EVENT0("editing", "OutdentLines");
+  text->BeginEdit();
+  const TextView view = text->GetText();
+  ForEachLine(view, begin, end, [text, &view, width](size_t offset,
+                                                     size_t line_end) {
+    size_t outdent_end = offset;
+    if (offset < line_end && view.At(offset) == '\t') {
+      outdent_end = offset + 1;
+    } else {
+      while (outdent_end < std::min(line_end, offset + width) &&
+             view.At(outdent_end) == ' ')
+        ++outdent_end;
+    }
+    if (outdent_end > offset)
+      text->DeleteRange(TextBufferRange(offset, outdent_end));
+  });
+  text->Commit();
+}
+
+bool ToggleComment(TextBuffer* text,
+                   size_t begin,
+                   size_t end,
+                   StringView prefix) {
+  TRACE_EVENT0("editing", "ToggleComment");
+  text->BeginEdit();
+  const TextView view = text->GetText();
+  // Where each line that is not blank starts and where its indentation ends.
+  std::vector<std::pair<size_t, size_t>> lines;
+  size_t indent = std::string::npos;
+  bool commented = true;
+  ForEachLine(view, begin, end, [&](size_t offset, size_t line_end) {
+    const size_t text_start = SkipBlanks(view, offset, line_end);
+    if (text_start == line_end)
+      return;
+    lines.emplace_back(offset, text_start);
+    indent = std::min(indent, text_start - offset);
+    if (commented && !HasPrefix(view, text_start, prefix))
+      commented = false;
+  });
+  const std::string space = " ";
+  const std::string comment = prefix.ToString() + space;
+  for (const auto& line : lines) {
+    if (!commented) {
+      text->InsertText(TextPosition(line.first + indent), StringView(comment));
+      continue;
+    }
+    size_t comment_end = line.second + prefix.length();
+    if (HasPrefix(view, comment_end, StringView(space)))
+      ++comment_end;
+    text->DeleteRange(TextBufferRange(line.second, comment_end));
+  }
+  text->Commit();
+  return !commented;
+}
+
+size_t JoinLines(TextBuffer* text, size_t begin, size_t end) {
+  TRACE_EVENT0("editing", "JoinLines");
+  text->BeginEdit();
+  const TextView view = text->GetText();
+  const std::string space = " ";
+  // How much the joins so far have shortened the text.
+  size_t removed = 0;
+  size_t last_join = begin;
+  size_t line_break = view.Find('\n', begin);
+  // Whether the line joined so far is still empty, in which case the next
+  // line is joined without a space, as in vi.
+  bool joined_empty = line_break != std::string::npos &&
+                      (line_break == 0 || view.At(line_break - 1) == '\n');
+  while (line_break != std::string::npos && line_break < end) {
+    const size_t next_line_end = FindLineEnd(view, line_break + 1);
+    const size_t text_start = SkipBlanks(view, line_break + 1, next_line_end);
+    const bool needs_space =
+        !joined_empty && text_start != next_line_end &&
+        view.At(text_start) != ')' &&
+        !(line_break > begin && IsBlank(view.At(line_break - 1)));
+    joined_empty = joined_empty && text_start == next_line_end;
+    const StringView separator =
+        needs_space ? StringView(space) : StringView();
+    text->ReplaceRange(TextBufferRange(line_break, text_start), separator);
+    last_join = line_break - removed;
+    removed += text_start - line_break - separator.length();
+    line_break = next_line_end == view.length() ? std::string::npos
+                                                : next_line_end;
+  }
+  text->Commit();
+  return last_join;
+}
+
+}  // namespace zi
@@ -0,0 +1,48 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+
+#include "zen/string_view.h"
+
+namespace zi {
+class TextBuffer;
+
+// These edit the lines of |text| that start in [begin, end). Each finds its
+// edits in one pass over the lines and makes them in one transaction, so
+// changing every line of a file costs about as much as copying it once.
+
+// Inserts |width| spaces at the start of each line that is not empty.
+void IndentLines(TextBuffer* text, size_t begin, size_t end, size_t width);
+
+// Deletes a leading tab, or up to |width| leading spaces, from each line.
+void OutdentLines(TextBuffer* text, size_t begin, size_t end, size_t width);
+
+// Comments out the lines with |prefix| and a space, lined up with the least
+// indented line, unless every line that is not blank is already commented out,
+// in which case it uncomments them. Returns true if it commented the lines.
+bool ToggleComment(TextBuffer* text,
+                   size_t begin,
+                   size_t end,
+                   StringView prefix);
+
+// Joins each line break in [begin, end) to the line after it, replacing the
+// break and the indentation after it with a space. There is no space before
+// an empty line or a ')' or after a line that ends with whitespace. Returns
+// where the last join is in the joined text.
+size_t JoinLines(TextBuffer* text, size_t begin, size_t end);
+
+}  // namespace zi
@@ -0,0 +1,62 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/line_operators.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "text/text_buffer.h"
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Indents and then outdents |arg| lines of 63 characters.
+void LineOperators_IndentOutdent(BenchmarkState* state) {
+  const size_t size = state->arg() * 64;
+  std::vector<char> contents(size, 'a');
+  for (size_t i = 63; i < size; i += 64)
+    contents[i] = '\n';
+  std::unique_ptr<TextBuffer> text(new TextBuffer(contents));
+  while (state->KeepRunning()) {
+    IndentLines(text.get(), 0, text->size(), 2);
+    OutdentLines(text.get(), 0, text->size(), 2);
+  }
+  state->SetBytesProcessed(state->iterations() * size * 2);
+}
+BENCHMARK(LineOperators_IndentOutdent, 1000, 100000);
+
+// Joins |arg| lines of 63 characters into one.
+void LineOperators_Join(BenchmarkState* state) {
+  const size_t size = state->arg() * 64;
+  std::vector<char> contents(size, 'a');
+  for (size_t i = 63; i < size; i += 64)
+    contents[i] = '\n';
+  while (state->KeepRunning()) {
+    state->PauseTiming();
+    std::unique_ptr<TextBuffer> text(new TextBuffer(contents));
+    state->ResumeTiming();
+    JoinLines(text.get(), 0, text->size() - 1);
+    state->PauseTiming();
+    text.reset();
+    state->ResumeTiming();
+  }
+  state->SetBytesProcessed(state->iterations() * size);
+}
+BENCHMARK(LineOperators_Join, 1000, 100000);
+
+}  // namespace
+}  // namespace zi
@@ -0,0 +1,92 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/line_operators.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "text/text_buffer.h"
+
+namespace zi {
+namespace {
+
+std::unique_ptr<TextBuffer> MakeBuffer(const std::string& text) {
+  return std::unique_ptr<TextBuffer>(
+      new TextBuffer(std::vector<char>(text.begin(), text.end())));
+}
+
+TEST(LineOperators, Indent) {
+  std::unique_ptr<TextBuffer> text = MakeBuffer("a\n\n b\nc\n");
+  // Empty lines stay empty, and the lines that start past the end are left
+  // alone.
+  IndentLines(text.get(), 0, 6, 2);
+  EXPECT_EQ("  a\n\n   b\nc\n", text->ToString());
+}
+
+TEST(LineOperators, Outdent) {
+  std::unique_ptr<TextBuffer> text = MakeBuffer("   a\n\tb\n c\nd\n \n");
+  OutdentLines(text.get(), 0, text->size(), 2);
+  EXPECT_EQ(" a\nb\nc\nd\n\n", text->ToString());
+}
+
+TEST(LineOperators, ToggleComment) {
+  std::unique_ptr<TextBuffer> text = MakeBuffer("  a\n\n    b\n");
+  EXPECT_TRUE(ToggleComment(text.get(), 0, text->size(),
+                            StringView(std::string("//"))));
+  EXPECT_EQ("  // a\n\n  //   b\n", text->ToString());
+  EXPECT_FALSE(ToggleComment(text.get(), 0, text->size(),
+                             StringView(std::string("//"))));
+  EXPECT_EQ("  a\n\n    b\n", text->ToString());
+
+  // Lines that are only partly commented out get commented out again.
+  text = MakeBuffer("#a\nb\n");
+  EXPECT_TRUE(ToggleComment(text.get(), 0, text->size(),
+                            StringView(std::string("#"))));
+  EXPECT_EQ("# #a\n# b\n", text->ToString());
+}
+
+TEST(LineOperators, Join) {
+  std::unique_ptr<TextBuffer> text =
+      MakeBuffer("a\n   b\n\nc \nd\n)\ne\nf\n");
+  // Joins the breaks after "a" through ")", but not the one after it.
+  EXPECT_EQ(7u, JoinLines(text.get(), 0, 14));
+  EXPECT_EQ("a b c d)\ne\nf\n", text->ToString());
+  EXPECT_EQ(0u, JoinLines(text.get(), 0, 0));
+  EXPECT_EQ(12u, JoinLines(text.get(), 9, text->size()));
+  EXPECT_EQ("a b c d)\ne f", text->ToString());
+}
+
+TEST(LineOperators, JoinEmptyLine) {
+  std::unique_ptr<TextBuffer> text = MakeBuffer("\nfoo\n");
+  EXPECT_EQ(0u, JoinLines(text.get(), 0, 1));
+  EXPECT_EQ("foo\n", text->ToString());
+  text = MakeBuffer("a\n\n\n  b\nc\n");
+  EXPECT_EQ(3u, JoinLines(text.get(), 2, 8));
+  EXPECT_EQ("a\nb c\n", text->ToString());
+}
+
+TEST(LineOperators, AcrossTheGap) {
+  std::unique_ptr<TextBuffer> text = MakeBuffer("a\nb\nc\n");
+  text->InsertCharacter(TextPosition(3), 'x');
+  IndentLines(text.get(), 0, text->size(), 1);
+  EXPECT_EQ(" a\n bx\n c\n", text->ToString());
+  EXPECT_EQ(5u, JoinLines(text.get(), 0, text->size() - 1));
+  EXPECT_EQ(" a bx c\n", text->ToString());
+}
+
+}  // namespace
+}  // namespace zi
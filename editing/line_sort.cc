@@ -0,0 +1,221 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/line_sort.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "zen/trace_event.h"
+
+namespace zi {
+namespace {
+
+// Below this many lines, starting threads costs more than it saves.
+constexpr size_t kMinLinesPerThread = 1 << 15;
+constexpr size_t kMaxThreads = 8;
+
+// A line and what it sorts by. The first bytes of the line, packed so that
+// comparing the integers compares the bytes, settle most comparisons without
+// touching the text.
+struct Line {
+  uint64_t key;
+  const char* data;
+  size_t length;
+  size_t index;
+  bool has_number;
+};
+
+uint64_t GetPrefix(const char* data, size_t length) {
+  uint64_t prefix = 0;
+  const size_t count = std::min<size_t>(length, 8);
+  for (size_t i = 0; i < count; ++i)
+    prefix |= uint64_t(static_cast<unsigned char>(data[i])) << (56 - 8 * i);
+  return prefix;
+}
+
+// Maps the first decimal number in the line, along with a minus sign before
+// it, to an unsigned integer that sorts the same way.
+bool GetNumber(const char* data, size_t length, uint64_t* key) {
+  const char* end = data + length;
+  const char* digit = std::find_if(
+      data, end, [](char c) { return c >= '0' && c <= '9'; });
+  if (digit == end)
+    return false;
+  const bool negative = digit > data && digit[-1] == '-';
+  uint64_t value = 0;
+  for (; digit != end && *digit >= '0' && *digit <= '9'; ++digit) {
+    value = value > INT64_MAX / 10
+                ? INT64_MAX
+                : std::min<uint64_t>(value * 10 + (*digit - '0'), INT64_MAX);
+  }
+  const uint64_t zero = uint64_t(1) << 63;
+  *key = negative ? zero - value : zero + value;
+  return true;
+}
+
+// Returns a negative number, zero or a positive number as |lhs| sorts before,
+// with or after |rhs|, not counting their original order.
+int Compare(const Line& lhs, const Line& rhs, bool numeric) {
+  if (numeric) {
+    if (lhs.has_number != rhs.has_number)
+      return lhs.has_number ? 1 : -1;
+    if (!lhs.has_number)
+      return 0;
+    if (lhs.key != rhs.key)
+      return lhs.key < rhs.key ? -1 : 1;
+    return 0;
+  }
+  if (lhs.key != rhs.key)
+    return lhs.key < rhs.key ? -1 : 1;
+  const size_t length = std::min(lhs.length, rhs.length);
+  if (length > 8) {
+    const int result = memcmp(lhs.data + 8, rhs.data + 8, length - 8);
+    if (result)
+      return result;
+  }
+  if (lhs.length != rhs.length)
+    return lhs.length < rhs.length ? -1 : 1;
+  return 0;
+}
+
+class LineLess {
+ public:
+  explicit LineLess(const SortOptions& options) : options_(options) {}
+
+  bool operator()(const Line& lhs, const Line& rhs) const {
+    const int result = Compare(lhs, rhs, options_.numeric);
+    if (result)
+      return options_.reverse ? result > 0 : result < 0;
+    return lhs.index < rhs.index;
+  }
+
+ private:
+  const SortOptions& options_;
+};
+
+// Sorts |lines| in |thread_count| pieces at once and then merges the pieces
+// in pairs, also at once, until one is left.
+void ParallelSort(std::vector<Line>* lines,
+                  size_t thread_count,
+                  const LineLess& less) {
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i <= thread_count; ++i)
+    bounds.push_back(lines->size() * i / thread_count);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back([lines, &bounds, &less, i]() {
+      std::sort(lines->begin() + bounds[i], lines->begin() + bounds[i + 1],
+                less);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  std::vector<Line> merged(lines->size());
+  while (bounds.size() > 2) {
+    threads.clear();
+    std::vector<size_t> merged_bounds;
+    for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+      merged_bounds.push_back(bounds[i]);
+      const size_t begin = bounds[i];
+      const size_t middle = bounds[i + 1];
+      const size_t end = i + 2 < bounds.size() ? bounds[i + 2] : middle;
+      threads.emplace_back([lines, &merged, &less, begin, middle, end]() {
+        std::merge(lines->begin() + begin, lines->begin() + middle,
+                   lines->begin() + middle, lines->begin() + end,
+                   merged.begin() + begin, less);
+      });
+    }
+    merged_bounds.push_back(lines->size());
+    for (auto& thread : threads)
+      thread.join();
+    lines->swap(merged);
+    bounds.swap(merged_bounds);
+  }
+}
+
+}  // namespace
+
+std::vector<char> SortLines(const TextView& text, const SortOptions& options) {
+  TRACE_EVENT0("editing", "SortLines");
+  std::vector<Line> lines;
+  // The line that straddles the two halves of |text|, if any, is copied so
+  // that every line is contiguous.
+  std::string straddling;
+  const size_t length = text.length();
+  const size_t left_length = text.left().length();
+  auto add_line = [&](size_t begin, size_t end) {
+    Line line;
+    if (end <= left_length) {
+      line.data = text.left().data() + begin;
+    } else if (begin >= left_length) {
+      line.data = text.right().data() + (begin - left_length);
+    } else {
+      straddling = text.Slice(begin, end).ToString();
+      line.data = straddling.data();
+    }
+    line.length = end - begin;
+    line.index = lines.size();
+    line.has_number = false;
+    if (options.numeric)
+      line.has_number = GetNumber(line.data, line.length, &line.key);
+    else
+      line.key = GetPrefix(line.data, line.length);
+    lines.push_back(line);
+  };
+  size_t begin = 0;
+  while (begin < length) {
+    size_t end = text.Find('\n', begin);
+    if (end == std::string::npos)
+      end = length;
+    add_line(begin, end);
+    begin = end + 1;
+  }
+
+  const LineLess less(options);
+  const size_t thread_count =
+      std::min({kMaxThreads, lines.size() / kMinLinesPerThread,
+                size_t(std::max(std::thread::hardware_concurrency(), 1u))});
+  if (thread_count > 1)
+    ParallelSort(&lines, thread_count, less);
+  else
+    std::sort(lines.begin(), lines.end(), less);
+  if (options.unique) {
+    lines.erase(std::unique(lines.begin(), lines.end(),
+                            [&options](const Line& lhs, const Line& rhs) {
+                              return Compare(lhs, rhs, options.numeric) == 0;
+                            }),
+                lines.end());
+  }
+
+  std::vector<char> result;
+  result.reserve(length);
+  for (const Line& line : lines) {
+    result.insert(result.end(), line.data, line.data + line.length);
+    result.push_back('\n');
+  }
+  const bool ends_with_line_break =
+      length && text.Slice(length - 1, length).ToString() == "\n";
+  if (!result.empty() && !ends_with_line_break)
+    result.pop_back();
+  return result;
+}
+
+}  // namespace zi
@@ -0,0 +1,37 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <vector>
+
+#include "text/text_view.h"
+
+namespace zi {
+
+struct SortOptions {
+  // Keeps only the first of each run of lines that sort as equal.
+  bool unique = false;
+  // Sorts by the first decimal number in each line. Lines without one sort
+  // first, in their original order.
+  bool numeric = false;
+  bool reverse = false;
+};
+
+// Returns the lines of |text| in sorted order. Lines that sort as equal keep
+// their order. The result ends with a line break if |text| does. Large inputs
+// are sorted on several threads.
+std::vector<char> SortLines(const TextView& text, const SortOptions& options);
+
+}  // namespace zi
@@ -0,0 +1,45 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/line_sort.h"
+
+#include <random>
+#include <vector>
+
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Sorts |arg| lines of random letters, between 1 and 63 long.
+void SortLines_Random(BenchmarkState* state) {
+  std::mt19937 random(0);
+  std::vector<char> contents;
+  for (size_t i = 0; i < state->arg(); ++i) {
+    const size_t length = 1 + random() % 63;
+    for (size_t j = 0; j < length; ++j)
+      contents.push_back('a' + random() % 26);
+    contents.push_back('\n');
+  }
+  const TextView text(StringView(contents.data(),
+                                 contents.data() + contents.size()));
+  const SortOptions options;
+  while (state->KeepRunning())
+    SortLines(text, options);
+  state->SetBytesProcessed(state->iterations() * contents.size());
+}
+BENCHMARK(SortLines_Random, 1000, 1000000);
+
+}  // namespace
+}  // namespace zi
@@ -0,0 +1,93 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/line_sort.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+std::string Sort(const TextView& text, const SortOptions& options) {
+  const std::vector<char> sorted = SortLines(text, options);
+  return std::string(sorted.begin(), sorted.end());
+}
+
+std::string Sort(const std::string& text, const SortOptions& options) {
+  return Sort(TextView(text), options);
+}
+
+TEST(SortLines, Bytes) {
+  SortOptions options;
+  EXPECT_EQ("", Sort("", options));
+  EXPECT_EQ("a\nab\nabcdefghij\nabcdefghik\nb\n",
+            Sort("b\nabcdefghik\nab\nabcdefghij\na\n", options));
+  // The last line gets a line break when it moves, and the line that takes
+  // its place loses one.
+  EXPECT_EQ("\n\na\nb", Sort("b\n\n\na", options));
+  EXPECT_EQ("A\nB\na\n\xff\n", Sort("\xff\na\nB\nA\n", options));
+}
+
+TEST(SortLines, Reverse) {
+  SortOptions options;
+  options.reverse = true;
+  EXPECT_EQ("c\nb\na\n", Sort("b\nc\na\n", options));
+}
+
+TEST(SortLines, Numeric) {
+  SortOptions options;
+  options.numeric = true;
+  // Lines without a number keep their order, ahead of the rest, and so do
+  // lines with the same number.
+  EXPECT_EQ("y\nx\nw\n-20 b\nv-3\n-0\n0 a\nt9\n10\n",
+            Sort("10\ny\nt9\n-20 b\n-0\n0 a\nx\nv-3\nw\n", options));
+}
+
+TEST(SortLines, Unique) {
+  SortOptions options;
+  options.unique = true;
+  EXPECT_EQ("a\nb\nc\n", Sort("c\na\nb\na\nc\nc\n", options));
+  options.numeric = true;
+  EXPECT_EQ("x1\ny2\n", Sort("y2\nx1\nz2\nw1\n", options));
+}
+
+TEST(SortLines, AcrossTheGap) {
+  SortOptions options;
+  std::string left = "c\nbb";
+  std::string right = "b\na\n";
+  EXPECT_EQ("a\nbbb\nc\n",
+            Sort(TextView(StringView(left), StringView(right)), options));
+}
+
+TEST(SortLines, ManyLines) {
+  // Enough lines to sort on several threads.
+  std::string text;
+  std::string expected;
+  const size_t line_count = 200000;
+  for (size_t i = 0; i < line_count; ++i) {
+    const std::string line = std::to_string(i * 7919 % line_count);
+    text += line + "\n";
+  }
+  for (size_t i = 0; i < line_count; ++i)
+    expected += std::to_string(i) + "\n";
+  SortOptions options;
+  options.numeric = true;
+  EXPECT_EQ(expected, Sort(text, options));
+}
+
+}  // namespace
+}  // namespace zi
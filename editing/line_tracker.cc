@@ -14,6 +14,10 @@
 
 #include "editing/line_tracker.h"
 
+#include <algorithm>
+
+#include "zen/trace_event.h"
+
 namespace zi {
 
 LineTracker::LineTracker() {}
@@ -22,24 +26,14 @@ LineTracker::~LineTracker() {}
 
 void LineTracker::Clear() {
   lines_.clear();
+  ranges_.Clear();
 }
 
 void LineTracker::UpdateLines(TextBuffer* text) {
+  TRACE_EVENT0("editing", "LineTracker::UpdateLines");
   Clear();
   if (lines_.empty()) {
-    size_t offset = 0;
-    const size_t text_size = text->size();
-    while (offset < text_size) {
-      size_t end = text->Find('\n', offset);
-      std::unique_ptr<TextBufferRange> line;
-      if (end == std::string::npos) {
-        if (offset < text_size)
-          lines_.emplace_back(new TextBufferRange(offset, text_size));
-        return;
-      }
-      lines_.emplace_back(new TextBufferRange(offset, end));
-      offset = end + 1;
-    }
+    AddLinesFrom(text, 0);
     // } else {
     //   std::vector<std::unique_ptr<TextBufferRange>> updated_lines;
     //   updated_lines.reserve(lines_.size());
@@ -60,8 +54,47 @@ void LineTracker::UpdateLines(TextBuffer* text) {
   }
 }
 
+void LineTracker::ExtendLines(TextBuffer* text) {
+  TRACE_EVENT0("editing", "LineTracker::ExtendLines");
+  size_t offset = 0;
+  if (!lines_.empty()) {
+    TextBufferRange* last = lines_.back();
+    if (last->end() < text->size() && text->At(last->end()) == '\n') {
+      offset = last->end() + 1;
+    } else {
+      // The text used to end in the middle of this line.
+      offset = last->start();
+      lines_.pop_back();
+      ranges_.Delete(last);
+    }
+  }
+  AddLinesFrom(text, offset);
+}
+
 TextBufferRange* LineTracker::GetLine(size_t line_index) const {
-  return lines_[line_index].get();
+  return lines_[line_index];
+}
+
+size_t LineTracker::FindLine(size_t offset) const {
+  auto it = std::upper_bound(
+      lines_.begin(), lines_.end(), offset,
+      [](size_t offset, const TextBufferRange* line) {
+        return offset < line->start();
+      });
+  return it == lines_.begin() ? 0 : it - lines_.begin() - 1;
+}
+
+void LineTracker::AddLinesFrom(TextBuffer* text, size_t offset) {
+  const size_t text_size = text->size();
+  while (offset < text_size) {
+    size_t end = text->Find('\n', offset);
+    if (end == std::string::npos) {
+      lines_.push_back(ranges_.New(offset, text_size));
+      return;
+    }
+    lines_.push_back(ranges_.New(offset, end));
+    offset = end + 1;
+  }
 }
 
 }  // namespace zi
@@ -14,11 +14,11 @@
 
 #pragma once
 
-#include <memory>
 #include <vector>
 
 #include "text/text_buffer.h"
 #include "text/text_buffer_range.h"
+#include "text/text_buffer_range_pool.h"
 #include "zen/macros.h"
 
 namespace zi {
@@ -30,12 +30,23 @@ class LineTracker {
 
   void Clear();
   void UpdateLines(TextBuffer* text);
+  // Indexes text appended since the last update, assuming nothing before it
+  // changed.
+  void ExtendLines(TextBuffer* text);
   TextBufferRange* GetLine(size_t line_index) const;
+  // Returns the index of the last line that starts at or before |offset|, or
+  // zero if there are no lines.
+  size_t FindLine(size_t offset) const;
 
   size_t size() const { return lines_.size(); }
 
  private:
-  std::vector<std::unique_ptr<TextBufferRange>> lines_;
+  void AddLinesFrom(TextBuffer* text, size_t offset);
+
+  // Reindexing clears both of these but keeps their storage, so it only
+  // allocates when the text has more lines than ever before.
+  TextBufferRangePool ranges_;
+  std::vector<TextBufferRange*> lines_;
 
   DISALLOW_COPY_AND_ASSIGN(LineTracker);
 };
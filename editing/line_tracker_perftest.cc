@@ -0,0 +1,40 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/line_tracker.h"
+
+#include <string>
+#include <vector>
+
+#include "text/text_buffer.h"
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Indexes a buffer with |arg| lines of 63 characters.
+void LineTracker_UpdateLines(BenchmarkState* state) {
+  std::vector<char> contents(state->arg() * 64, 'a');
+  for (size_t i = 63; i < contents.size(); i += 64)
+    contents[i] = '\n';
+  TextBuffer text(std::move(contents));
+  LineTracker lines;
+  while (state->KeepRunning())
+    lines.UpdateLines(&text);
+  state->SetItemsProcessed(state->iterations() * state->arg());
+}
+BENCHMARK(LineTracker_UpdateLines, 1000, 100000, 1000000);
+
+}  // namespace
+}  // namespace zi
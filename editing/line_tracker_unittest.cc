@@ -17,11 +17,42 @@
 #include <string>
 
 #include "gtest/gtest.h"
+#include "text/text_buffer.h"
 
 namespace zi {
 namespace {
 
 TEST(LineTracker, Control) {}
 
+std::string GetLineText(const TextBuffer& text, const LineTracker& lines,
+                        size_t index) {
+  return text.GetTextForRange(lines.GetLine(index)).ToString();
+}
+
+TEST(LineTracker, ExtendLines) {
+  TextBuffer text;
+  LineTracker lines;
+  text.Append(StringView(std::string("one\ntw")));
+  lines.UpdateLines(&text);
+  ASSERT_EQ(2u, lines.size());
+
+  // The incomplete last line is indexed again.
+  text.Append(StringView(std::string("o\nthree\n")));
+  lines.ExtendLines(&text);
+  ASSERT_EQ(3u, lines.size());
+  EXPECT_EQ("one", GetLineText(text, lines, 0));
+  EXPECT_EQ("two", GetLineText(text, lines, 1));
+  EXPECT_EQ("three", GetLineText(text, lines, 2));
+
+  text.Append(StringView(std::string("four")));
+  lines.ExtendLines(&text);
+  ASSERT_EQ(4u, lines.size());
+  EXPECT_EQ("four", GetLineText(text, lines, 3));
+
+  LineTracker fresh;
+  fresh.UpdateLines(&text);
+  EXPECT_EQ(fresh.size(), lines.size());
+}
+
 }  // namespace
 }  // namespace zi
@@ -0,0 +1,103 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/motions.h"
+
+#include "text/char_class.h"
+
+namespace zi {
+namespace {
+
+constexpr uint8_t kNotLineBreak = kBlank | kPunctuation | kWord;
+
+// Returns the classes that make up the same word as |c|.
+uint8_t GetWordClasses(char c, bool big_word) {
+  return big_word ? kPunctuation | kWord : GetCharClass(c);
+}
+
+// Returns true if |pos| is the line break of an empty line.
+bool IsEmptyLine(const TextView& text, size_t pos) {
+  return text.At(pos) == '\n' && (pos == 0 || text.At(pos - 1) == '\n');
+}
+
+}  // namespace
+
+size_t FindNextWordStart(const TextView& text, size_t pos, bool big_word) {
+  const size_t length = text.length();
+  if (pos >= length)
+    return length;
+  const char c = text.At(pos);
+  if (GetCharClass(c) & (kPunctuation | kWord))
+    pos = SkipClasses(text, pos, GetWordClasses(c, big_word));
+  for (;;) {
+    pos = SkipClasses(text, pos, kBlank);
+    if (pos == length || text.At(pos) != '\n')
+      return pos;
+    ++pos;
+    if (pos < length && text.At(pos) == '\n')
+      return pos;
+  }
+}
+
+size_t FindPreviousWordStart(const TextView& text, size_t pos, bool big_word) {
+  for (;;) {
+    pos = SkipClassesBackward(text, pos, kBlank);
+    if (pos == 0)
+      return 0;
+    if (text.At(pos - 1) != '\n')
+      break;
+    if (IsEmptyLine(text, pos - 1))
+      return pos - 1;
+    --pos;
+  }
+  return SkipClassesBackward(text, pos,
+                             GetWordClasses(text.At(pos - 1), big_word));
+}
+
+size_t FindWordEnd(const TextView& text, size_t pos, bool big_word) {
+  const size_t length = text.length();
+  pos = SkipClasses(text, pos + 1, kBlank | kLineBreak);
+  if (pos >= length)
+    return length;
+  return SkipClasses(text, pos, GetWordClasses(text.At(pos), big_word)) - 1;
+}
+
+size_t FindNextParagraph(const TextView& text, size_t pos) {
+  const size_t length = text.length();
+  if (pos < length && IsEmptyLine(text, pos))
+    pos = SkipClasses(text, pos, kLineBreak);
+  for (;;) {
+    pos = SkipClasses(text, pos, kNotLineBreak);
+    if (pos + 1 >= length)
+      return length;
+    if (text.At(pos + 1) == '\n')
+      return pos + 1;
+    ++pos;
+  }
+}
+
+size_t FindPreviousParagraph(const TextView& text, size_t pos) {
+  if (pos < text.length() && IsEmptyLine(text, pos))
+    pos = SkipClassesBackward(text, pos, kLineBreak);
+  for (;;) {
+    pos = SkipClassesBackward(text, pos, kNotLineBreak);
+    if (pos <= 1)
+      return 0;
+    if (text.At(pos - 2) == '\n')
+      return pos - 1;
+    --pos;
+  }
+}
+
+}  // namespace zi
@@ -0,0 +1,36 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+
+#include "text/text_view.h"
+
+namespace zi {
+
+// These return where a motion from |pos| in |text| leads, or the length of
+// |text| if it runs off the end. A word is a run of letters, digits and '_' or
+// a run of other punctuation or, if |big_word|, a run of anything but
+// whitespace. An empty line counts as a word, except for FindWordEnd().
+size_t FindNextWordStart(const TextView& text, size_t pos, bool big_word);
+size_t FindPreviousWordStart(const TextView& text, size_t pos, bool big_word);
+size_t FindWordEnd(const TextView& text, size_t pos, bool big_word);
+
+// Paragraphs are separated by empty lines. These return where the next or
+// previous empty line starts, or the end or the start of |text|.
+size_t FindNextParagraph(const TextView& text, size_t pos);
+size_t FindPreviousParagraph(const TextView& text, size_t pos);
+
+}  // namespace zi
@@ -0,0 +1,57 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/motions.h"
+
+#include <string>
+
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Moves a word at a time across a line of |arg| bytes of minified code.
+void Motions_NextWord(BenchmarkState* state) {
+  const std::string pattern = "function(a,b){return a.length>b?a:b};";
+  std::string text;
+  while (text.size() < state->arg())
+    text += pattern;
+  const TextView view(text);
+  while (state->KeepRunning()) {
+    size_t pos = 0;
+    while (pos < text.size())
+      pos = FindNextWordStart(view, pos, false);
+  }
+  state->SetBytesProcessed(state->iterations() * text.size());
+}
+BENCHMARK(Motions_NextWord, 1 << 10, 1 << 20);
+
+// Moves a paragraph at a time across |arg| bytes of 80-column lines.
+void Motions_NextParagraph(BenchmarkState* state) {
+  std::string text;
+  while (text.size() < state->arg())
+    text += std::string(79, 'x') + "\n";
+  text += "\n";
+  const TextView view(text);
+  while (state->KeepRunning()) {
+    size_t pos = 0;
+    while (pos < text.size())
+      pos = FindNextParagraph(view, pos);
+  }
+  state->SetBytesProcessed(state->iterations() * text.size());
+}
+BENCHMARK(Motions_NextParagraph, 1 << 10, 1 << 20);
+
+}  // namespace
+}  // namespace zi
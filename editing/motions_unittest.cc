@@ -0,0 +1,96 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/motions.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+TEST(Motions, NextWordStart) {
+  const std::string text = "foo.bar  baz\n\n  (qux)";
+  const TextView view(text);
+  EXPECT_EQ(3u, FindNextWordStart(view, 0, false));
+  EXPECT_EQ(4u, FindNextWordStart(view, 3, false));
+  EXPECT_EQ(9u, FindNextWordStart(view, 4, false));
+  // The empty line counts as a word.
+  EXPECT_EQ(13u, FindNextWordStart(view, 9, false));
+  EXPECT_EQ(16u, FindNextWordStart(view, 13, false));
+  EXPECT_EQ(17u, FindNextWordStart(view, 16, false));
+  EXPECT_EQ(text.size(), FindNextWordStart(view, 20, false));
+
+  EXPECT_EQ(9u, FindNextWordStart(view, 0, true));
+  EXPECT_EQ(text.size(), FindNextWordStart(view, 16, true));
+}
+
+TEST(Motions, PreviousWordStart) {
+  const std::string text = "foo.bar  baz\n\n  (qux)";
+  const TextView view(text);
+  EXPECT_EQ(17u, FindPreviousWordStart(view, 20, false));
+  EXPECT_EQ(16u, FindPreviousWordStart(view, 17, false));
+  EXPECT_EQ(13u, FindPreviousWordStart(view, 16, false));
+  EXPECT_EQ(9u, FindPreviousWordStart(view, 13, false));
+  EXPECT_EQ(4u, FindPreviousWordStart(view, 9, false));
+  EXPECT_EQ(3u, FindPreviousWordStart(view, 4, false));
+  EXPECT_EQ(0u, FindPreviousWordStart(view, 2, false));
+  EXPECT_EQ(0u, FindPreviousWordStart(view, 0, false));
+
+  EXPECT_EQ(16u, FindPreviousWordStart(view, 20, true));
+  EXPECT_EQ(0u, FindPreviousWordStart(view, 9, true));
+}
+
+TEST(Motions, WordEnd) {
+  const std::string text = "foo.bar  baz\n\n  (qux)";
+  const TextView view(text);
+  EXPECT_EQ(2u, FindWordEnd(view, 0, false));
+  EXPECT_EQ(3u, FindWordEnd(view, 2, false));
+  EXPECT_EQ(6u, FindWordEnd(view, 3, false));
+  // Empty lines do not count.
+  EXPECT_EQ(16u, FindWordEnd(view, 11, false));
+  EXPECT_EQ(20u, FindWordEnd(view, 19, false));
+  EXPECT_EQ(text.size(), FindWordEnd(view, 20, false));
+
+  EXPECT_EQ(6u, FindWordEnd(view, 0, true));
+  EXPECT_EQ(20u, FindWordEnd(view, 12, true));
+}
+
+TEST(Motions, Paragraphs) {
+  const std::string text = "a\nb\n\n\nc\n\nd";
+  const TextView view(text);
+  EXPECT_EQ(4u, FindNextParagraph(view, 0));
+  // From an empty line, the next paragraph is past the ones after it.
+  EXPECT_EQ(8u, FindNextParagraph(view, 4));
+  EXPECT_EQ(8u, FindNextParagraph(view, 5));
+  EXPECT_EQ(text.size(), FindNextParagraph(view, 8));
+
+  EXPECT_EQ(8u, FindPreviousParagraph(view, 9));
+  EXPECT_EQ(5u, FindPreviousParagraph(view, 8));
+  EXPECT_EQ(0u, FindPreviousParagraph(view, 5));
+  EXPECT_EQ(0u, FindPreviousParagraph(view, 2));
+}
+
+TEST(Motions, AcrossTheGap) {
+  const std::string left = "one tw";
+  const std::string right = "o three";
+  const TextView view{StringView(left), StringView(right)};
+  EXPECT_EQ(8u, FindNextWordStart(view, 4, false));
+  EXPECT_EQ(4u, FindPreviousWordStart(view, 8, false));
+  EXPECT_EQ(6u, FindWordEnd(view, 4, false));
+}
+
+}  // namespace
+}  // namespace zi
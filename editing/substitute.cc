@@ -0,0 +1,69 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/substitute.h"
+
+#include <string>
+
+#include "text/text_buffer.h"
+#include "text/text_view.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+
+Substitution Substitute(TextBuffer* text,
+                        size_t begin,
+                        size_t end,
+                        StringView pattern,
+                        StringView replacement,
+                        bool global) {
+  TRACE_EVENT0("editing", "Substitute");
+  Substitution result;
+  const size_t length = pattern.length();
+  if (!length)
+    return result;
+  // Reads see the text as it was until the transaction commits.
+  text->BeginEdit();
+  // Searches stop at |end| rather than running on to the end of the text.
+  const TextView range = text->GetText().Slice(begin, end);
+  size_t line_end = 0;
+  size_t last_match = 0;
+  size_t offset = begin;
+  while (offset < end) {
+    size_t match = range.Find(pattern, offset - begin);
+    if (match == std::string::npos)
+      break;
+    match += begin;
+    if (!result.count || match > line_end) {
+      ++result.line_count;
+      line_end = range.Find('\n', match + length - begin);
+      line_end = (line_end == std::string::npos ? range.length() : line_end) +
+                 begin;
+    }
+    text->ReplaceRange(TextBufferRange(match, match + length), replacement);
+    ++result.count;
+    last_match = match;
+    offset = global ? match + length : line_end + 1;
+  }
+  text->Commit();
+  if (result.count) {
+    // Every replacement before the last one changed the length by as much.
+    const size_t earlier = result.count - 1;
+    result.last_offset =
+        last_match + earlier * replacement.length() - earlier * length;
+  }
+  return result;
+}
+
+}  // namespace zi
@@ -0,0 +1,43 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+
+#include "zen/string_view.h"
+
+namespace zi {
+class TextBuffer;
+
+struct Substitution {
+  // How many matches were replaced and on how many lines.
+  size_t count = 0;
+  size_t line_count = 0;
+  // Where the last replacement starts in the substituted text.
+  size_t last_offset = 0;
+};
+
+// Replaces the matches of |pattern| that lie within [begin, end) of |text|
+// with |replacement|, only the first match on each line unless |global|. The
+// matches are found in one pass and replaced in one transaction, so the cost
+// is about that of copying the text once, however many matches there are.
+Substitution Substitute(TextBuffer* text,
+                        size_t begin,
+                        size_t end,
+                        StringView pattern,
+                        StringView replacement,
+                        bool global);
+
+}  // namespace zi
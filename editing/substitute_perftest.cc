@@ -0,0 +1,53 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/substitute.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "text/text_buffer.h"
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Replaces a match on each of |arg| lines of 63 characters with text one byte
+// longer, so the buffer has to grow.
+void Substitute_EveryLine(BenchmarkState* state) {
+  const size_t size = state->arg() * 64;
+  std::vector<char> contents(size, 'a');
+  for (size_t i = 0; i < size; i += 64) {
+    contents[i + 31] = 'x';
+    contents[i + 63] = '\n';
+  }
+  const std::string pattern = "axa";
+  const std::string replacement = "ayya";
+  while (state->KeepRunning()) {
+    state->PauseTiming();
+    std::unique_ptr<TextBuffer> text(new TextBuffer(contents));
+    state->ResumeTiming();
+    Substitute(text.get(), 0, text->size(), StringView(pattern),
+               StringView(replacement), true);
+    state->PauseTiming();
+    text.reset();
+    state->ResumeTiming();
+  }
+  state->SetBytesProcessed(state->iterations() * size);
+}
+BENCHMARK(Substitute_EveryLine, 1000, 1000000);
+
+}  // namespace
+}  // namespace zi
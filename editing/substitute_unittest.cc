@@ -0,0 +1,81 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "editing/substitute.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "text/text_buffer.h"
+
+namespace zi {
+namespace {
+
+std::unique_ptr<TextBuffer> MakeBuffer(const std::string& text) {
+  return std::unique_ptr<TextBuffer>(
+      new TextBuffer(std::vector<char>(text.begin(), text.end())));
+}
+
+TEST(Substitute, FirstMatchOnEachLine) {
+  std::unique_ptr<TextBuffer> text = MakeBuffer("a-a\nb\na-a-a\n");
+  Substitution result = Substitute(text.get(), 0, text->size(),
+                                   StringView(std::string("a")),
+                                   StringView(std::string("xy")), false);
+  EXPECT_EQ("xy-a\nb\nxy-a-a\n", text->ToString());
+  EXPECT_EQ(2u, result.count);
+  EXPECT_EQ(2u, result.line_count);
+  EXPECT_EQ(7u, result.last_offset);
+}
+
+TEST(Substitute, Global) {
+  std::unique_ptr<TextBuffer> text = MakeBuffer("a-a\nb\na-a-a\n");
+  Substitution result = Substitute(text.get(), 0, text->size(),
+                                   StringView(std::string("a-")),
+                                   StringView(), true);
+  EXPECT_EQ("a\nb\na\n", text->ToString());
+  EXPECT_EQ(3u, result.count);
+  EXPECT_EQ(2u, result.line_count);
+  EXPECT_EQ(4u, result.last_offset);
+}
+
+TEST(Substitute, StaysInRange) {
+  std::unique_ptr<TextBuffer> text = MakeBuffer("aa\naa\naa");
+  Substitution result =
+      Substitute(text.get(), 1, 7, StringView(std::string("aa")),
+                 StringView(std::string("b")), true);
+  EXPECT_EQ("aa\nb\naa", text->ToString());
+  EXPECT_EQ(1u, result.count);
+
+  result = Substitute(text.get(), 0, text->size(),
+                      StringView(std::string("c")),
+                      StringView(std::string("d")), true);
+  EXPECT_EQ(0u, result.count);
+  EXPECT_EQ(0u, result.line_count);
+}
+
+TEST(Substitute, MatchesAcrossTheGap) {
+  std::unique_ptr<TextBuffer> text = MakeBuffer("one two");
+  text->InsertCharacter(TextPosition(5), 'X');
+  text->DeleteCharacterAfter(5);
+  Substitution result = Substitute(text.get(), 0, text->size(),
+                                   StringView(std::string("two")),
+                                   StringView(std::string("2")), false);
+  EXPECT_EQ("one 2", text->ToString());
+  EXPECT_EQ(1u, result.count);
+}
+
+}  // namespace
+}  // namespace zi
@@ -0,0 +1,110 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/atomic_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "zen/macros.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+
+AtomicFile::AtomicFile(const std::string& path)
+    : path_(path), temp_path_(path + ".swp"), fd_(-1) {
+  const size_t slash = path_.rfind('/');
+  if (slash == std::string::npos)
+    directory_ = ".";
+  else
+    directory_ = slash == 0 ? "/" : path_.substr(0, slash);
+}
+
+AtomicFile::~AtomicFile() {
+  Discard();
+}
+
+bool AtomicFile::Create(uint64_t size) {
+  Discard();
+  fd_.reset(HANDLE_EINTR(
+      open(directory_.c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0666)));
+  is_unnamed_ = fd_.is_valid();
+  if (!is_unnamed_) {
+    fd_.reset(HANDLE_EINTR(open(temp_path_.c_str(),
+                                O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                                0666)));
+  }
+  if (!fd_.is_valid())
+    return false;
+  struct stat info;
+  if (stat(path_.c_str(), &info) == 0)
+    fchmod(fd_.get(), info.st_mode & 07777);
+  // Not every file system can reserve space, but one that says it is full
+  // means it.
+  if (size > 0 && fallocate(fd_.get(), 0, 0, size) == -1 && errno == ENOSPC) {
+    Discard();
+    return false;
+  }
+  return true;
+}
+
+bool AtomicFile::Commit(Durability durability) {
+  TRACE_EVENT0("files", "AtomicFile::Commit");
+  if (!fd_.is_valid())
+    return false;
+  if (durability != Durability::None) {
+    TRACE_EVENT0("files", "fdatasync");
+    if (HANDLE_EINTR(fdatasync(fd_.get())) == -1) {
+      Discard();
+      return false;
+    }
+  }
+  if (is_unnamed_) {
+    // linkat cannot replace |path_|, so name the file next to it first.
+    char fd_path[32];
+    snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", fd_.get());
+    unlink(temp_path_.c_str());
+    if (linkat(AT_FDCWD, fd_path, AT_FDCWD, temp_path_.c_str(),
+               AT_SYMLINK_FOLLOW) == -1) {
+      Discard();
+      return false;
+    }
+    is_unnamed_ = false;
+  }
+  if (rename(temp_path_.c_str(), path_.c_str()) == -1) {
+    Discard();
+    return false;
+  }
+  fd_.reset();
+  if (durability == Durability::FileAndDirectory) {
+    TRACE_EVENT0("files", "fsync directory");
+    ScopedFD directory(HANDLE_EINTR(
+        open(directory_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)));
+    if (!directory.is_valid() || HANDLE_EINTR(fsync(directory.get())) == -1)
+      return false;
+  }
+  return true;
+}
+
+void AtomicFile::Discard() {
+  if (fd_.is_valid() && !is_unnamed_)
+    unlink(temp_path_.c_str());
+  fd_.reset();
+  is_unnamed_ = false;
+}
+
+}  // namespace zi
@@ -0,0 +1,68 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+#include "files/scoped_fd.h"
+#include "zen/macros.h"
+
+namespace zi {
+
+// How hard a save works to survive a crash or power loss.
+enum class Durability {
+  // Leave flushing to the kernel. A crash soon after saving can leave the
+  // file empty.
+  None,
+  // Flush the new contents before they replace the old ones, so a crash
+  // leaves one or the other.
+  File,
+  // Also flush the directory so that the replacement itself is durable.
+  FileAndDirectory,
+};
+
+// A file that replaces |path| only once it is completely written. It is
+// created without a name (O_TMPFILE) where the file system allows, so an
+// interrupted save leaves nothing behind, and takes the permissions of the
+// file it replaces.
+class AtomicFile {
+ public:
+  explicit AtomicFile(const std::string& path);
+  // Discards the file unless it was committed.
+  ~AtomicFile();
+
+  // Creates the file with |size| bytes reserved, so that running out of space
+  // fails here rather than halfway through the write.
+  bool Create(uint64_t size);
+  int fd() const { return fd_.get(); }
+
+  // Flushes the file as |durability| requires and renames it over |path|.
+  bool Commit(Durability durability);
+
+ private:
+  void Discard();
+
+  const std::string path_;
+  const std::string temp_path_;
+  std::string directory_;
+  ScopedFD fd_;
+  bool is_unnamed_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(AtomicFile);
+};
+
+}  // namespace zi
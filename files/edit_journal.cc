@@ -0,0 +1,321 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/edit_journal.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include "files/atomic_file.h"
+#include "files/file_util.h"
+#include "text/text_buffer.h"
+#include "zen/macros.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+namespace {
+
+const char kMagic[] = "zi-journal 1\n";
+constexpr size_t kMagicLength = sizeof(kMagic) - 1;
+
+// The first edits wait this long to be written with the ones after them.
+constexpr std::chrono::milliseconds kBatchDelay(100);
+
+// Enough for a long editing session between checkpoints.
+constexpr size_t kReservedEditSize = 1 << 20;
+
+// Records start with a tag and store numbers as LEB128 varints.
+constexpr char kBaseFileTag = 'B';
+constexpr char kCheckpointTag = 'S';
+constexpr char kEditTag = 'E';
+
+void AppendVarint(std::string* out, uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void AppendStringView(std::string* out, const StringView& text) {
+  out->append(text.begin(), text.length());
+}
+
+class Reader {
+ public:
+  Reader(const char* begin, const char* end) : next_(begin), end_(end) {}
+
+  bool is_empty() const { return next_ == end_; }
+
+  bool ReadByte(char* value) {
+    if (next_ == end_)
+      return false;
+    *value = *next_++;
+    return true;
+  }
+
+  bool ReadVarint(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && next_ != end_; shift += 7) {
+      const unsigned char byte = *next_++;
+      *value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool ReadBytes(uint64_t length, StringView* value) {
+    if (static_cast<uint64_t>(end_ - next_) < length)
+      return false;
+    *value = StringView(next_, next_ + length);
+    next_ += length;
+    return true;
+  }
+
+ private:
+  const char* next_;
+  const char* end_;
+};
+
+std::string MakeBaseFileRecord(uint64_t size) {
+  std::string record(1, kBaseFileTag);
+  AppendVarint(&record, size);
+  return record;
+}
+
+}  // namespace
+
+std::unique_ptr<EditJournal> EditJournal::Create(const std::string& path,
+                                                 uint64_t base_size) {
+  std::unique_ptr<EditJournal> journal(new EditJournal(path));
+  journal->base_ = MakeBaseFileRecord(base_size);
+  journal->thread_ = std::thread(&EditJournal::WriteOnThread, journal.get());
+  return journal;
+}
+
+EditJournal::EditJournal(const std::string& path) : path_(path), fd_(-1) {
+  edits_.reserve(kReservedEditSize);
+}
+
+EditJournal::~EditJournal() {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  thread_.join();
+}
+
+bool EditJournal::Replay(const std::string& path,
+                         TextBuffer* text,
+                         size_t* edit_count) {
+  TRACE_EVENT0("files", "EditJournal::Replay");
+  *edit_count = 0;
+  const std::vector<char> journal = ReadFile(path);
+  if (journal.size() < kMagicLength ||
+      memcmp(journal.data(), kMagic, kMagicLength) != 0) {
+    return false;
+  }
+  Reader reader(journal.data() + kMagicLength,
+                journal.data() + journal.size());
+  char tag = '\0';
+  StringView bytes;
+  uint64_t size = 0;
+  if (!reader.ReadByte(&tag) || !reader.ReadVarint(&size))
+    return false;
+  if (tag == kBaseFileTag) {
+    if (size != text->size())
+      return false;
+  } else if (tag == kCheckpointTag && reader.ReadBytes(size, &bytes)) {
+    text->DeleteRange(TextBufferRange(0, text->size()));
+    text->InsertText(TextPosition(0), bytes);
+  } else {
+    return false;
+  }
+  while (!reader.is_empty()) {
+    uint64_t offset = 0;
+    uint64_t deleted = 0;
+    if (!reader.ReadByte(&tag) || tag != kEditTag ||
+        !reader.ReadVarint(&offset) || !reader.ReadVarint(&deleted) ||
+        !reader.ReadVarint(&size) || !reader.ReadBytes(size, &bytes) ||
+        offset + deleted > text->size()) {
+      break;
+    }
+    text->DeleteRange(TextBufferRange(offset, offset + deleted));
+    text->InsertText(TextPosition(offset), bytes);
+    ++*edit_count;
+  }
+  return true;
+}
+
+void EditJournal::WillReplace(size_t offset,
+                              const TextView& deleted,
+                              const StringView& inserted) {
+  bool was_idle;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    was_idle = !HasWork();
+    edits_.push_back(kEditTag);
+    AppendVarint(&edits_, offset);
+    AppendVarint(&edits_, deleted.length());
+    AppendVarint(&edits_, inserted.length());
+    AppendStringView(&edits_, inserted);
+  }
+  // Only the first edit of a batch has to wake the thread.
+  if (was_idle)
+    changed_.notify_all();
+}
+
+void EditJournal::Checkpoint(const TextView& text) {
+  std::string base(1, kCheckpointTag);
+  AppendVarint(&base, text.length());
+  base.reserve(base.size() + text.length());
+  AppendStringView(&base, text.left());
+  AppendStringView(&base, text.right());
+  std::lock_guard<std::mutex> guard(lock_);
+  edits_mark_ += edits_.size();
+  edits_.clear();
+  StartOver(std::move(base));
+  base_is_checkpoint_ = true;
+}
+
+size_t EditJournal::edit_size() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return edits_.size();
+}
+
+uint64_t EditJournal::GetMark() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return edits_mark_ + edits_.size();
+}
+
+void EditJournal::Rebase(uint64_t mark, uint64_t base_size) {
+  std::lock_guard<std::mutex> guard(lock_);
+  // A checkpoint since |mark| already covers the saved text.
+  if (mark < edits_mark_)
+    return;
+  edits_.erase(0, mark - edits_mark_);
+  edits_mark_ = mark;
+  StartOver(MakeBaseFileRecord(base_size));
+  base_is_checkpoint_ = false;
+}
+
+void EditJournal::Flush() {
+  std::unique_lock<std::mutex> guard(lock_);
+  flushing_ = true;
+  changed_.notify_all();
+  changed_.wait(guard, [this]() { return !HasWork() || failed_; });
+  flushing_ = false;
+}
+
+void EditJournal::Remove() {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    edits_mark_ += edits_.size();
+    edits_.clear();
+    StartOver(MakeBaseFileRecord(0));
+    base_is_checkpoint_ = false;
+  }
+  Flush();
+}
+
+// Called with |lock_| held.
+void EditJournal::StartOver(std::string base) {
+  base_ = std::move(base);
+  needs_new_file_ = true;
+  written_size_ = 0;
+  ++epoch_;
+  changed_.notify_all();
+}
+
+// Called with |lock_| held. Without edits, the file should not exist.
+bool EditJournal::HasWork() const {
+  if (edits_.empty() && !base_is_checkpoint_)
+    return file_exists_;
+  return needs_new_file_ || written_size_ < edits_.size();
+}
+
+void EditJournal::WriteOnThread() {
+  std::string batch;
+  std::unique_lock<std::mutex> guard(lock_);
+  while (true) {
+    changed_.wait(guard, [this]() { return stopping_ || HasWork(); });
+    if (!HasWork())
+      return;
+    if (!stopping_ && !flushing_) {
+      changed_.wait_for(guard, kBatchDelay,
+                        [this]() { return stopping_ || flushing_; });
+    }
+    const uint64_t epoch = epoch_;
+    const bool remove_file = edits_.empty() && !base_is_checkpoint_;
+    const bool new_file = needs_new_file_;
+    const size_t size = edits_.size();
+    batch.clear();
+    if (new_file && !remove_file) {
+      batch.append(kMagic, kMagicLength);
+      batch.append(base_);
+    }
+    if (!remove_file)
+      batch.append(edits_, new_file ? 0 : written_size_, std::string::npos);
+    guard.unlock();
+
+    TRACE_EVENT0("files", "EditJournal::Write");
+    bool succeeded = true;
+    if (remove_file) {
+      fd_.reset();
+      unlink(path_.c_str());
+    } else if (new_file) {
+      // Replace the old journal in one step so that a crash leaves one or the
+      // other.
+      AtomicFile file(path_);
+      succeeded = file.Create(batch.size()) &&
+                  WriteFileDescriptor(file.fd(), batch.data(), batch.size()) &&
+                  file.Commit(Durability::File);
+      fd_.reset(succeeded ? HANDLE_EINTR(open(
+                                path_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC))
+                          : -1);
+      succeeded = succeeded && fd_.is_valid();
+    } else {
+      succeeded = WriteFileDescriptor(fd_.get(), batch.data(), batch.size()) &&
+                  HANDLE_EINTR(fdatasync(fd_.get())) == 0;
+    }
+
+    guard.lock();
+    if (remove_file)
+      file_exists_ = false;
+    else if (new_file && succeeded)
+      file_exists_ = true;
+    if (epoch == epoch_) {
+      // After a failure, start from scratch with the next batch.
+      needs_new_file_ = remove_file || !succeeded;
+      written_size_ = needs_new_file_ ? 0 : size;
+    }
+    failed_ = !succeeded;
+    changed_.notify_all();
+    if (!succeeded && !stopping_) {
+      // Do not spin on a file system that keeps failing.
+      changed_.wait_for(guard, kBatchDelay, [this]() { return stopping_; });
+    }
+    if (!succeeded && stopping_)
+      return;
+  }
+}
+
+}  // namespace zi
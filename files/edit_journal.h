@@ -0,0 +1,117 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "files/scoped_fd.h"
+#include "text/text_buffer_observer.h"
+#include "zen/macros.h"
+
+namespace zi {
+class TextBuffer;
+
+// An append-only log of the edits to a buffer, from which the buffer can be
+// recovered after a crash. Each edit is encoded into memory in a few bytes on
+// the editing thread and written out in batches on a background thread. The
+// journal file only exists while there are edits that are not saved.
+//
+// A journal starts from a base, either the file as saved or a checkpoint of
+// the whole text, followed by the edits since then.
+class EditJournal : public TextBufferObserver {
+ public:
+  // Starts a journal at |path| for a file of |base_size| bytes. Returns null
+  // if the thread cannot be started.
+  static std::unique_ptr<EditJournal> Create(const std::string& path,
+                                             uint64_t base_size);
+  // Writes out the edits recorded so far.
+  ~EditJournal() override;
+
+  // Applies the journal at |path| to |text|, which must hold the file the
+  // journal started from. Stops at the first record that is incomplete, e.g.,
+  // because of the crash. Returns false if the journal does not apply.
+  static bool Replay(const std::string& path,
+                     TextBuffer* text,
+                     size_t* edit_count);
+
+  // TextBufferObserver:
+  void WillReplace(size_t offset,
+                   const TextView& deleted,
+                   const StringView& inserted) override;
+
+  // Starts over from a copy of |text| so that the journal does not grow
+  // without bound.
+  void Checkpoint(const TextView& text);
+  // The size of the edits since the base, for deciding when to checkpoint.
+  size_t edit_size() const;
+
+  // Returns a mark for the current position in the journal. Once the text as
+  // of |mark| is saved as a file of |base_size| bytes, Rebase starts the
+  // journal over from that file with the edits made since.
+  uint64_t GetMark() const;
+  void Rebase(uint64_t mark, uint64_t base_size);
+
+  // Blocks until everything recorded so far is written.
+  void Flush();
+  // Discards the edits and deletes the journal, e.g., because the user
+  // abandoned them.
+  void Remove();
+
+ private:
+  explicit EditJournal(const std::string& path);
+
+  void StartOver(std::string base);
+  bool HasWork() const;
+  void WriteOnThread();
+
+  const std::string path_;
+
+  mutable std::mutex lock_;
+  std::condition_variable changed_;
+  // The base record and the edit records since then. |edits_| is reserved up
+  // front so that recording an edit does not allocate.
+  std::string base_;
+  bool base_is_checkpoint_ = false;
+  std::string edits_;
+  // The mark of the first byte of |edits_|.
+  uint64_t edits_mark_ = 0;
+  // What the file holds: whether it exists, whether it has to be rewritten
+  // from |base_|, and how much of |edits_| it has.
+  bool file_exists_ = true;
+  bool needs_new_file_ = true;
+  size_t written_size_ = 0;
+  // Bumped whenever the journal starts over, so that the thread can tell that
+  // what it wrote is out of date.
+  uint64_t epoch_ = 0;
+  bool flushing_ = false;
+  // Whether the last write failed. Flush gives up rather than wait for the
+  // file system to recover.
+  bool failed_ = false;
+  bool stopping_ = false;
+
+  ScopedFD fd_;
+  std::thread thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(EditJournal);
+};
+
+}  // namespace zi
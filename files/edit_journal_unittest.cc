@@ -0,0 +1,130 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/edit_journal.h"
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "files/file_util.h"
+#include "gtest/gtest.h"
+#include "text/text_buffer.h"
+
+namespace zi {
+namespace {
+
+std::string GetJournalPath() {
+  return "/tmp/zi_edit_journal_" + std::to_string(getpid());
+}
+
+std::unique_ptr<TextBuffer> MakeText(const std::string& text) {
+  return std::unique_ptr<TextBuffer>(
+      new TextBuffer(std::vector<char>(text.begin(), text.end())));
+}
+
+void Edit(TextBuffer* text) {
+  text->InsertText(TextPosition(5), std::string(", world"));
+  text->DeleteRange(TextBufferRange(0, 1));
+  text->InsertCharacter(TextPosition(0), 'j');
+}
+
+TEST(EditJournal, RecordsAndReplaysEdits) {
+  const std::string path = GetJournalPath();
+  std::unique_ptr<TextBuffer> text = MakeText("hello\n");
+  std::unique_ptr<EditJournal> journal = EditJournal::Create(path, 6);
+  text->AddObserver(journal.get());
+  Edit(text.get());
+  EXPECT_EQ("jello, world\n", text->ToString());
+  journal->Flush();
+  // A few bytes per edit.
+  EXPECT_GT(40u, journal->edit_size());
+
+  std::unique_ptr<TextBuffer> recovered = MakeText("hello\n");
+  size_t edit_count = 0;
+  EXPECT_TRUE(EditJournal::Replay(path, recovered.get(), &edit_count));
+  EXPECT_EQ(3u, edit_count);
+  EXPECT_EQ("jello, world\n", recovered->ToString());
+
+  // The journal does not apply to a different file.
+  recovered = MakeText("hi\n");
+  EXPECT_FALSE(EditJournal::Replay(path, recovered.get(), &edit_count));
+
+  // Removing the journal deletes its file.
+  text->RemoveObserver(journal.get());
+  journal->Remove();
+  EXPECT_EQ(-1, access(path.c_str(), F_OK));
+}
+
+TEST(EditJournal, IgnoresIncompleteRecords) {
+  const std::string path = GetJournalPath();
+  std::unique_ptr<TextBuffer> text = MakeText("hello\n");
+  {
+    std::unique_ptr<EditJournal> journal = EditJournal::Create(path, 6);
+    text->AddObserver(journal.get());
+    Edit(text.get());
+    text->RemoveObserver(journal.get());
+  }
+  // Cut the last edit short, as a crash might.
+  std::vector<char> contents = ReadFile(path);
+  contents.pop_back();
+  ASSERT_TRUE(WriteAtomically(path, StringView(std::string(
+                                        contents.begin(), contents.end()))));
+  std::unique_ptr<TextBuffer> recovered = MakeText("hello\n");
+  size_t edit_count = 0;
+  EXPECT_TRUE(EditJournal::Replay(path, recovered.get(), &edit_count));
+  EXPECT_EQ(2u, edit_count);
+  EXPECT_EQ("ello, world\n", recovered->ToString());
+  unlink(path.c_str());
+}
+
+TEST(EditJournal, CheckpointAndRebase) {
+  const std::string path = GetJournalPath();
+  std::unique_ptr<TextBuffer> text = MakeText("hello\n");
+  std::unique_ptr<EditJournal> journal = EditJournal::Create(path, 6);
+  text->AddObserver(journal.get());
+  Edit(text.get());
+  journal->Checkpoint(text->GetText());
+  EXPECT_EQ(0u, journal->edit_size());
+  text->InsertCharacter(TextPosition(0), '>');
+  journal->Flush();
+
+  // A checkpoint does not depend on the file.
+  std::unique_ptr<TextBuffer> recovered = MakeText("");
+  size_t edit_count = 0;
+  EXPECT_TRUE(EditJournal::Replay(path, recovered.get(), &edit_count));
+  EXPECT_EQ(1u, edit_count);
+  EXPECT_EQ(">jello, world\n", recovered->ToString());
+
+  // Once the text as of the mark is saved, the journal starts from the saved
+  // file and keeps the edits after the mark.
+  const uint64_t mark = journal->GetMark();
+  text->InsertCharacter(TextPosition(0), '>');
+  journal->Rebase(mark, 14);
+  journal->Flush();
+  recovered = MakeText(">jello, world\n");
+  EXPECT_TRUE(EditJournal::Replay(path, recovered.get(), &edit_count));
+  EXPECT_EQ(1u, edit_count);
+  EXPECT_EQ(">>jello, world\n", recovered->ToString());
+
+  // Without edits since the save, there is nothing to journal.
+  journal->Rebase(journal->GetMark(), 15);
+  journal->Flush();
+  EXPECT_EQ(-1, access(path.c_str(), F_OK));
+  text->RemoveObserver(journal.get());
+}
+
+}  // namespace
+}  // namespace zi
@@ -0,0 +1,150 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/file_loader.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "zen/macros.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+namespace {
+
+// Enough to keep the thread busy while the chunks before are appended.
+constexpr size_t kMaxQueuedChunks = 2;
+
+}  // namespace
+
+std::unique_ptr<FileLoader> FileLoader::Create(const std::string& path,
+                                               size_t chunk_size) {
+  int fd = HANDLE_EINTR(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd == -1)
+    return nullptr;
+  struct stat info;
+  int ready_fds[2];
+  if (fstat(fd, &info) == -1 ||
+      pipe2(ready_fds, O_NONBLOCK | O_CLOEXEC) == -1) {
+    close(fd);
+    return nullptr;
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  std::unique_ptr<FileLoader> loader(
+      new FileLoader(fd, ready_fds[0], ready_fds[1], info.st_size));
+  loader->thread_ =
+      std::thread(&FileLoader::ReadOnThread, loader.get(), chunk_size);
+  return loader;
+}
+
+FileLoader::FileLoader(int fd,
+                       int ready_read_fd,
+                       int ready_write_fd,
+                       size_t size)
+    : fd_(fd),
+      ready_read_fd_(ready_read_fd),
+      ready_write_fd_(ready_write_fd),
+      size_(size),
+      bytes_read_(0),
+      cancelled_(false) {}
+
+FileLoader::~FileLoader() {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    cancelled_ = true;
+  }
+  chunk_taken_.notify_one();
+  thread_.join();
+}
+
+void FileLoader::TakeChunks(std::vector<std::vector<char>>* chunks) {
+  // Drain first so that a chunk that arrives while we take the others still
+  // leaves the descriptor readable.
+  DrainReadyFd();
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    for (auto& chunk : chunks_)
+      chunks->push_back(std::move(chunk));
+    chunks_.clear();
+  }
+  chunk_taken_.notify_one();
+}
+
+bool FileLoader::WaitForChunk(std::vector<char>* chunk) {
+  {
+    std::unique_lock<std::mutex> guard(lock_);
+    chunk_ready_.wait(guard,
+                      [this]() { return !chunks_.empty() || !reading_; });
+    if (chunks_.empty())
+      return false;
+    *chunk = std::move(chunks_.front());
+    chunks_.pop_front();
+  }
+  chunk_taken_.notify_one();
+  return true;
+}
+
+bool FileLoader::is_finished() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return !reading_ && chunks_.empty();
+}
+
+bool FileLoader::failed() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return failed_;
+}
+
+void FileLoader::ReadOnThread(size_t chunk_size) {
+  bool failed = false;
+  while (!cancelled_) {
+    TRACE_EVENT0("files", "FileLoader::ReadChunk");
+    std::vector<char> chunk(chunk_size);
+    ssize_t count = HANDLE_EINTR(read(fd_.get(), chunk.data(), chunk.size()));
+    if (count <= 0) {
+      failed = count < 0;
+      break;
+    }
+    chunk.resize(count);
+    bytes_read_ += count;
+    {
+      std::unique_lock<std::mutex> guard(lock_);
+      chunk_taken_.wait(guard, [this]() {
+        return chunks_.size() < kMaxQueuedChunks || cancelled_;
+      });
+      if (cancelled_)
+        break;
+      chunks_.push_back(std::move(chunk));
+    }
+    chunk_ready_.notify_one();
+    char byte = 0;
+    HANDLE_EINTR(write(ready_write_fd_.get(), &byte, 1));
+  }
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    reading_ = false;
+    failed_ = failed;
+  }
+  chunk_ready_.notify_one();
+  char byte = 0;
+  HANDLE_EINTR(write(ready_write_fd_.get(), &byte, 1));
+}
+
+void FileLoader::DrainReadyFd() {
+  char buffer[64];
+  while (HANDLE_EINTR(read(ready_read_fd_.get(), buffer, sizeof(buffer))) > 0) {
+  }
+}
+
+}  // namespace zi
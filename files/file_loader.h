@@ -0,0 +1,87 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "files/scoped_fd.h"
+#include "zen/macros.h"
+
+namespace zi {
+
+// Reads a file on a background thread, one chunk at a time, so that the
+// beginning of a large file can be shown and edited before the rest is read.
+// The thread stays at most a couple of chunks ahead of whoever takes them.
+class FileLoader {
+ public:
+  // Returns null if |path| cannot be opened. The thread starts right away.
+  static std::unique_ptr<FileLoader> Create(const std::string& path,
+                                            size_t chunk_size);
+  // Stops reading if the file is not read yet.
+  ~FileLoader();
+
+  // The size of the file when it was opened.
+  size_t size() const { return size_; }
+  size_t bytes_read() const { return bytes_read_.load(); }
+
+  // Becomes readable whenever a chunk is ready, for use with poll().
+  int ready_fd() const { return ready_read_fd_.get(); }
+
+  // Appends the chunks read so far to |chunks| without blocking.
+  void TakeChunks(std::vector<std::vector<char>>* chunks);
+
+  // Blocks until the next chunk is read. Returns false at the end of the file.
+  bool WaitForChunk(std::vector<char>* chunk);
+
+  // True once every chunk has been read and taken.
+  bool is_finished() const;
+  // True if reading stopped because of an error.
+  bool failed() const;
+
+ private:
+  FileLoader(int fd, int ready_read_fd, int ready_write_fd, size_t size);
+
+  void ReadOnThread(size_t chunk_size);
+  void DrainReadyFd();
+
+  ScopedFD fd_;
+  ScopedFD ready_read_fd_;
+  ScopedFD ready_write_fd_;
+  const size_t size_;
+  std::atomic<size_t> bytes_read_;
+  std::atomic<bool> cancelled_;
+
+  mutable std::mutex lock_;
+  std::condition_variable chunk_ready_;
+  std::condition_variable chunk_taken_;
+  std::deque<std::vector<char>> chunks_;
+  bool reading_ = true;
+  bool failed_ = false;
+
+  std::thread thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileLoader);
+};
+
+}  // namespace zi
@@ -0,0 +1,84 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/file_loader.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "files/test_file_util.h"
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+TEST(FileLoader, ReadsInChunks) {
+  std::string contents;
+  for (int i = 0; i < 1000; ++i)
+    contents += "line " + std::to_string(i) + "\n";
+  const std::string path = MakeTempFile("zi_file_loader", contents);
+  std::unique_ptr<FileLoader> loader = FileLoader::Create(path, 1000);
+  unlink(path.c_str());
+  ASSERT_TRUE(loader);
+  EXPECT_EQ(contents.size(), loader->size());
+
+  std::vector<char> chunk;
+  ASSERT_TRUE(loader->WaitForChunk(&chunk));
+  EXPECT_EQ(1000u, chunk.size());
+  std::string loaded(chunk.begin(), chunk.end());
+  while (!loader->is_finished()) {
+    std::vector<std::vector<char>> chunks;
+    loader->TakeChunks(&chunks);
+    for (const auto& taken : chunks)
+      loaded.append(taken.begin(), taken.end());
+  }
+  EXPECT_EQ(contents, loaded);
+  EXPECT_EQ(contents.size(), loader->bytes_read());
+  EXPECT_FALSE(loader->failed());
+  EXPECT_FALSE(loader->WaitForChunk(&chunk));
+}
+
+TEST(FileLoader, StaysAFewChunksAhead) {
+  const std::string path =
+      MakeTempFile("zi_file_loader", std::string(1 << 20, 'x'));
+  std::unique_ptr<FileLoader> loader = FileLoader::Create(path, 16);
+  unlink(path.c_str());
+  ASSERT_TRUE(loader);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  // Two chunks wait to be taken and the thread holds a third.
+  EXPECT_GE(48u, loader->bytes_read());
+  std::vector<std::vector<char>> chunks;
+  loader->TakeChunks(&chunks);
+  EXPECT_GE(2u, chunks.size());
+}
+
+TEST(FileLoader, StopsWhenDestroyed) {
+  const std::string path =
+      MakeTempFile("zi_file_loader", std::string(1 << 20, 'x'));
+  std::unique_ptr<FileLoader> loader = FileLoader::Create(path, 16);
+  unlink(path.c_str());
+  ASSERT_TRUE(loader);
+  loader.reset();
+}
+
+TEST(FileLoader, MissingFile) {
+  EXPECT_FALSE(FileLoader::Create("/tmp/zi_file_loader_missing", 16));
+}
+
+}  // namespace
+}  // namespace zi
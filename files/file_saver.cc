@@ -0,0 +1,147 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/file_saver.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "files/file_util.h"
+#include "files/undo_file.h"
+#include "zen/macros.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+
+std::unique_ptr<FileSaver> FileSaver::Create() {
+  int ready_fds[2];
+  if (pipe2(ready_fds, O_NONBLOCK | O_CLOEXEC) == -1)
+    return nullptr;
+  std::unique_ptr<FileSaver> saver(new FileSaver(ready_fds[0], ready_fds[1]));
+  saver->thread_ = std::thread(&FileSaver::SaveOnThread, saver.get());
+  return saver;
+}
+
+FileSaver::FileSaver(int ready_read_fd, int ready_write_fd)
+    : ready_read_fd_(ready_read_fd), ready_write_fd_(ready_write_fd) {}
+
+FileSaver::~FileSaver() {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  thread_.join();
+}
+
+void FileSaver::Save(const std::string& path,
+                     TextSnapshot contents,
+                     Durability durability,
+                     uint64_t tag,
+                     bool hash_contents) {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    Request* request = nullptr;
+    for (auto& waiting : requests_) {
+      if (waiting.path == path)
+        request = &waiting;
+    }
+    if (!request) {
+      requests_.push_back(Request());
+      request = &requests_.back();
+      request->path = path;
+    }
+    request->contents = std::move(contents);
+    request->durability = durability;
+    request->tag = tag;
+    request->hash_contents = hash_contents;
+    ++request->save_count;
+  }
+  changed_.notify_all();
+}
+
+bool FileSaver::TakeResult(Result* result) {
+  // Drain first so that a save that completes while we take this result still
+  // leaves the descriptor readable.
+  DrainReadyFd();
+  std::lock_guard<std::mutex> guard(lock_);
+  if (results_.empty())
+    return false;
+  *result = std::move(results_.front());
+  results_.pop_front();
+  if (!results_.empty()) {
+    char byte = 0;
+    HANDLE_EINTR(write(ready_write_fd_.get(), &byte, 1));
+  }
+  return true;
+}
+
+void FileSaver::WaitForIdle() {
+  std::unique_lock<std::mutex> guard(lock_);
+  changed_.wait(guard, [this]() { return requests_.empty() && !writing_; });
+}
+
+bool FileSaver::is_saving() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return !requests_.empty() || writing_;
+}
+
+void FileSaver::SaveOnThread() {
+  std::unique_lock<std::mutex> guard(lock_);
+  while (true) {
+    changed_.wait(guard, [this]() { return !requests_.empty() || stopping_; });
+    if (requests_.empty())
+      return;
+    Request request = std::move(requests_.front());
+    requests_.pop_front();
+    writing_ = true;
+    guard.unlock();
+
+    Result result;
+    {
+      TRACE_EVENT0("files", "FileSaver::Save");
+      result.succeeded =
+          WriteAtomically(request.path, request.contents.text(),
+                          request.durability);
+    }
+    if (request.hash_contents) {
+      TRACE_EVENT0("files", "FileSaver::Hash");
+      result.hash = UndoFile::HashText(request.contents.text());
+    }
+    result.path = std::move(request.path);
+    result.size = request.contents.size();
+    result.save_count = request.save_count;
+    result.tag = request.tag;
+    // Release the snapshot before waking anyone up, so that the buffer can
+    // write over the bytes it shares with the snapshot.
+    request.contents = TextSnapshot();
+
+    guard.lock();
+    writing_ = false;
+    results_.push_back(std::move(result));
+    changed_.notify_all();
+    char byte = 0;
+    HANDLE_EINTR(write(ready_write_fd_.get(), &byte, 1));
+  }
+}
+
+void FileSaver::DrainReadyFd() {
+  char buffer[64];
+  while (HANDLE_EINTR(read(ready_read_fd_.get(), buffer, sizeof(buffer))) > 0) {
+  }
+}
+
+}  // namespace zi
@@ -0,0 +1,108 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "files/atomic_file.h"
+#include "files/scoped_fd.h"
+#include "text/text_snapshot.h"
+#include "zen/macros.h"
+
+namespace zi {
+
+// Writes snapshots of a buffer to disk on a background thread so that saving
+// does not stall editing. A save of a path that is still waiting behind
+// another write replaces the waiting snapshot, so back-to-back saves coalesce
+// into one write of the latest contents.
+class FileSaver {
+ public:
+  struct Result {
+    std::string path;
+    size_t size = 0;
+    // How many calls to Save this write covered.
+    size_t save_count = 0;
+    // The tag of the snapshot that was written.
+    uint64_t tag = 0;
+    // UndoFile::HashText of the snapshot, if the save asked for it.
+    uint64_t hash = 0;
+    bool succeeded = false;
+  };
+
+  // Returns null if the thread cannot be started.
+  static std::unique_ptr<FileSaver> Create();
+  // Finishes the saves that were requested.
+  ~FileSaver();
+
+  // Writes |contents| to |path| atomically. |tag| is for the caller to tell
+  // which snapshot a result is for. If |hash_contents| is set, the result
+  // carries a hash of the snapshot, computed on the saver thread.
+  void Save(const std::string& path,
+            TextSnapshot contents,
+            Durability durability = Durability::FileAndDirectory,
+            uint64_t tag = 0,
+            bool hash_contents = false);
+
+  // Becomes readable whenever a save completes, for use with poll().
+  int ready_fd() const { return ready_read_fd_.get(); }
+
+  // Takes the oldest completed save without blocking. Returns false if no
+  // save has completed since the last call.
+  bool TakeResult(Result* result);
+  // Blocks until every requested save is written.
+  void WaitForIdle();
+
+  // True while a save is waiting or being written.
+  bool is_saving() const;
+
+ private:
+  struct Request {
+    std::string path;
+    TextSnapshot contents;
+    Durability durability = Durability::FileAndDirectory;
+    size_t save_count = 0;
+    uint64_t tag = 0;
+    bool hash_contents = false;
+  };
+
+  FileSaver(int ready_read_fd, int ready_write_fd);
+
+  void SaveOnThread();
+  void DrainReadyFd();
+
+  ScopedFD ready_read_fd_;
+  ScopedFD ready_write_fd_;
+
+  mutable std::mutex lock_;
+  std::condition_variable changed_;
+  std::deque<Request> requests_;
+  std::deque<Result> results_;
+  bool writing_ = false;
+  bool stopping_ = false;
+
+  std::thread thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileSaver);
+};
+
+}  // namespace zi
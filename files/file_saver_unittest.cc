@@ -0,0 +1,123 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/file_saver.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "files/file_util.h"
+#include "files/undo_file.h"
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+std::string ReadToString(const std::string& path) {
+  std::vector<char> contents = ReadFile(path);
+  return std::string(contents.begin(), contents.end());
+}
+
+TEST(FileSaver, Saves) {
+  std::unique_ptr<FileSaver> saver = FileSaver::Create();
+  ASSERT_TRUE(saver);
+  FileSaver::Result result;
+  EXPECT_FALSE(saver->TakeResult(&result));
+
+  const std::string path = "/tmp/zi_file_saver_" + std::to_string(getpid());
+  saver->Save(path, TextSnapshot("hello\n"));
+  saver->WaitForIdle();
+  EXPECT_FALSE(saver->is_saving());
+  ASSERT_TRUE(saver->TakeResult(&result));
+  EXPECT_TRUE(result.succeeded);
+  EXPECT_EQ(path, result.path);
+  EXPECT_EQ(6u, result.size);
+  EXPECT_EQ(1u, result.save_count);
+  EXPECT_FALSE(saver->TakeResult(&result));
+  EXPECT_EQ("hello\n", ReadToString(path));
+  unlink(path.c_str());
+}
+
+TEST(FileSaver, HashesContentsOnRequest) {
+  std::unique_ptr<FileSaver> saver = FileSaver::Create();
+  ASSERT_TRUE(saver);
+  const std::string path = "/tmp/zi_file_saver_" + std::to_string(getpid());
+  TextSnapshot contents("hello\n");
+  const uint64_t hash = UndoFile::HashText(contents.text());
+  saver->Save(path, contents, Durability::None);
+  saver->Save(path + ".hashed", contents, Durability::None, 0, true);
+  saver->WaitForIdle();
+  FileSaver::Result result;
+  ASSERT_TRUE(saver->TakeResult(&result));
+  EXPECT_EQ(0u, result.hash);
+  ASSERT_TRUE(saver->TakeResult(&result));
+  EXPECT_EQ(hash, result.hash);
+  unlink(path.c_str());
+  unlink((path + ".hashed").c_str());
+}
+
+TEST(FileSaver, CoalescesSaves) {
+  std::unique_ptr<FileSaver> saver = FileSaver::Create();
+  ASSERT_TRUE(saver);
+  const std::string path = "/tmp/zi_file_saver_" + std::to_string(getpid());
+  for (int i = 0; i < 10; ++i)
+    saver->Save(path, TextSnapshot(std::string(1 << 20, 'a' + i)),
+                Durability::None, i);
+  saver->WaitForIdle();
+
+  // However the saves were batched, every one is accounted for and the last
+  // one wins.
+  size_t save_count = 0;
+  size_t result_count = 0;
+  uint64_t tag = 0;
+  FileSaver::Result result;
+  while (saver->TakeResult(&result)) {
+    EXPECT_TRUE(result.succeeded);
+    save_count += result.save_count;
+    tag = result.tag;
+    ++result_count;
+  }
+  EXPECT_EQ(10u, save_count);
+  EXPECT_EQ(9u, tag);
+  EXPECT_GE(10u, result_count);
+  EXPECT_EQ(std::string(1 << 20, 'j'), ReadToString(path));
+  unlink(path.c_str());
+}
+
+TEST(FileSaver, ReportsErrors) {
+  std::unique_ptr<FileSaver> saver = FileSaver::Create();
+  ASSERT_TRUE(saver);
+  saver->Save("/tmp/zi_file_saver_missing/file", TextSnapshot("hello\n"));
+  saver->WaitForIdle();
+  FileSaver::Result result;
+  ASSERT_TRUE(saver->TakeResult(&result));
+  EXPECT_FALSE(result.succeeded);
+}
+
+TEST(FileSaver, FinishesSavesWhenDestroyed) {
+  const std::string path = "/tmp/zi_file_saver_" + std::to_string(getpid());
+  std::unique_ptr<FileSaver> saver = FileSaver::Create();
+  ASSERT_TRUE(saver);
+  saver->Save(path, TextSnapshot("one\n"));
+  saver->Save(path, TextSnapshot("two\n"));
+  saver.reset();
+  EXPECT_EQ("two\n", ReadToString(path));
+  unlink(path.c_str());
+}
+
+}  // namespace
+}  // namespace zi
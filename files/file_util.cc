@@ -0,0 +1,209 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/file_util.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <linux/magic.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "files/scoped_fd.h"
+#include "zen/macros.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+namespace {
+
+// Copies in the kernel where possible, e.g., not across file systems before
+// Linux 5.3.
+bool CopyBytes(int from_fd, uint64_t start, uint64_t end, int to_fd) {
+  while (start < end) {
+    loff_t offset = start;
+    ssize_t count = HANDLE_EINTR(
+        copy_file_range(from_fd, &offset, to_fd, nullptr, end - start, 0));
+    if (count == 0)
+      return false;
+    if (count < 0) {
+      if (errno != EXDEV && errno != EINVAL && errno != ENOSYS &&
+          errno != EOPNOTSUPP) {
+        return false;
+      }
+      break;
+    }
+    start += count;
+  }
+  constexpr size_t kBufferSize = 1 << 20;
+  std::vector<char> buffer(std::min<uint64_t>(end - start, kBufferSize));
+  while (start < end) {
+    size_t length = std::min<uint64_t>(end - start, buffer.size());
+    ssize_t count = HANDLE_EINTR(pread(from_fd, buffer.data(), length, start));
+    if (count <= 0 || !WriteFileDescriptor(to_fd, buffer.data(), count))
+      return false;
+    start += count;
+  }
+  return true;
+}
+
+}  // namespace
+
+std::vector<char> ReadFile(const std::string& path, size_t gap_size) {
+  TRACE_EVENT0("files", "ReadFile");
+  std::vector<char> result(gap_size);
+  ScopedFD fd(HANDLE_EINTR(open(path.c_str(), O_RDONLY)));
+  // TODO(abarth): Add an error reporting mechanism.
+  if (!fd.is_valid())
+    return result;
+  struct stat info;
+  if (fstat(fd.get(), &info) == 0 && S_ISREG(info.st_mode) &&
+      info.st_size > 0) {
+    // We know how big a regular file is, so read it straight into its final
+    // place rather than growing the buffer as we go. Mapping the file would
+    // not save anything because the text has to end up in |result| anyway.
+    posix_fadvise(fd.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+    const size_t size = info.st_size;
+    result.resize(gap_size + size);
+    size_t total = 0;
+    while (total < size) {
+      ssize_t count =
+          HANDLE_EINTR(read(fd.get(), &result[gap_size + total], size - total));
+      if (count <= 0)
+        break;
+      total += count;
+    }
+    result.resize(gap_size + total);
+    // Unless the file grew since we looked, we are done.
+    if (total < size)
+      return result;
+  }
+  constexpr size_t kBufferSize = 1 << 16;
+  char buffer[kBufferSize];
+  for (;;) {
+    int count = HANDLE_EINTR(read(fd.get(), buffer, kBufferSize));
+    if (count == -1)
+      return result;
+    if (count == 0)
+      break;
+    result.insert(result.end(), buffer, buffer + count);
+  }
+  return result;
+}
+
+bool GetFileSize(const std::string& path, size_t* size) {
+  struct stat info;
+  if (stat(path.c_str(), &info) == -1 || !S_ISREG(info.st_mode))
+    return false;
+  *size = info.st_size;
+  return true;
+}
+
+bool WriteFileDescriptor(int fd, const char* data, ssize_t size) {
+  ssize_t total = 0;
+  for (ssize_t partial = 0; total < size; total += partial) {
+    partial = HANDLE_EINTR(write(fd, data + total, size - total));
+    if (partial < 0)
+      return false;
+  }
+  return true;
+}
+
+bool WriteStringViewToFileDescriptor(int fd, StringView string_view) {
+  if (string_view.is_empty())
+    return true;
+  return WriteFileDescriptor(fd, string_view.begin(), string_view.length());
+}
+
+bool CopyFileRange(int from_fd, uint64_t start, uint64_t end, int to_fd) {
+  TRACE_EVENT0("files", "CopyFileRange");
+  const off_t position = lseek(to_fd, 0, SEEK_CUR);
+  struct stat info;
+  if (position == -1 || fstat(to_fd, &info) == -1 || info.st_blksize <= 0)
+    return CopyBytes(from_fd, start, end, to_fd);
+  // Blocks can only be shared if the range sits at the same offset within a
+  // block in both files. The partial blocks at either end are copied.
+  const uint64_t block_size = info.st_blksize;
+  const uint64_t head = (block_size - start % block_size) % block_size;
+  const uint64_t clone_start = start + head;
+  const uint64_t clone_end = end / block_size * block_size;
+  if (start % block_size == position % block_size && clone_start < clone_end) {
+    if (!CopyBytes(from_fd, start, clone_start, to_fd))
+      return false;
+    start = clone_start;
+    struct file_clone_range range;
+    range.src_fd = from_fd;
+    range.src_offset = clone_start;
+    range.src_length = clone_end - clone_start;
+    range.dest_offset = position + head;
+    if (ioctl(to_fd, FICLONERANGE, &range) == 0 &&
+        lseek(to_fd, range.dest_offset + range.src_length, SEEK_SET) != -1) {
+      start = clone_end;
+    }
+  }
+  return CopyBytes(from_fd, start, end, to_fd);
+}
+
+bool CanShareBlocks(int fd) {
+  struct statfs info;
+  if (fstatfs(fd, &info) == -1)
+    return false;
+  return info.f_type == BTRFS_SUPER_MAGIC || info.f_type == XFS_SUPER_MAGIC;
+}
+
+bool WriteTextToFileDescriptor(int fd, TextView text) {
+  struct iovec iov[2] = {
+      {const_cast<char*>(text.left().begin()), text.left().length()},
+      {const_cast<char*>(text.right().begin()), text.right().length()},
+  };
+  struct iovec* next = iov;
+  int count = 2;
+  while (count > 0) {
+    if (next->iov_len == 0) {
+      ++next;
+      --count;
+      continue;
+    }
+    ssize_t written = HANDLE_EINTR(writev(fd, next, count));
+    if (written < 0)
+      return false;
+    for (; count > 0 && static_cast<size_t>(written) >= next->iov_len;
+         ++next, --count) {
+      written -= next->iov_len;
+    }
+    if (count > 0) {
+      next->iov_base = static_cast<char*>(next->iov_base) + written;
+      next->iov_len -= written;
+    }
+  }
+  return true;
+}
+
+bool WriteAtomically(const std::string& path,
+                     TextView text,
+                     Durability durability) {
+  TRACE_EVENT0("files", "WriteAtomically");
+  // TODO(abarth): Add an error reporting mechanism.
+  AtomicFile file(path);
+  return file.Create(text.length()) &&
+         WriteTextToFileDescriptor(file.fd(), text) && file.Commit(durability);
+}
+
+}  // namespace zi
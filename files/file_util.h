@@ -0,0 +1,54 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "files/atomic_file.h"
+#include "text/text_view.h"
+#include "zen/string_view.h"
+
+namespace zi {
+
+// Reads the file at |path| into a buffer that starts with |gap_size| unused
+// bytes, as TextBuffer(buffer, gap_size) expects. Regular files are read with
+// a single copy into a buffer sized up front. Returns just the gap if the file
+// cannot be read.
+std::vector<char> ReadFile(const std::string& path, size_t gap_size = 0u);
+
+// Returns false if |path| does not name a regular file.
+bool GetFileSize(const std::string& path, size_t* size);
+
+bool WriteFileDescriptor(int fd, const char* data, ssize_t size);
+bool WriteStringViewToFileDescriptor(int fd, StringView string_view);
+// Appends [start, end) of |from_fd| to |to_fd| at its current offset. Where
+// the file system supports it, the blocks are shared rather than copied
+// (FICLONERANGE). Otherwise the kernel copies them (copy_file_range), and as a
+// last resort they are copied through a buffer.
+bool CopyFileRange(int from_fd, uint64_t start, uint64_t end, int to_fd);
+// Whether the file system |fd| is on might share blocks between files.
+bool CanShareBlocks(int fd);
+
+// Writes both halves of |text| with writev.
+bool WriteTextToFileDescriptor(int fd, TextView text);
+bool WriteAtomically(const std::string& path,
+                     TextView text,
+                     Durability durability = Durability::FileAndDirectory);
+
+}  // namespace zi
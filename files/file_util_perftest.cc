@@ -0,0 +1,87 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/file_util.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "text/text_buffer.h"
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Opens a file of |arg| bytes and makes the first edit, with and without a
+// gap in front of the text.
+void LoadAndEdit(BenchmarkState* state, size_t gap_size) {
+  char path[] = "/tmp/zi_file_util_perftest_XXXXXX";
+  int fd = mkstemp(path);
+  const std::vector<char> contents(state->arg(), 'a');
+  WriteFileDescriptor(fd, contents.data(), contents.size());
+  close(fd);
+  while (state->KeepRunning()) {
+    TextBuffer text(ReadFile(path, gap_size), gap_size);
+    text.InsertCharacter(TextPosition(0), 'x');
+  }
+  unlink(path);
+  state->SetBytesProcessed(state->iterations() * state->arg());
+}
+
+void FileUtil_LoadAndEdit(BenchmarkState* state) {
+  LoadAndEdit(state, 0);
+}
+BENCHMARK(FileUtil_LoadAndEdit, 1 << 16, 1 << 24);
+
+void FileUtil_LoadWithGapAndEdit(BenchmarkState* state) {
+  LoadAndEdit(state, 1 << 16);
+}
+BENCHMARK(FileUtil_LoadWithGapAndEdit, 1 << 16, 1 << 24);
+
+// Saves a buffer of |arg| bytes, split by a gap in the middle, under each
+// durability policy. The differences between them are the cost of flushing.
+void Save(BenchmarkState* state, Durability durability) {
+  const std::string path =
+      "/tmp/zi_file_util_perftest_" + std::to_string(getpid());
+  const std::string contents(state->arg(), 'a');
+  const char* begin = contents.data();
+  const char* middle = begin + contents.size() / 2;
+  const TextView text(StringView(begin, middle),
+                      StringView(middle, begin + contents.size()));
+  while (state->KeepRunning())
+    WriteAtomically(path, text, durability);
+  unlink(path.c_str());
+  state->SetBytesProcessed(state->iterations() * state->arg());
+}
+
+void FileUtil_SaveWithoutSync(BenchmarkState* state) {
+  Save(state, Durability::None);
+}
+BENCHMARK(FileUtil_SaveWithoutSync, 1 << 16, 1 << 24);
+
+void FileUtil_SaveWithFileSync(BenchmarkState* state) {
+  Save(state, Durability::File);
+}
+BENCHMARK(FileUtil_SaveWithFileSync, 1 << 16, 1 << 24);
+
+void FileUtil_SaveWithDirectorySync(BenchmarkState* state) {
+  Save(state, Durability::FileAndDirectory);
+}
+BENCHMARK(FileUtil_SaveWithDirectorySync, 1 << 16, 1 << 24);
+
+}  // namespace
+}  // namespace zi
@@ -0,0 +1,128 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/file_util.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "files/test_file_util.h"
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+TEST(FileUtil, ReadFile) {
+  const std::string path = MakeTempFile("zi_file_util", "Hello, world");
+  std::vector<char> contents = ReadFile(path);
+  EXPECT_EQ("Hello, world", std::string(contents.begin(), contents.end()));
+  unlink(path.c_str());
+}
+
+TEST(FileUtil, ReadFileWithGap) {
+  const std::string path = MakeTempFile("zi_file_util", "Hello");
+  std::vector<char> contents = ReadFile(path, 3);
+  ASSERT_EQ(8u, contents.size());
+  EXPECT_EQ("Hello", std::string(contents.begin() + 3, contents.end()));
+  unlink(path.c_str());
+
+  // A file we cannot read is empty.
+  EXPECT_EQ(3u, ReadFile(path, 3).size());
+}
+
+TEST(FileUtil, ReadFileOfUnknownSize) {
+  // Pipes report a size of zero and are read until the end.
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  const std::string text(100000, 'x');
+  std::string path = "/dev/fd/" + std::to_string(fds[0]);
+  pid_t child = fork();
+  ASSERT_NE(-1, child);
+  if (child == 0) {
+    close(fds[0]);
+    WriteFileDescriptor(fds[1], text.data(), text.size());
+    _exit(0);
+  }
+  close(fds[1]);
+  std::vector<char> contents = ReadFile(path, 2);
+  close(fds[0]);
+  waitpid(child, nullptr, 0);
+  ASSERT_EQ(text.size() + 2, contents.size());
+  EXPECT_EQ(text, std::string(contents.begin() + 2, contents.end()));
+}
+
+TEST(FileUtil, CopyFileRange) {
+  std::string contents;
+  for (int i = 0; contents.size() < 40000; ++i)
+    contents += std::to_string(i) + "\n";
+  const std::string from_path = MakeTempFile("zi_file_util", contents);
+  const std::string to_path = MakeTempFile("zi_file_util", "");
+  int from_fd = open(from_path.c_str(), O_RDONLY);
+  int to_fd = open(to_path.c_str(), O_WRONLY);
+  ASSERT_NE(-1, from_fd);
+  ASSERT_NE(-1, to_fd);
+  // Block aligned in both files, then unaligned, then empty.
+  EXPECT_TRUE(CopyFileRange(from_fd, 0, 12288, to_fd));
+  EXPECT_TRUE(CopyFileRange(from_fd, 5, 30000, to_fd));
+  EXPECT_TRUE(CopyFileRange(from_fd, 7, 7, to_fd));
+  EXPECT_FALSE(CopyFileRange(from_fd, 0, contents.size() + 1, to_fd));
+  close(from_fd);
+  close(to_fd);
+  std::vector<char> copied = ReadFile(to_path);
+  EXPECT_EQ(contents.substr(0, 12288) + contents.substr(5, 29995),
+            std::string(copied.begin(), copied.begin() + 42283));
+  unlink(from_path.c_str());
+  unlink(to_path.c_str());
+}
+
+TEST(FileUtil, WriteAtomically) {
+  const std::string path = MakeTempFile("zi_file_util", "old");
+  ASSERT_EQ(0, chmod(path.c_str(), 0640));
+  const std::string left = "Hello, ";
+  const std::string right = "world";
+  for (Durability durability :
+       {Durability::None, Durability::File, Durability::FileAndDirectory}) {
+    EXPECT_TRUE(WriteAtomically(path, TextView(left, right), durability));
+    std::vector<char> contents = ReadFile(path);
+    EXPECT_EQ("Hello, world", std::string(contents.begin(), contents.end()));
+  }
+  struct stat info;
+  ASSERT_EQ(0, stat(path.c_str(), &info));
+  EXPECT_EQ(0640u, info.st_mode & 07777);
+  EXPECT_EQ(-1, access((path + ".swp").c_str(), F_OK));
+  unlink(path.c_str());
+
+  EXPECT_FALSE(WriteAtomically("/tmp/zi_file_util_missing/file", left));
+}
+
+TEST(FileUtil, AtomicFileDiscardsUncommittedWrites) {
+  const std::string path = MakeTempFile("zi_file_util", "old");
+  {
+    AtomicFile file(path);
+    ASSERT_TRUE(file.Create(3));
+    EXPECT_TRUE(WriteFileDescriptor(file.fd(), "new", 3));
+  }
+  std::vector<char> contents = ReadFile(path);
+  EXPECT_EQ("old", std::string(contents.begin(), contents.end()));
+  EXPECT_EQ(-1, access((path + ".swp").c_str(), F_OK));
+  unlink(path.c_str());
+}
+
+}  // namespace
+}  // namespace zi
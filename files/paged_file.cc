@@ -0,0 +1,230 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/paged_file.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "files/file_util.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+namespace {
+
+constexpr size_t kIndexBlockSize = 1 << 20;
+
+}  // namespace
+
+std::unique_ptr<PagedFile> PagedFile::Open(const std::string& path) {
+  int fd = HANDLE_EINTR(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd == -1)
+    return nullptr;
+  struct stat info;
+  if (fstat(fd, &info) == -1 || !S_ISREG(info.st_mode)) {
+    close(fd);
+    return nullptr;
+  }
+  std::unique_ptr<PagedFile> file(new PagedFile(fd, info.st_size));
+  file->index_thread_ = std::thread(&PagedFile::IndexOnThread, file.get());
+  return file;
+}
+
+PagedFile::PagedFile(int fd, uint64_t size)
+    : fd_(fd), size_(size), indexed_size_(0), cancelled_(false) {
+  checkpoints_.push_back(0);
+}
+
+PagedFile::~PagedFile() {
+  cancelled_ = true;
+  index_thread_.join();
+}
+
+bool PagedFile::ReadWindow(uint64_t length,
+                           uint64_t* start,
+                           uint64_t* end,
+                           std::vector<char>* buffer,
+                           size_t gap_size) const {
+  TRACE_EVENT0("files", "PagedFile::ReadWindow");
+  uint64_t window_start = std::min(*start, size_);
+  uint64_t window_end = std::min(size_ - window_start, length) + window_start;
+
+  // Grow the window until it covers every overlay it touches. Overlays start
+  // and end on line boundaries, so their edges need no further alignment.
+  auto first = overlays_.upper_bound(window_start);
+  if (first != overlays_.begin() &&
+      std::prev(first)->second.end > window_start) {
+    --first;
+    window_start = first->first;
+  }
+  auto last = first;
+  while (last != overlays_.end() && last->first < window_end) {
+    window_end = std::max(window_end, last->second.end);
+    ++last;
+  }
+  bool start_on_overlay = first != last && first->first == window_start;
+  bool end_on_overlay =
+      first != last && std::prev(last)->second.end == window_end;
+  if (!start_on_overlay && window_start > 0 &&
+      (first == overlays_.begin() ||
+       std::prev(first)->second.end != window_start)) {
+    // Skip ahead to the start of the next line.
+    uint64_t limit = first != last ? first->first : window_end;
+    std::vector<char> head;
+    if (!ReadOriginal(window_start - 1, limit, &head))
+      return false;
+    auto newline = std::find(head.begin(), head.end(), '\n');
+    const size_t skipped = newline - head.begin();
+    if (skipped < window_end - window_start)
+      window_start += skipped;
+    else if (first != last)
+      window_start = limit;
+  }
+
+  buffer->clear();
+  buffer->reserve(gap_size + (window_end - window_start));
+  buffer->resize(gap_size);
+  uint64_t position = window_start;
+  for (auto it = first; it != last; ++it) {
+    if (!ReadOriginal(position, it->first, buffer))
+      return false;
+    buffer->insert(buffer->end(), it->second.text.begin(),
+                   it->second.text.end());
+    position = it->second.end;
+  }
+  if (!ReadOriginal(position, window_end, buffer))
+    return false;
+
+  if (!end_on_overlay && window_end < size_) {
+    // Drop the partial line at the end, which the next window begins with.
+    size_t tail_start = buffer->size() - (window_end - position);
+    size_t keep = buffer->size();
+    while (keep > tail_start && (*buffer)[keep - 1] != '\n')
+      --keep;
+    // A window that is a single line longer than |length| is kept whole.
+    if (keep > gap_size) {
+      window_end -= buffer->size() - keep;
+      buffer->resize(keep);
+    }
+  }
+
+  *start = window_start;
+  *end = window_end;
+  return true;
+}
+
+void PagedFile::SetOverlay(uint64_t start, uint64_t end, const TextView& text) {
+  auto it = overlays_.lower_bound(start);
+  while (it != overlays_.end() && it->second.end <= end) {
+    overlay_size_ -= it->second.text.size();
+    it = overlays_.erase(it);
+  }
+  Overlay& overlay = overlays_[start];
+  overlay.end = end;
+  overlay.text = text.ToString();
+  overlay_size_ += overlay.text.size();
+}
+
+uint64_t PagedFile::GetEditedOffset(uint64_t offset) const {
+  uint64_t edited_offset = offset;
+  for (const auto& entry : overlays_) {
+    if (entry.second.end > offset)
+      break;
+    edited_offset += entry.second.text.size();
+    edited_offset -= entry.second.end - entry.first;
+  }
+  return edited_offset;
+}
+
+void PagedFile::GetCheckpoint(uint64_t line,
+                              uint64_t* checkpoint_line,
+                              uint64_t* offset) const {
+  std::lock_guard<std::mutex> guard(lock_);
+  size_t index = std::min<uint64_t>(line / kLinesPerCheckpoint,
+                                    checkpoints_.size() - 1);
+  *checkpoint_line = index * kLinesPerCheckpoint;
+  *offset = checkpoints_[index];
+}
+
+bool PagedFile::WriteTo(const std::string& path, Durability durability) const {
+  TRACE_EVENT0("files", "PagedFile::WriteTo");
+  AtomicFile file(path);
+  // Reserving space speeds up file systems that copy the unchanged blocks but
+  // would defeat those that can share them.
+  if (!file.Create(CanShareBlocks(fd_.get()) ? 0 : GetEditedOffset(size_)))
+    return false;
+  uint64_t position = 0;
+  for (const auto& entry : overlays_) {
+    if (!CopyFileRange(fd_.get(), position, entry.first, file.fd()) ||
+        !WriteFileDescriptor(file.fd(), entry.second.text.data(),
+                             entry.second.text.size())) {
+      return false;
+    }
+    position = entry.second.end;
+  }
+  return CopyFileRange(fd_.get(), position, size_, file.fd()) &&
+         file.Commit(durability);
+}
+
+bool PagedFile::ReadOriginal(uint64_t start,
+                             uint64_t end,
+                             std::vector<char>* buffer) const {
+  size_t offset = buffer->size();
+  buffer->resize(offset + (end - start));
+  while (start < end) {
+    ssize_t count = HANDLE_EINTR(
+        pread(fd_.get(), buffer->data() + offset, end - start, start));
+    if (count <= 0)
+      return false;
+    start += count;
+    offset += count;
+  }
+  return true;
+}
+
+void PagedFile::IndexOnThread() {
+  std::vector<char> block(kIndexBlockSize);
+  uint64_t position = 0;
+  uint64_t line_count = 0;
+  while (!cancelled_ && position < size_) {
+    TRACE_EVENT0("files", "PagedFile::IndexBlock");
+    ssize_t count =
+        HANDLE_EINTR(pread(fd_.get(), block.data(), block.size(), position));
+    if (count <= 0)
+      break;
+    std::vector<uint64_t> checkpoints;
+    const char* begin = block.data();
+    const char* end = begin + count;
+    for (const char* it = begin;
+         (it = static_cast<const char*>(memchr(it, '\n', end - it)));) {
+      ++it;
+      if (++line_count % kLinesPerCheckpoint == 0)
+        checkpoints.push_back(position + (it - begin));
+    }
+    position += count;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      checkpoints_.insert(checkpoints_.end(), checkpoints.begin(),
+                          checkpoints.end());
+    }
+    indexed_size_ = position;
+  }
+}
+
+}  // namespace zi
@@ -0,0 +1,110 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "files/atomic_file.h"
+#include "files/scoped_fd.h"
+#include "text/text_view.h"
+#include "zen/macros.h"
+
+namespace zi {
+
+// Gives access to a file that is too large to hold in memory. The file is read
+// a window at a time with pread, a sparse index of line offsets is built on a
+// background thread for navigation, and edits are held as overlays until the
+// file is written out. Offsets are in the coordinates of the file on disk.
+class PagedFile {
+ public:
+  // The index records the offset of every kLinesPerCheckpoint-th line.
+  static constexpr uint64_t kLinesPerCheckpoint = 1024;
+
+  // Returns null if |path| cannot be opened.
+  static std::unique_ptr<PagedFile> Open(const std::string& path);
+  // Stops indexing if the index is not complete.
+  ~PagedFile();
+
+  uint64_t size() const { return size_; }
+
+  // Reads about |length| bytes from |*start|, with the overlays applied, into
+  // |buffer| after |gap_size| bytes of gap. The window starts and ends on line
+  // boundaries and grows to cover every overlay it touches. On return,
+  // [*start, *end) is the part of the file the window covers.
+  bool ReadWindow(uint64_t length,
+                  uint64_t* start,
+                  uint64_t* end,
+                  std::vector<char>* buffer,
+                  size_t gap_size) const;
+
+  // Replaces [start, end) of the file with |text|. Overlays within the range
+  // are dropped.
+  void SetOverlay(uint64_t start, uint64_t end, const TextView& text);
+  bool is_modified() const { return !overlays_.empty(); }
+  // The memory the overlays take.
+  size_t overlay_size() const { return overlay_size_; }
+  // Where |offset| ends up once the overlays before it are applied.
+  uint64_t GetEditedOffset(uint64_t offset) const;
+
+  // Finds the last checkpoint indexed so far at or before the zero-based
+  // |line|. The first line is always a checkpoint.
+  void GetCheckpoint(uint64_t line,
+                     uint64_t* checkpoint_line,
+                     uint64_t* offset) const;
+  uint64_t indexed_size() const { return indexed_size_.load(); }
+  bool is_indexed() const { return indexed_size() == size_; }
+
+  // Writes the file with the overlays applied to |path| atomically.
+  bool WriteTo(const std::string& path,
+               Durability durability = Durability::FileAndDirectory) const;
+
+ private:
+  struct Overlay {
+    uint64_t end;
+    std::string text;
+  };
+
+  PagedFile(int fd, uint64_t size);
+
+  bool ReadOriginal(uint64_t start, uint64_t end, std::vector<char>* buffer)
+      const;
+  void IndexOnThread();
+
+  ScopedFD fd_;
+  const uint64_t size_;
+
+  // By start offset. Overlays never overlap.
+  std::map<uint64_t, Overlay> overlays_;
+  size_t overlay_size_ = 0;
+
+  mutable std::mutex lock_;
+  std::vector<uint64_t> checkpoints_;
+  std::atomic<uint64_t> indexed_size_;
+  std::atomic<bool> cancelled_;
+  std::thread index_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(PagedFile);
+};
+
+}  // namespace zi
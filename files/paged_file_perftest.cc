@@ -0,0 +1,51 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/paged_file.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "files/file_util.h"
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Saves a file of |arg| bytes after replacing one line in the middle, which is
+// mostly a copy of unchanged extents.
+void PagedFile_SaveSmallEdit(BenchmarkState* state) {
+  char path[] = "/tmp/zi_paged_file_perftest_XXXXXX";
+  int fd = mkstemp(path);
+  const std::string line(63, 'a');
+  for (size_t size = 0; size < state->arg(); size += line.size() + 1)
+    WriteFileDescriptor(fd, (line + "\n").data(), line.size() + 1);
+  close(fd);
+  const std::string saved_path = std::string(path) + ".saved";
+  std::unique_ptr<PagedFile> file = PagedFile::Open(path);
+  const uint64_t middle = state->arg() / 2 / 64 * 64;
+  file->SetOverlay(middle, middle + 64, TextView(std::string("edited\n")));
+  while (state->KeepRunning())
+    file->WriteTo(saved_path, Durability::None);
+  unlink(saved_path.c_str());
+  unlink(path);
+  state->SetBytesProcessed(state->iterations() * state->arg());
+}
+BENCHMARK(PagedFile_SaveSmallEdit, 1 << 20, 1 << 26, 1 << 28);
+
+}  // namespace
+}  // namespace zi
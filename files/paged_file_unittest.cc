@@ -0,0 +1,130 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/paged_file.h"
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "files/file_util.h"
+#include "files/test_file_util.h"
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+std::string MakeLines(int count) {
+  std::string contents;
+  for (int i = 0; i < count; ++i)
+    contents += "line " + std::to_string(i) + "\n";
+  return contents;
+}
+
+std::string ReadWindow(const PagedFile& file,
+                       uint64_t length,
+                       uint64_t* start,
+                       uint64_t* end) {
+  std::vector<char> buffer;
+  EXPECT_TRUE(file.ReadWindow(length, start, end, &buffer, 4));
+  EXPECT_LE(4u, buffer.size());
+  return std::string(buffer.begin() + 4, buffer.end());
+}
+
+TEST(PagedFile, WindowsEndOnLines) {
+  const std::string contents = MakeLines(100);
+  const std::string path = MakeTempFile("zi_paged_file", contents);
+  std::unique_ptr<PagedFile> file = PagedFile::Open(path);
+  unlink(path.c_str());
+  ASSERT_TRUE(file);
+  EXPECT_EQ(contents.size(), file->size());
+
+  uint64_t start = 0, end = 0;
+  EXPECT_EQ("line 0\nline 1\n", ReadWindow(*file, 16, &start, &end));
+  EXPECT_EQ(0u, start);
+  EXPECT_EQ(14u, end);
+
+  // A window that starts mid-line begins with the next line.
+  start = 16;
+  EXPECT_EQ("line 3\n", ReadWindow(*file, 14, &start, &end));
+  EXPECT_EQ(21u, start);
+  EXPECT_EQ(28u, end);
+
+  // Stepping from window to window covers the whole file.
+  std::string all;
+  for (start = 0; start < file->size(); start = end)
+    all += ReadWindow(*file, 100, &start, &end);
+  EXPECT_EQ(contents, all);
+}
+
+TEST(PagedFile, Overlays) {
+  const std::string path = MakeTempFile("zi_paged_file", MakeLines(10));
+  std::unique_ptr<PagedFile> file = PagedFile::Open(path);
+  ASSERT_TRUE(file);
+  EXPECT_FALSE(file->is_modified());
+
+  // Replace "line 1\nline 2\n".
+  file->SetOverlay(7, 21, TextView(std::string("one\n")));
+  EXPECT_TRUE(file->is_modified());
+  EXPECT_EQ(4u, file->overlay_size());
+  EXPECT_EQ(7u, file->GetEditedOffset(7));
+  EXPECT_EQ(11u, file->GetEditedOffset(21));
+
+  // A window that touches the overlay grows to cover it.
+  uint64_t start = 14, end = 0;
+  EXPECT_EQ("one\nline 3\n", ReadWindow(*file, 14, &start, &end));
+  EXPECT_EQ(7u, start);
+  EXPECT_EQ(28u, end);
+
+  start = 0;
+  EXPECT_EQ("line 0\none\nline 3\n", ReadWindow(*file, 28, &start, &end));
+
+  // A wider overlay replaces the ones inside it.
+  file->SetOverlay(0, 28, TextView(std::string("zero\n")));
+  EXPECT_EQ(5u, file->overlay_size());
+
+  EXPECT_TRUE(file->WriteTo(path));
+  std::vector<char> saved = ReadFile(path);
+  unlink(path.c_str());
+  EXPECT_EQ("zero\n" + MakeLines(10).substr(28),
+            std::string(saved.begin(), saved.end()));
+}
+
+TEST(PagedFile, Checkpoints) {
+  const std::string contents = MakeLines(5000);
+  const std::string path = MakeTempFile("zi_paged_file", contents);
+  std::unique_ptr<PagedFile> file = PagedFile::Open(path);
+  unlink(path.c_str());
+  ASSERT_TRUE(file);
+  while (!file->is_indexed())
+    usleep(1000);
+
+  uint64_t line = 0, offset = 0;
+  file->GetCheckpoint(3000, &line, &offset);
+  EXPECT_EQ(2 * PagedFile::kLinesPerCheckpoint, line);
+  EXPECT_EQ(MakeLines(line).size(), offset);
+  file->GetCheckpoint(10, &line, &offset);
+  EXPECT_EQ(0u, line);
+  EXPECT_EQ(0u, offset);
+  file->GetCheckpoint(100000, &line, &offset);
+  EXPECT_EQ(4 * PagedFile::kLinesPerCheckpoint, line);
+}
+
+TEST(PagedFile, MissingFile) {
+  EXPECT_FALSE(PagedFile::Open("/tmp/zi_paged_file_missing"));
+}
+
+}  // namespace
+}  // namespace zi
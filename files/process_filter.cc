@@ -0,0 +1,262 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/process_filter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <utility>
+
+#include "zen/trace_event.h"
+
+extern char** environ;
+
+namespace zi {
+namespace {
+
+// Bigger pipes mean fewer trips through the kernel for a large filter. The
+// output is read straight into the result, up to a pipe's worth at a time.
+constexpr int kPipeSize = 1 << 20;
+constexpr size_t kReadSize = kPipeSize;
+
+bool MakePipe(int fds[2]) {
+  return pipe2(fds, O_CLOEXEC) == 0;
+}
+
+// Makes |fd| non-blocking and its pipe bigger, if the kernel lets us.
+void PrepareParentEnd(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  fcntl(fd, F_SETPIPE_SZ, kPipeSize);
+}
+
+}  // namespace
+
+std::unique_ptr<ProcessFilter> ProcessFilter::Start(const std::string& command,
+                                                    TextSnapshot input) {
+  int input_fds[2];
+  if (!MakePipe(input_fds))
+    return nullptr;
+  ScopedFD input_read_fd(input_fds[0]);
+  ScopedFD input_write_fd(input_fds[1]);
+  int output_fds[2];
+  if (!MakePipe(output_fds))
+    return nullptr;
+  ScopedFD output_read_fd(output_fds[0]);
+  ScopedFD output_write_fd(output_fds[1]);
+  int ready_fds[2];
+  if (pipe2(ready_fds, O_NONBLOCK | O_CLOEXEC) == -1)
+    return nullptr;
+  ScopedFD ready_read_fd(ready_fds[0]);
+  ScopedFD ready_write_fd(ready_fds[1]);
+  int cancel_fds[2];
+  if (pipe2(cancel_fds, O_NONBLOCK | O_CLOEXEC) == -1)
+    return nullptr;
+  ScopedFD cancel_read_fd(cancel_fds[0]);
+  ScopedFD cancel_write_fd(cancel_fds[1]);
+
+  // The descriptors are close-on-exec, so the command only gets the ends that
+  // are duplicated onto its standard streams.
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, input_read_fd.get(), 0);
+  posix_spawn_file_actions_adddup2(&actions, output_write_fd.get(), 1);
+  posix_spawn_file_actions_adddup2(&actions, output_write_fd.get(), 2);
+  std::string shell_command = command;
+  char* argv[] = {const_cast<char*>("/bin/sh"), const_cast<char*>("-c"),
+                  &shell_command[0], nullptr};
+  pid_t pid = 0;
+  const int error =
+      posix_spawn(&pid, "/bin/sh", &actions, nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (error)
+    return nullptr;
+
+  PrepareParentEnd(input_write_fd.get());
+  PrepareParentEnd(output_read_fd.get());
+  std::unique_ptr<ProcessFilter> filter(new ProcessFilter(
+      pid, std::move(input), input_write_fd.release(),
+      output_read_fd.release(), ready_read_fd.release(),
+      ready_write_fd.release(), cancel_read_fd.release(),
+      cancel_write_fd.release()));
+  filter->thread_ = std::thread(&ProcessFilter::RunOnThread, filter.get());
+  return filter;
+}
+
+ProcessFilter::ProcessFilter(pid_t pid,
+                             TextSnapshot input,
+                             int input_fd,
+                             int output_fd,
+                             int ready_read_fd,
+                             int ready_write_fd,
+                             int cancel_read_fd,
+                             int cancel_write_fd)
+    : pid_(pid),
+      input_(std::move(input)),
+      input_fd_(input_fd),
+      output_fd_(output_fd),
+      ready_read_fd_(ready_read_fd),
+      ready_write_fd_(ready_write_fd),
+      cancel_read_fd_(cancel_read_fd),
+      cancel_write_fd_(cancel_write_fd) {}
+
+ProcessFilter::~ProcessFilter() {
+  char byte = 0;
+  HANDLE_EINTR(write(cancel_write_fd_.get(), &byte, 1));
+  // The thread stops watching the cancel pipe once the output is closed, but
+  // the command can close it and keep running.
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (!reaped_)
+      kill(pid_, SIGKILL);
+  }
+  Wait();
+}
+
+bool ProcessFilter::TakeResult(Result* result) {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (!finished_)
+    return false;
+  *result = std::move(result_);
+  return true;
+}
+
+void ProcessFilter::Wait() {
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void ProcessFilter::RunOnThread() {
+  TRACE_EVENT0("files", "ProcessFilter::Run");
+  // A command that exits without reading all of its input must not kill the
+  // editor with SIGPIPE. The signal goes to the thread that writes, and a
+  // blocked signal that is still pending when the thread exits is dropped.
+  sigset_t sigpipe;
+  sigemptyset(&sigpipe);
+  sigaddset(&sigpipe, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+
+  // Filters tend to write about as much as they read.
+  result_.output.reserve(input_.size() + kReadSize);
+  size_t written = 0;
+  if (!input_.size())
+    input_fd_.reset();
+  bool cancelled = false;
+  while (output_fd_.is_valid()) {
+    struct pollfd fds[3] = {
+        {output_fd_.get(), POLLIN, 0},
+        {input_fd_.get(), POLLOUT, 0},
+        {cancel_read_fd_.get(), POLLIN, 0},
+    };
+    if (poll(fds, 3, -1) == -1) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    if (fds[2].revents) {
+      cancelled = true;
+      break;
+    }
+    if (fds[1].revents && !WriteInput(&written))
+      input_fd_.reset();
+    if (fds[0].revents && !ReadOutput())
+      output_fd_.reset();
+  }
+  if (cancelled)
+    kill(pid_, SIGKILL);
+  input_fd_.reset();
+  output_fd_.reset();
+
+  // Waits without reaping, so that the destructor can still kill the command
+  // by its pid while this thread waits.
+  siginfo_t info;
+  HANDLE_EINTR(waitid(P_PID, pid_, &info, WEXITED | WNOWAIT));
+  int status = 0;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    HANDLE_EINTR(waitpid(pid_, &status, 0));
+    reaped_ = true;
+  }
+  // Nothing reads the pipe once the command is gone, so the pages that were
+  // spliced into it are no longer needed.
+  input_ = TextSnapshot();
+  result_.exit_status =
+      WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    finished_ = true;
+  }
+  char byte = 0;
+  HANDLE_EINTR(write(ready_write_fd_.get(), &byte, 1));
+}
+
+// Writes as much of the input as the pipe takes. Returns false once the input
+// is all written or the command stops reading it.
+bool ProcessFilter::WriteInput(size_t* written) {
+  const TextView& text = input_.text();
+  struct iovec pieces[2];
+  int count = 0;
+  size_t offset = *written;
+  for (const StringView& half : {text.left(), text.right()}) {
+    if (offset >= half.length()) {
+      offset -= half.length();
+      continue;
+    }
+    pieces[count].iov_base = const_cast<char*>(half.data() + offset);
+    pieces[count].iov_len = half.length() - offset;
+    ++count;
+    offset = 0;
+  }
+  ssize_t result = -1;
+  if (can_splice_) {
+    result = HANDLE_EINTR(
+        vmsplice(input_fd_.get(), pieces, count, SPLICE_F_NONBLOCK));
+    // Not every file system or kernel can splice; write instead.
+    if (result == -1 && errno != EAGAIN && errno != EPIPE) {
+      can_splice_ = false;
+      result = HANDLE_EINTR(writev(input_fd_.get(), pieces, count));
+    }
+  } else {
+    result = HANDLE_EINTR(writev(input_fd_.get(), pieces, count));
+  }
+  if (result == -1)
+    return errno == EAGAIN;
+  *written += result;
+  return *written < text.length();
+}
+
+// Reads what the command wrote so far. Returns false at the end of the output.
+bool ProcessFilter::ReadOutput() {
+  std::vector<char>& output = result_.output;
+  const size_t size = output.size();
+  if (output.capacity() - size < kReadSize)
+    output.reserve(std::max(output.capacity() * 2, size + kReadSize));
+  output.resize(size + kReadSize);
+  const ssize_t count =
+      HANDLE_EINTR(read(output_fd_.get(), &output[size], kReadSize));
+  output.resize(size + std::max<ssize_t>(count, 0));
+  if (count == -1)
+    return errno == EAGAIN;
+  return count > 0;
+}
+
+}  // namespace zi
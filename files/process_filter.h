@@ -0,0 +1,101 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "files/scoped_fd.h"
+#include "text/text_snapshot.h"
+#include "zen/macros.h"
+
+namespace zi {
+
+// Pipes text through a shell command, e.g., "sort", and collects what the
+// command writes. A background thread feeds the command and reads its output
+// at the same time, so neither side can fill its pipe and stall the other,
+// and the editor stays responsive while a long filter runs.
+class ProcessFilter {
+ public:
+  struct Result {
+    // What the command wrote to its standard output and standard error.
+    std::vector<char> output;
+    // The exit status of the command, or 128 plus the signal that killed it.
+    int exit_status = 0;
+  };
+
+  // Runs |command| with /bin/sh, feeding it |input|. The input goes to the
+  // pipe straight from the snapshot without being copied, so the filter keeps
+  // the snapshot until the command exits. Returns null if the command cannot
+  // be started.
+  static std::unique_ptr<ProcessFilter> Start(const std::string& command,
+                                              TextSnapshot input);
+  // Kills the command if it is still running.
+  ~ProcessFilter();
+
+  // Becomes readable once the command finishes, for use with poll().
+  int ready_fd() const { return ready_read_fd_.get(); }
+
+  // Takes the result without blocking. Returns false if the command is still
+  // running.
+  bool TakeResult(Result* result);
+  // Blocks until the command finishes.
+  void Wait();
+
+ private:
+  ProcessFilter(pid_t pid,
+                TextSnapshot input,
+                int input_fd,
+                int output_fd,
+                int ready_read_fd,
+                int ready_write_fd,
+                int cancel_read_fd,
+                int cancel_write_fd);
+
+  void RunOnThread();
+  bool WriteInput(size_t* written);
+  bool ReadOutput();
+
+  const pid_t pid_;
+  TextSnapshot input_;
+  ScopedFD input_fd_;
+  ScopedFD output_fd_;
+  ScopedFD ready_read_fd_;
+  ScopedFD ready_write_fd_;
+  ScopedFD cancel_read_fd_;
+  ScopedFD cancel_write_fd_;
+  // Whether to write the input with vmsplice, which maps the pages of the
+  // snapshot into the pipe instead of copying them.
+  bool can_splice_ = true;
+
+  std::mutex lock_;
+  // Set once the command is reaped, after which its pid may be reused and
+  // must not be killed.
+  bool reaped_ = false;
+  bool finished_ = false;
+  Result result_;
+
+  std::thread thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProcessFilter);
+};
+
+}  // namespace zi
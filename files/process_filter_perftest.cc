@@ -0,0 +1,40 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/process_filter.h"
+
+#include <string>
+#include <vector>
+
+#include "text/text_buffer.h"
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Pipes a buffer of |arg| bytes, split by a gap in the middle, through cat.
+void ProcessFilter_Cat(BenchmarkState* state) {
+  TextBuffer text(std::vector<char>(state->arg(), 'a'));
+  text.InsertCharacter(TextPosition(state->arg() / 2), '\n');
+  while (state->KeepRunning()) {
+    std::unique_ptr<ProcessFilter> filter =
+        ProcessFilter::Start("cat", text.Snapshot());
+    filter->Wait();
+  }
+  state->SetBytesProcessed(state->iterations() * text.size());
+}
+BENCHMARK(ProcessFilter_Cat, 1 << 16, 1 << 28);
+
+}  // namespace
+}  // namespace zi
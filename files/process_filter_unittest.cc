@@ -0,0 +1,94 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/process_filter.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+std::string Filter(const std::string& command,
+                   const std::string& input,
+                   int* exit_status) {
+  std::unique_ptr<ProcessFilter> filter =
+      ProcessFilter::Start(command, TextSnapshot(input));
+  EXPECT_TRUE(filter);
+  if (!filter)
+    return std::string();
+  filter->Wait();
+  ProcessFilter::Result result;
+  EXPECT_TRUE(filter->TakeResult(&result));
+  *exit_status = result.exit_status;
+  return std::string(result.output.begin(), result.output.end());
+}
+
+TEST(ProcessFilter, Filters) {
+  int exit_status = -1;
+  EXPECT_EQ("a\nb\nc\n", Filter("sort", "c\na\nb\n", &exit_status));
+  EXPECT_EQ(0, exit_status);
+  EXPECT_EQ("", Filter("cat", "", &exit_status));
+  EXPECT_EQ(0, exit_status);
+  EXPECT_EQ("oops\n", Filter("echo oops >&2; exit 3", "x", &exit_status));
+  EXPECT_EQ(3, exit_status);
+}
+
+TEST(ProcessFilter, ReadsWhileWriting) {
+  // Far more than a pipe holds in either direction.
+  std::string input;
+  for (int i = 0; i < 1 << 20; ++i)
+    input += "line " + std::to_string(i) + "\n";
+  int exit_status = -1;
+  EXPECT_EQ(input, Filter("cat", input, &exit_status));
+  EXPECT_EQ(0, exit_status);
+}
+
+TEST(ProcessFilter, CommandThatIgnoresInput) {
+  int exit_status = -1;
+  EXPECT_EQ("done\n", Filter("echo done", std::string(8 << 20, 'x'),
+                             &exit_status));
+  EXPECT_EQ(0, exit_status);
+}
+
+TEST(ProcessFilter, Cancels) {
+  const auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<ProcessFilter> filter =
+      ProcessFilter::Start("sleep 10", TextSnapshot("x"));
+  ASSERT_TRUE(filter);
+  ProcessFilter::Result result;
+  EXPECT_FALSE(filter->TakeResult(&result));
+  filter.reset();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(ProcessFilter, CancelsAfterOutputCloses) {
+  std::unique_ptr<ProcessFilter> filter = ProcessFilter::Start(
+      "exec >/dev/null 2>&1 </dev/null; sleep 10", TextSnapshot("x"));
+  ASSERT_TRUE(filter);
+  // Give the command time to close its output.
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  ProcessFilter::Result result;
+  EXPECT_FALSE(filter->TakeResult(&result));
+  const auto start = std::chrono::steady_clock::now();
+  filter.reset();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+}  // namespace
+}  // namespace zi
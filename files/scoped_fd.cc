@@ -25,4 +25,16 @@ ScopedFD::~ScopedFD() {
     close(fd_);
 }
 
+void ScopedFD::reset(int fd) {
+  if (is_valid())
+    close(fd_);
+  fd_ = fd;
+}
+
+int ScopedFD::release() {
+  const int fd = fd_;
+  fd_ = -1;
+  return fd;
+}
+
 }  // namespace zi
@@ -26,6 +26,11 @@ class ScopedFD {
   bool is_valid() const { return fd_ != -1; }
   int get() const { return fd_; }
 
+  // Closes the current descriptor, if any, and takes ownership of |fd|.
+  void reset(int fd = -1);
+  // Gives up ownership of the descriptor without closing it.
+  int release();
+
  private:
   int fd_;
 
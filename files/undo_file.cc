@@ -0,0 +1,441 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/undo_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "text/text_buffer.h"
+#include "zen/macros.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+namespace {
+
+// The magic is padded to keep the entries after it aligned.
+const char kMagic[] = "zi-undo 1\n";
+constexpr uint64_t kHeaderSize = 16;
+
+// Fields are in native byte order and every entry is a multiple of eight
+// bytes long, so entries can be read straight out of the mapping. Each entry
+// also ends with its length so that the file can be walked backward.
+constexpr uint32_t kRecordType = 'R';
+constexpr uint32_t kKeyType = 'K';
+
+struct RecordHeader {
+  uint32_t type;
+  uint32_t flags;
+  uint64_t offset;
+  uint64_t deleted_length;
+  uint64_t inserted_length;
+  // Followed by the deleted and the inserted bytes, padding and the length.
+};
+constexpr uint32_t kStartsStep = 1;
+
+struct KeyEntry {
+  uint32_t type;
+  uint32_t flags;
+  uint64_t inode;
+  uint64_t size;
+  uint64_t hash;
+  uint64_t length;
+};
+// A later session started from this key without checking it against its
+// text, so whoever undoes past the key has to.
+constexpr uint32_t kUnverified = 1;
+
+constexpr uint64_t kTrailerSize = sizeof(uint64_t);
+constexpr uint64_t kMinEntrySize = sizeof(RecordHeader) + kTrailerSize;
+
+uint64_t PadTo8(uint64_t size) {
+  return (size + 7) & ~uint64_t(7);
+}
+
+uint64_t GetRecordLength(const RecordHeader& header) {
+  return sizeof(RecordHeader) +
+         PadTo8(header.deleted_length + header.inserted_length) +
+         kTrailerSize;
+}
+
+bool ReadAt(int fd, void* data, size_t size, uint64_t offset) {
+  return HANDLE_EINTR(pread(fd, data, size, offset)) ==
+         static_cast<ssize_t>(size);
+}
+
+bool WriteAt(int fd, const void* data, size_t size, uint64_t offset) {
+  const char* bytes = static_cast<const char*>(data);
+  for (size_t total = 0; total < size;) {
+    ssize_t count =
+        HANDLE_EINTR(pwrite(fd, bytes + total, size - total, offset + total));
+    if (count <= 0)
+      return false;
+    total += count;
+  }
+  return true;
+}
+
+void Replace(TextBuffer* text,
+             size_t offset,
+             size_t delete_length,
+             const char* insert_begin,
+             size_t insert_length) {
+  if (delete_length)
+    text->DeleteRange(TextBufferRange(offset, offset + delete_length));
+  if (insert_length) {
+    text->InsertText(TextPosition(offset),
+                     StringView(insert_begin, insert_begin + insert_length));
+  }
+}
+
+// Mixes the bytes in eight at a time. Words may straddle the calls to
+// Update, so the hash only depends on the sequence of bytes.
+class Hasher {
+ public:
+  void Update(const StringView& data) {
+    const char* begin = data.begin();
+    const char* end = data.end();
+    while (pending_length_ != 0 && begin < end)
+      AddByte(*begin++);
+    for (; end - begin >= 8; begin += 8) {
+      uint64_t word;
+      memcpy(&word, begin, sizeof(word));
+      Mix(word);
+    }
+    while (begin < end)
+      AddByte(*begin++);
+    length_ += data.length();
+  }
+
+  uint64_t Finish() {
+    Mix(pending_);
+    Mix(length_);
+    return state_;
+  }
+
+ private:
+  void AddByte(char c) {
+    const uint64_t byte = static_cast<unsigned char>(c);
+    pending_ |= byte << (8 * pending_length_);
+    if (++pending_length_ == 8) {
+      Mix(pending_);
+      pending_ = 0;
+      pending_length_ = 0;
+    }
+  }
+
+  void Mix(uint64_t word) {
+    state_ = (state_ ^ word) * 0xff51afd7ed558ccdull;
+    state_ ^= state_ >> 32;
+  }
+
+  uint64_t state_ = 0x9e3779b97f4a7c15ull;
+  uint64_t pending_ = 0;
+  size_t pending_length_ = 0;
+  uint64_t length_ = 0;
+};
+
+}  // namespace
+
+std::unique_ptr<UndoFile> UndoFile::Open(const std::string& path,
+                                         const std::string& file_path) {
+  int fd = HANDLE_EINTR(open(path.c_str(), O_RDWR | O_CLOEXEC));
+  if (fd == -1 && errno != ENOENT)
+    return nullptr;
+  std::unique_ptr<UndoFile> file(new UndoFile(path, fd));
+  struct stat info;
+  struct stat file_info;
+  char magic[kHeaderSize];
+  KeyEntry key;
+  if (fd != -1 && fstat(fd, &info) == 0 &&
+      stat(file_path.c_str(), &file_info) == 0 &&
+      static_cast<uint64_t>(info.st_size) >= kHeaderSize + sizeof(key) &&
+      info.st_size % 8 == 0 && ReadAt(fd, magic, sizeof(magic), 0) &&
+      memcmp(magic, kMagic, sizeof(kMagic)) == 0 &&
+      ReadAt(fd, &key, sizeof(key), info.st_size - sizeof(key)) &&
+      key.type == kKeyType && key.length == sizeof(key) &&
+      key.inode == file_info.st_ino &&
+      key.size == static_cast<uint64_t>(file_info.st_size)) {
+    file->cursor_ = info.st_size;
+    file->end_ = info.st_size;
+    file->session_key_ = info.st_size - sizeof(key);
+    file->last_key_ = file->session_key_;
+  }
+  return file;
+}
+
+UndoFile::UndoFile(const std::string& path, int fd)
+    : path_(path),
+      fd_(fd),
+      floor_(kHeaderSize),
+      cursor_(kHeaderSize),
+      end_(kHeaderSize) {}
+
+UndoFile::~UndoFile() {
+  if (map_)
+    munmap(const_cast<char*>(map_), map_size_);
+}
+
+uint64_t UndoFile::HashText(const TextView& text) {
+  Hasher hasher;
+  hasher.Update(text.left());
+  hasher.Update(text.right());
+  return hasher.Finish();
+}
+
+bool UndoFile::Undo(TextBuffer* text, size_t* offset) {
+  if (failed_ || !Map())
+    return false;
+  TRACE_EVENT0("files", "UndoFile::Undo");
+  uint64_t position = cursor_;
+  uint64_t start = 0;
+  bool undone = false;
+  while (GetEntryBefore(position, &start)) {
+    const char* entry = map_ + start;
+    uint32_t type;
+    memcpy(&type, entry, sizeof(type));
+    if (type == kKeyType) {
+      if (undone)
+        break;
+      // The history before a key that does not match is of no use.
+      if (position - start != sizeof(KeyEntry) || !VerifyKey(start, text)) {
+        floor_ = position;
+        break;
+      }
+      position = start;
+      continue;
+    }
+    RecordHeader header;
+    memcpy(&header, entry, sizeof(header));
+    // The lengths are checked on their own first so that adding them up
+    // cannot wrap around.
+    const uint64_t length = position - start;
+    if (type != kRecordType || header.deleted_length > length ||
+        header.inserted_length > length ||
+        GetRecordLength(header) != length ||
+        header.offset + header.inserted_length > text->size()) {
+      floor_ = position;
+      break;
+    }
+    const char* deleted = entry + sizeof(header);
+    Replace(text, header.offset, header.inserted_length, deleted,
+            header.deleted_length);
+    *offset = header.offset;
+    undone = true;
+    position = start;
+    if (header.flags & kStartsStep)
+      break;
+  }
+  if (undone)
+    cursor_ = position;
+  return undone;
+}
+
+bool UndoFile::Redo(TextBuffer* text, size_t* offset) {
+  if (failed_ || !Map())
+    return false;
+  TRACE_EVENT0("files", "UndoFile::Redo");
+  uint64_t position = cursor_;
+  uint64_t length = 0;
+  bool redone = false;
+  while (GetEntryLength(position, &length)) {
+    const char* entry = map_ + position;
+    uint32_t type;
+    memcpy(&type, entry, sizeof(type));
+    if (type == kKeyType) {
+      position += length;
+      continue;
+    }
+    RecordHeader header;
+    memcpy(&header, entry, sizeof(header));
+    if ((redone && (header.flags & kStartsStep)) ||
+        header.offset + header.deleted_length > text->size())
+      break;
+    const char* deleted = entry + sizeof(header);
+    Replace(text, header.offset, header.deleted_length,
+            deleted + header.deleted_length, header.inserted_length);
+    if (!redone)
+      *offset = header.offset;
+    redone = true;
+    position += length;
+  }
+  if (redone)
+    cursor_ = position;
+  return redone;
+}
+
+void UndoFile::Append(size_t offset,
+                      const StringView& deleted,
+                      const StringView& inserted,
+                      bool starts_step) {
+  RecordHeader header;
+  header.type = kRecordType;
+  header.flags = starts_step ? kStartsStep : 0;
+  header.offset = offset;
+  header.deleted_length = deleted.length();
+  header.inserted_length = inserted.length();
+  const uint64_t length = GetRecordLength(header);
+  const size_t text_length = deleted.length() + inserted.length();
+  pending_.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  pending_.append(deleted.begin(), deleted.length());
+  pending_.append(inserted.begin(), inserted.length());
+  pending_.append(PadTo8(text_length) - text_length, '\0');
+  pending_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+}
+
+void UndoFile::DiscardRedo() {
+  end_ = cursor_;
+}
+
+void UndoFile::Clear() {
+  floor_ = kHeaderSize;
+  cursor_ = kHeaderSize;
+  end_ = kHeaderSize;
+  session_key_ = 0;
+  last_key_ = 0;
+  pending_.clear();
+}
+
+bool UndoFile::WriteKey(uint64_t size) {
+  if (failed_)
+    return false;
+  TRACE_EVENT0("files", "UndoFile::WriteKey");
+  if (!fd_.is_valid()) {
+    fd_.reset(HANDLE_EINTR(
+        open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600)));
+    if (!fd_.is_valid()) {
+      failed_ = true;
+      return false;
+    }
+  }
+  if (session_key_ && session_key_ < end_) {
+    const uint32_t flags = kUnverified;
+    if (!WriteAt(fd_.get(), &flags, sizeof(flags),
+                 session_key_ + offsetof(KeyEntry, flags))) {
+      failed_ = true;
+      return false;
+    }
+    session_key_ = 0;
+  }
+  KeyEntry key;
+  key.type = kKeyType;
+  key.flags = 0;
+  // Filled in by ConfirmKey once the save is on disk.
+  key.inode = 0;
+  key.size = size;
+  key.hash = 0;
+  key.length = sizeof(key);
+  pending_.append(reinterpret_cast<const char*>(&key), sizeof(key));
+  char header[kHeaderSize] = {};
+  memcpy(header, kMagic, sizeof(kMagic));
+  const bool written =
+      (end_ > kHeaderSize || WriteAt(fd_.get(), header, kHeaderSize, 0)) &&
+      WriteAt(fd_.get(), pending_.data(), pending_.size(), end_) &&
+      HANDLE_EINTR(ftruncate(fd_.get(), end_ + pending_.size())) == 0;
+  if (!written) {
+    failed_ = true;
+    return false;
+  }
+  end_ += pending_.size();
+  cursor_ = end_;
+  last_key_ = end_ - sizeof(key);
+  std::string().swap(pending_);
+  return true;
+}
+
+void UndoFile::ConfirmKey(const std::string& file_path, uint64_t hash) {
+  struct stat info;
+  if (failed_ || !last_key_ || last_key_ >= end_ ||
+      stat(file_path.c_str(), &info) == -1)
+    return;
+  // The hash goes first: Open only trusts a key whose inode matches.
+  const uint64_t inode = info.st_ino;
+  if (WriteAt(fd_.get(), &hash, sizeof(hash),
+              last_key_ + offsetof(KeyEntry, hash)))
+    WriteAt(fd_.get(), &inode, sizeof(inode),
+            last_key_ + offsetof(KeyEntry, inode));
+}
+
+// Maps up to |end_|. Pages are only read as the entries on them are.
+bool UndoFile::Map() {
+  if (map_size_ >= end_)
+    return true;
+  if (map_)
+    munmap(const_cast<char*>(map_), map_size_);
+  map_ = nullptr;
+  map_size_ = 0;
+  void* map = mmap(nullptr, end_, PROT_READ, MAP_SHARED, fd_.get(), 0);
+  if (map == MAP_FAILED)
+    return false;
+  map_ = static_cast<const char*>(map);
+  map_size_ = end_;
+  return true;
+}
+
+bool UndoFile::GetEntryBefore(uint64_t position, uint64_t* start) const {
+  if (position < floor_ + kMinEntrySize)
+    return false;
+  uint64_t length;
+  memcpy(&length, map_ + position - kTrailerSize, sizeof(length));
+  if (length < kMinEntrySize || length > position - floor_ || length % 8)
+    return false;
+  *start = position - length;
+  return true;
+}
+
+bool UndoFile::GetEntryLength(uint64_t position, uint64_t* length) const {
+  if (position + kMinEntrySize > end_)
+    return false;
+  const char* entry = map_ + position;
+  uint32_t type;
+  memcpy(&type, entry, sizeof(type));
+  if (type == kKeyType) {
+    *length = sizeof(KeyEntry);
+  } else if (type == kRecordType) {
+    RecordHeader header;
+    memcpy(&header, entry, sizeof(header));
+    if (header.deleted_length > end_ || header.inserted_length > end_)
+      return false;
+    *length = GetRecordLength(header);
+  } else {
+    return false;
+  }
+  return *length <= end_ - position;
+}
+
+// Keys from the same session as the steps after them are trusted. The others
+// are checked against the text the first time they are crossed.
+bool UndoFile::VerifyKey(uint64_t start, TextBuffer* text) {
+  KeyEntry key;
+  memcpy(&key, map_ + start, sizeof(key));
+  if (start != session_key_ && !(key.flags & kUnverified))
+    return true;
+  if (key.size != text->size() || key.hash != HashText(text->GetText()))
+    return false;
+  if (key.flags & kUnverified) {
+    const uint32_t flags = 0;
+    WriteAt(fd_.get(), &flags, sizeof(flags),
+            start + offsetof(KeyEntry, flags));
+  }
+  if (start == session_key_)
+    session_key_ = 0;
+  return true;
+}
+
+}  // namespace zi
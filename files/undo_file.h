@@ -0,0 +1,112 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "files/scoped_fd.h"
+#include "text/text_view.h"
+#include "text/undo_archive.h"
+#include "zen/macros.h"
+
+namespace zi {
+
+// Keeps the undo history of a file on disk so that it survives restarts. The
+// file "foo.undo" holds the steps of every session, oldest first, with a key
+// after the steps of each save: the inode, size and content hash of the file
+// as it was saved. Reopening reuses the history only if its last key names
+// the file as it is on disk.
+//
+// The steps are written incrementally, appended at each save, and read
+// through a mapping of the file. Opening only reads the last key, and nothing
+// else is read until the user undoes past the start of the session, so a long
+// history costs nothing up front. Crossing the key where a session started
+// hashes the text to make sure the history really leads up to it.
+class UndoFile : public UndoArchive {
+ public:
+  // Opens the history at |path| for the file at |file_path|. Starts a new
+  // history if the one at |path| is missing or belongs to another version of
+  // the file. The file is only created once there is a key to write. Returns
+  // null if |path| exists but cannot be opened for writing.
+  static std::unique_ptr<UndoFile> Open(const std::string& path,
+                                        const std::string& file_path);
+  ~UndoFile() override;
+
+  // A hash of the bytes of |text| that does not depend on where its gap is.
+  static uint64_t HashText(const TextView& text);
+
+  // UndoArchive:
+  bool Undo(TextBuffer* text, size_t* offset) override;
+  bool Redo(TextBuffer* text, size_t* offset) override;
+  void Append(size_t offset,
+              const StringView& deleted,
+              const StringView& inserted,
+              bool starts_step) override;
+  void DiscardRedo() override;
+  void Clear() override;
+
+  // Writes the records appended since the last key, followed by a key for
+  // the |size| bytes that are about to be saved. Returns false if the history
+  // cannot be written, after which it no longer changes.
+  bool WriteKey(uint64_t size);
+  // Records the inode of the file at |file_path| and the HashText of its
+  // contents in the last key, once the save that key describes is on disk.
+  // Hashing is left to whoever writes the file, so that it can happen off
+  // the main thread.
+  void ConfirmKey(const std::string& file_path, uint64_t hash);
+
+  // The bytes of history on disk that can still be reached.
+  uint64_t size() const { return end_; }
+
+ private:
+  UndoFile(const std::string& path, int fd);
+
+  bool Map();
+  bool GetEntryBefore(uint64_t position, uint64_t* start) const;
+  bool GetEntryLength(uint64_t position, uint64_t* length) const;
+  bool VerifyKey(uint64_t start, TextBuffer* text);
+
+  const std::string path_;
+  ScopedFD fd_;
+  bool failed_ = false;
+
+  // The file is mapped read-only, and remapped once it grows past the
+  // mapping.
+  const char* map_ = nullptr;
+  uint64_t map_size_ = 0;
+
+  // The entries in [floor_, end_) can be reached. The ones before |cursor_|
+  // are redone and the ones after it are undone.
+  uint64_t floor_;
+  uint64_t cursor_;
+  uint64_t end_;
+
+  // The last key when the file was opened, which has not been checked against
+  // the text yet, or zero.
+  uint64_t session_key_ = 0;
+  // The last key written, or zero.
+  uint64_t last_key_ = 0;
+
+  // The records appended since the last key.
+  std::string pending_;
+
+  DISALLOW_COPY_AND_ASSIGN(UndoFile);
+};
+
+}  // namespace zi
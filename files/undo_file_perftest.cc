@@ -0,0 +1,56 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/undo_file.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "files/file_util.h"
+#include "text/text_buffer.h"
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Opens a file with |arg| bytes of history, which only reads its last key.
+void UndoFile_Open(BenchmarkState* state) {
+  char path[] = "/tmp/zi_undo_file_perftest_XXXXXX";
+  int fd = mkstemp(path);
+  close(fd);
+  const std::string undo_path = std::string(path) + ".undo";
+  TextBuffer text(std::vector<char>(1 << 10, 'a'));
+  {
+    std::unique_ptr<UndoFile> file = UndoFile::Open(undo_path, path);
+    const std::string inserted(1 << 20, 'x');
+    for (size_t size = 0; size < state->arg(); size += inserted.size())
+      file->Append(0, StringView(), inserted, true);
+    file->WriteKey(text.size());
+    WriteAtomically(path, text.GetText(), Durability::None);
+    file->ConfirmKey(path, UndoFile::HashText(text.GetText()));
+  }
+  std::unique_ptr<UndoFile> file;
+  while (state->KeepRunning())
+    file = UndoFile::Open(undo_path, path);
+  unlink(undo_path.c_str());
+  unlink(path);
+  state->SetItemsProcessed(state->iterations());
+}
+BENCHMARK(UndoFile_Open, 1 << 20, 1 << 24, 1 << 28);
+
+}  // namespace
+}  // namespace zi
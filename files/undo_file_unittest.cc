@@ -0,0 +1,197 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "files/undo_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "files/file_util.h"
+#include "gtest/gtest.h"
+#include "text/text_buffer.h"
+#include "text/undo_history.h"
+
+namespace zi {
+namespace {
+
+std::string GetFilePath() {
+  return "/tmp/zi_undo_file_" + std::to_string(getpid());
+}
+
+// An editing session on the file at |path|, with its history in
+// |path|.undo.
+class Session {
+ public:
+  explicit Session(const std::string& path)
+      : path_(path),
+        text_(ReadFile(path)),
+        history_(1 << 20),
+        undo_file_(UndoFile::Open(path + ".undo", path)) {
+    history_.SetArchive(undo_file_.get());
+    text_.AddObserver(&history_);
+  }
+
+  ~Session() { text_.RemoveObserver(&history_); }
+
+  void Save() {
+    history_.ArchiveSteps();
+    EXPECT_TRUE(undo_file_->WriteKey(text_.size()));
+    EXPECT_TRUE(WriteAtomically(path_, text_.GetText()));
+    undo_file_->ConfirmKey(path_, UndoFile::HashText(text_.GetText()));
+  }
+
+  bool Undo() {
+    size_t offset = 0;
+    return history_.Undo(&text_, &offset);
+  }
+
+  bool Redo() {
+    size_t offset = 0;
+    return history_.Redo(&text_, &offset);
+  }
+
+  TextBuffer* text() { return &text_; }
+  UndoFile* undo_file() { return undo_file_.get(); }
+
+ private:
+  std::string path_;
+  TextBuffer text_;
+  UndoHistory history_;
+  std::unique_ptr<UndoFile> undo_file_;
+};
+
+class UndoFileTest : public ::testing::Test {
+ protected:
+  UndoFileTest() : path_(GetFilePath()) {
+    TextBuffer text(std::vector<char>{'h', 'e', 'l', 'l', 'o', '\n'});
+    WriteAtomically(path_, text.GetText());
+    unlink((path_ + ".undo").c_str());
+  }
+
+  ~UndoFileTest() override {
+    unlink(path_.c_str());
+    unlink((path_ + ".undo").c_str());
+  }
+
+  // Edits and saves the file in a session of its own.
+  void EditAndSave() {
+    Session session(path_);
+    TextBuffer* text = session.text();
+    text->InsertText(TextPosition(5), std::string(", world"));
+    text->DeleteRange(TextBufferRange(0, 1));
+    text->InsertCharacter(TextPosition(0), 'j');
+    session.Save();
+    // Edits that are not saved are not kept.
+    text->InsertCharacter(TextPosition(0), '>');
+  }
+
+  const std::string path_;
+};
+
+TEST_F(UndoFileTest, KeepsHistoryAcrossSessions) {
+  EditAndSave();
+  Session session(path_);
+  EXPECT_EQ("jello, world\n", session.text()->ToString());
+  EXPECT_TRUE(session.Undo());
+  EXPECT_EQ("ello, world\n", session.text()->ToString());
+  EXPECT_TRUE(session.Undo());
+  EXPECT_EQ("hello, world\n", session.text()->ToString());
+  EXPECT_TRUE(session.Undo());
+  EXPECT_EQ("hello\n", session.text()->ToString());
+  EXPECT_FALSE(session.Undo());
+  EXPECT_TRUE(session.Redo());
+  EXPECT_TRUE(session.Redo());
+  EXPECT_TRUE(session.Redo());
+  EXPECT_EQ("jello, world\n", session.text()->ToString());
+  EXPECT_FALSE(session.Redo());
+
+  // Saving again appends only the new steps.
+  const uint64_t size = session.undo_file()->size();
+  session.text()->InsertCharacter(TextPosition(0), 'x');
+  session.Save();
+  EXPECT_GT(size + 128, session.undo_file()->size());
+}
+
+TEST_F(UndoFileTest, UndoesPastTheSessionIntoEarlierOnes) {
+  EditAndSave();
+  {
+    Session session(path_);
+    session.text()->InsertText(TextPosition(0), std::string("> "));
+    session.Save();
+  }
+  Session session(path_);
+  EXPECT_EQ("> jello, world\n", session.text()->ToString());
+  for (int i = 0; i < 4; ++i)
+    EXPECT_TRUE(session.Undo());
+  EXPECT_EQ("hello\n", session.text()->ToString());
+}
+
+TEST_F(UndoFileTest, IgnoresHistoryOfAnotherFile) {
+  EditAndSave();
+  TextBuffer other(std::vector<char>{'h', 'i', '\n'});
+  WriteAtomically(path_, other.GetText());
+  Session session(path_);
+  EXPECT_FALSE(session.Undo());
+}
+
+TEST_F(UndoFileTest, StopsAtARecordThatDoesNotFit) {
+  EditAndSave();
+  // Claim that the record just before the last key deleted far more than the
+  // file holds.
+  const std::string undo_path = path_ + ".undo";
+  int fd = open(undo_path.c_str(), O_RDWR);
+  ASSERT_NE(-1, fd);
+  const off_t key_start = lseek(fd, 0, SEEK_END) - 40;
+  uint64_t length = 0;
+  ASSERT_EQ(8, pread(fd, &length, sizeof(length), key_start - 8));
+  const uint64_t deleted_length = uint64_t(1) << 40;
+  EXPECT_EQ(8, pwrite(fd, &deleted_length, sizeof(deleted_length),
+                      key_start - length + 16));
+  close(fd);
+  Session session(path_);
+  EXPECT_FALSE(session.Undo());
+  EXPECT_EQ("jello, world\n", session.text()->ToString());
+}
+
+TEST_F(UndoFileTest, ChecksTheTextBeforeUndoingPastTheSession) {
+  EditAndSave();
+  // Same inode and size, different contents.
+  int fd = open(path_.c_str(), O_WRONLY);
+  ASSERT_NE(-1, fd);
+  EXPECT_EQ(1, pwrite(fd, "m", 1, 0));
+  close(fd);
+  Session session(path_);
+  EXPECT_FALSE(session.Undo());
+  EXPECT_EQ("mello, world\n", session.text()->ToString());
+}
+
+TEST(UndoFile, HashDoesNotDependOnTheGap) {
+  const std::string string = "The quick brown fox jumps over the lazy dog";
+  TextBuffer text(std::vector<char>(string.begin(), string.end()));
+  const uint64_t hash = UndoFile::HashText(text.GetText());
+  for (size_t i = 0; i < string.size(); ++i) {
+    text.InsertCharacter(TextPosition(i), 'x');
+    text.DeleteRange(TextBufferRange(i, i + 1));
+    EXPECT_EQ(hash, UndoFile::HashText(text.GetText()));
+  }
+  text.InsertCharacter(TextPosition(3), 'x');
+  EXPECT_NE(hash, UndoFile::HashText(text.GetText()));
+}
+
+}  // namespace
+}  // namespace zi
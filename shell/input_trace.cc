@@ -0,0 +1,125 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "shell/input_trace.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "files/file_util.h"
+#include "zen/macros.h"
+
+namespace zi {
+namespace {
+
+constexpr char kHeader[] = "zi-input-trace";
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+bool ParseEvent(const char* begin, const char* end, InputEvent* event) {
+  char* cursor = nullptr;
+  event->timestamp = strtoull(begin, &cursor, 10);
+  if (cursor == begin || cursor == end || *cursor != ' ')
+    return false;
+  ++cursor;
+  if ((end - cursor) % 2 != 0)
+    return false;
+  event->data.clear();
+  for (; cursor < end; cursor += 2) {
+    int high = HexValue(cursor[0]);
+    int low = HexValue(cursor[1]);
+    if (high < 0 || low < 0)
+      return false;
+    event->data.push_back(static_cast<char>(high << 4 | low));
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ReadInputTrace(const std::string& path, InputTrace* trace) {
+  std::vector<char> contents = ReadFile(path);
+  contents.push_back('\0');
+  const char* cursor = contents.data();
+  const char* limit = cursor + contents.size() - 1;
+  const char* line_end = static_cast<const char*>(
+      memchr(cursor, '\n', limit - cursor));
+  unsigned long cols = 0;
+  unsigned long rows = 0;
+  if (!line_end ||
+      sscanf(cursor, "zi-input-trace %lu %lu", &cols, &rows) != 2)
+    return false;
+  trace->cols = cols;
+  trace->rows = rows;
+  trace->events.clear();
+  for (cursor = line_end + 1; cursor < limit; cursor = line_end + 1) {
+    line_end = static_cast<const char*>(memchr(cursor, '\n', limit - cursor));
+    if (!line_end)
+      return false;
+    InputEvent event;
+    if (!ParseEvent(cursor, line_end, &event))
+      return false;
+    trace->events.push_back(std::move(event));
+  }
+  return true;
+}
+
+std::unique_ptr<InputTraceWriter> InputTraceWriter::Create(
+    const std::string& path,
+    size_t cols,
+    size_t rows) {
+  int fd = HANDLE_EINTR(creat(path.c_str(), 0666));
+  if (fd == -1)
+    return nullptr;
+  std::unique_ptr<InputTraceWriter> writer(new InputTraceWriter(fd));
+  std::string header = std::string(kHeader) + " " + std::to_string(cols) +
+                       " " + std::to_string(rows) + "\n";
+  if (!WriteFileDescriptor(fd, header.data(), header.size()))
+    return nullptr;
+  return writer;
+}
+
+InputTraceWriter::InputTraceWriter(int fd)
+    : fd_(fd), start_(std::chrono::steady_clock::now()) {}
+
+InputTraceWriter::~InputTraceWriter() = default;
+
+void InputTraceWriter::Record(const char* data, size_t length) {
+  if (!fd_.is_valid())
+    return;
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_);
+  line_ = std::to_string(elapsed.count());
+  line_.push_back(' ');
+  for (size_t i = 0; i < length; ++i) {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    line_.push_back(kHexDigits[c >> 4]);
+    line_.push_back(kHexDigits[c & 0xF]);
+  }
+  line_.push_back('\n');
+  if (!WriteFileDescriptor(fd_.get(), line_.data(), line_.size()))
+    fd_.reset();
+}
+
+}  // namespace zi
@@ -0,0 +1,73 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "files/scoped_fd.h"
+#include "zen/macros.h"
+
+namespace zi {
+
+// An input trace records the raw bytes the shell read from the terminal, one
+// event per read, so that a session can be replayed without a terminal.
+//
+// The file format is line based:
+//
+//   zi-input-trace <cols> <rows>
+//   <microseconds since start> <hex encoded bytes>
+//   ...
+struct InputEvent {
+  uint64_t timestamp = 0;
+  std::string data;
+};
+
+struct InputTrace {
+  size_t cols = 0;
+  size_t rows = 0;
+  std::vector<InputEvent> events;
+};
+
+bool ReadInputTrace(const std::string& path, InputTrace* trace);
+
+class InputTraceWriter {
+ public:
+  // Returns null if the file cannot be created.
+  static std::unique_ptr<InputTraceWriter> Create(const std::string& path,
+                                                  size_t cols,
+                                                  size_t rows);
+  ~InputTraceWriter();
+
+  // Appends an event to the trace. Once a write fails, the trace is closed
+  // and later events are dropped, since the trace would no longer replay.
+  void Record(const char* data, size_t length);
+
+ private:
+  explicit InputTraceWriter(int fd);
+
+  ScopedFD fd_;
+  std::chrono::steady_clock::time_point start_;
+  std::string line_;
+
+  DISALLOW_COPY_AND_ASSIGN(InputTraceWriter);
+};
+
+}  // namespace zi
@@ -0,0 +1,71 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "shell/input_trace.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+TEST(InputTrace, RoundTrip) {
+  char path[] = "/tmp/zi_input_trace_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  close(fd);
+
+  {
+    std::unique_ptr<InputTraceWriter> writer =
+        InputTraceWriter::Create(path, 80, 24);
+    ASSERT_TRUE(writer);
+    writer->Record("i", 1);
+    writer->Record("\x1b[A", 3);
+    writer->Record("\0\xff", 2);
+  }
+
+  InputTrace trace;
+  EXPECT_TRUE(ReadInputTrace(path, &trace));
+  EXPECT_EQ(80u, trace.cols);
+  EXPECT_EQ(24u, trace.rows);
+  ASSERT_EQ(3u, trace.events.size());
+  EXPECT_EQ("i", trace.events[0].data);
+  EXPECT_EQ("\x1b[A", trace.events[1].data);
+  EXPECT_EQ(std::string("\0\xff", 2), trace.events[2].data);
+  EXPECT_LE(trace.events[0].timestamp, trace.events[1].timestamp);
+  EXPECT_LE(trace.events[1].timestamp, trace.events[2].timestamp);
+  unlink(path);
+}
+
+TEST(InputTrace, Malformed) {
+  char path[] = "/tmp/zi_input_trace_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  const char contents[] = "zi-input-trace 80 24\n12 6x\n";
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(contents) - 1),
+            write(fd, contents, sizeof(contents) - 1));
+  close(fd);
+
+  InputTrace trace;
+  EXPECT_FALSE(ReadInputTrace(path, &trace));
+  EXPECT_FALSE(ReadInputTrace("/nonexistent/trace", &trace));
+  unlink(path);
+}
+
+}  // namespace
+}  // namespace zi
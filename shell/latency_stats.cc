@@ -0,0 +1,110 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "shell/latency_stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+
+#include "files/file_util.h"
+#include "files/scoped_fd.h"
+#include "zen/macros.h"
+
+namespace zi {
+namespace {
+
+const char* kPhaseNames[] = {
+    "paint", "input", "lines", "build", "execute",
+};
+
+std::string FormatDuration(uint64_t nanoseconds) {
+  char buffer[32];
+  if (nanoseconds < 1000)
+    snprintf(buffer, sizeof(buffer), "%lluns",
+             static_cast<unsigned long long>(nanoseconds));
+  else if (nanoseconds < 1000000)
+    snprintf(buffer, sizeof(buffer), "%.1fus", nanoseconds / 1e3);
+  else if (nanoseconds < 1000000000)
+    snprintf(buffer, sizeof(buffer), "%.1fms", nanoseconds / 1e6);
+  else
+    snprintf(buffer, sizeof(buffer), "%.2fs", nanoseconds / 1e9);
+  return buffer;
+}
+
+}  // namespace
+
+LatencyStats::LatencyStats() = default;
+
+LatencyStats::~LatencyStats() = default;
+
+void LatencyStats::Record(Phase phase, Clock::duration duration) {
+  histograms_[phase].Record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
+const char* LatencyStats::GetPhaseName(Phase phase) {
+  return kPhaseNames[phase];
+}
+
+bool LatencyStats::GetPhaseForName(const std::string& name, Phase* phase) {
+  for (int i = 0; i < kPhaseCount; ++i) {
+    if (name == kPhaseNames[i]) {
+      *phase = static_cast<Phase>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string LatencyStats::GetSummary(Phase phase) const {
+  const Histogram& histogram = histograms_[phase];
+  return std::string(GetPhaseName(phase)) + ": p50 " +
+         FormatDuration(histogram.ValueAtPercentile(50)) + ", p99 " +
+         FormatDuration(histogram.ValueAtPercentile(99)) + ", max " +
+         FormatDuration(histogram.max()) + " (" +
+         std::to_string(histogram.count()) + " samples)";
+}
+
+bool LatencyStats::WriteToFile(const std::string& path) const {
+  ScopedFD fd(HANDLE_EINTR(creat(path.c_str(), 0666)));
+  if (!fd.is_valid())
+    return false;
+  std::string output;
+  char line[128];
+  for (int i = 0; i < kPhaseCount; ++i) {
+    const Histogram& histogram = histograms_[i];
+    snprintf(line, sizeof(line),
+             "%s count=%llu min=%llu p50=%llu p90=%llu p99=%llu p999=%llu "
+             "max=%llu\n",
+             kPhaseNames[i], static_cast<unsigned long long>(histogram.count()),
+             static_cast<unsigned long long>(histogram.min()),
+             static_cast<unsigned long long>(histogram.ValueAtPercentile(50)),
+             static_cast<unsigned long long>(histogram.ValueAtPercentile(90)),
+             static_cast<unsigned long long>(histogram.ValueAtPercentile(99)),
+             static_cast<unsigned long long>(histogram.ValueAtPercentile(99.9)),
+             static_cast<unsigned long long>(histogram.max()));
+    output += line;
+    histogram.ForEachBucket([&](uint64_t low, uint64_t high, uint64_t count) {
+      snprintf(line, sizeof(line), "  %llu-%llu %llu\n",
+               static_cast<unsigned long long>(low),
+               static_cast<unsigned long long>(high),
+               static_cast<unsigned long long>(count));
+      output += line;
+    });
+  }
+  return WriteFileDescriptor(fd.get(), output.data(), output.size());
+}
+
+}  // namespace zi
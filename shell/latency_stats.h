@@ -0,0 +1,67 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
+
+#include "zen/histogram.h"
+#include "zen/macros.h"
+
+namespace zi {
+
+// Where the time goes between reading a batch of input and painting the frame
+// that shows its effect.
+class LatencyStats {
+ public:
+  enum Phase {
+    // From reading the input to the end of the write that paints the frame.
+    kInputToPaint,
+    kHandleInput,
+    kUpdateLines,
+    kBuildFrame,
+    kExecute,
+    kPhaseCount,
+  };
+
+  typedef std::chrono::steady_clock Clock;
+
+  LatencyStats();
+  ~LatencyStats();
+
+  void Record(Phase phase, Clock::duration duration);
+  const Histogram& histogram(Phase phase) const { return histograms_[phase]; }
+
+  static const char* GetPhaseName(Phase phase);
+
+  // Returns false if there is no phase named |name|.
+  static bool GetPhaseForName(const std::string& name, Phase* phase);
+
+  // A one line summary of |phase| that fits in the status line.
+  std::string GetSummary(Phase phase) const;
+
+  // Writes the percentiles and buckets of every phase, in nanoseconds.
+  bool WriteToFile(const std::string& path) const;
+
+ private:
+  Histogram histograms_[kPhaseCount];
+
+  DISALLOW_COPY_AND_ASSIGN(LatencyStats);
+};
+
+}  // namespace zi
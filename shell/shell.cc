@@ -0,0 +1,1238 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "shell/shell.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "files/edit_journal.h"
+#include "files/file_loader.h"
+#include "files/file_saver.h"
+#include "files/file_util.h"
+#include "files/paged_file.h"
+#include "files/process_filter.h"
+#include "files/undo_file.h"
+#include "shell/input_trace.h"
+#include "terminal/command_buffer.h"
+#include "terminal/term.h"
+#include "terminal/virtual_terminal.h"
+#include "text/text_buffer.h"
+#include "text/undo_history.h"
+#include "zen/allocation_counter.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+namespace {
+
+// A keystroke usually arrives alone, but a paste or a key with an escape
+// sequence arrives as a batch that we process before painting once.
+constexpr size_t kInputBufferSize = 1024;
+
+// Files are loaded with a gap in front of the text so that the first edits do
+// not copy the whole file to make room.
+constexpr size_t kInitialGapSize = 1 << 16;
+
+// Files larger than this load on a background thread, a chunk at a time, so
+// that the first screen does not wait for the whole file.
+constexpr size_t kProgressiveLoadSize = 4 << 20;
+constexpr size_t kLoadChunkSize = 1 << 20;
+
+// The journal of the edits to "foo" is "foo.journal". It starts over from a
+// copy of the text once the edits outgrow the text or this size, whichever is
+// larger, so that replaying it stays cheap.
+const char kJournalSuffix[] = ".journal";
+constexpr size_t kJournalCheckpointSize = 1 << 20;
+
+// The undo history of "foo" is kept in "foo.undo".
+const char kUndoSuffix[] = ".undo";
+
+// Guards against macros that invoke themselves.
+constexpr int kMaxReplayDepth = 100;
+
+bool IsRegisterName(char c) {
+  return c >= 'a' && c <= 'z';
+}
+
+// Stands for "gc" in |pending_command_| while "gcc" waits for its last key.
+constexpr char kToggleComment = 'c';
+
+// Files whose names end in these are commented out with "#" rather than "//".
+const char* const kHashCommentSuffixes[] = {
+    ".cmake", ".gn",   ".gni",     ".pl",           ".py", ".rb",
+    ".sh",    ".toml", "Makefile", "CMakeLists.txt",
+};
+
+std::string GetCommentPrefix(const std::string& path) {
+  for (const char* suffix : kHashCommentSuffixes) {
+    const size_t length = strlen(suffix);
+    if (path.size() >= length &&
+        path.compare(path.size() - length, length, suffix) == 0)
+      return "#";
+  }
+  return "//";
+}
+
+// Line addresses in commands that stand for lines we only know once the
+// command runs.
+constexpr size_t kCursorLine = std::string::npos - 1;
+constexpr size_t kLastLine = std::string::npos;
+
+// Parses a one-based line number, "." for the cursor's line or "$" for the
+// last line into a zero-based |line|.
+bool ParseLineAddress(const std::string& command, size_t* pos, size_t* line) {
+  if (*pos >= command.size())
+    return false;
+  const char c = command[*pos];
+  if (c == '.' || c == '$') {
+    *line = c == '.' ? kCursorLine : kLastLine;
+    ++*pos;
+    return true;
+  }
+  if (!isdigit(c))
+    return false;
+  char* end = nullptr;
+  *line = std::max<size_t>(strtoull(command.c_str() + *pos, &end, 10), 1) - 1;
+  *pos = end - command.c_str();
+  return true;
+}
+
+// Reads up to the next unescaped |delimiter|, or the end of |command|. A
+// backslash escapes the character after it.
+std::string ParseDelimited(const std::string& command,
+                           size_t* pos,
+                           char delimiter) {
+  std::string result;
+  while (*pos < command.size()) {
+    char c = command[(*pos)++];
+    if (c == delimiter)
+      break;
+    if (c == '\\' && *pos < command.size())
+      c = command[(*pos)++];
+    result.push_back(c);
+  }
+  return result;
+}
+
+// Whether |command| is |name| on its own or followed by a space and an
+// argument, which is stored in |argument|.
+bool MatchCommand(const std::string& command,
+                  const std::string& name,
+                  std::string* argument) {
+  if (command.compare(0, name.size(), name) != 0 ||
+      (command.size() > name.size() && command[name.size()] != ' '))
+    return false;
+  *argument = command.size() > name.size() ? command.substr(name.size() + 1)
+                                           : std::string();
+  return true;
+}
+
+std::string CountNoun(size_t count, const char* noun) {
+  return std::to_string(count) + " " + noun + (count == 1 ? "" : "s");
+}
+
+// A journal that is older than its file was left behind before the file was
+// last saved.
+bool HasJournalToRecover(const std::string& path,
+                         const std::string& journal_path) {
+  struct stat journal_info;
+  if (stat(journal_path.c_str(), &journal_info) == -1)
+    return false;
+  struct stat info;
+  if (stat(path.c_str(), &info) == -1)
+    return true;
+  if (journal_info.st_mtim.tv_sec != info.st_mtim.tv_sec)
+    return journal_info.st_mtim.tv_sec > info.st_mtim.tv_sec;
+  return journal_info.st_mtim.tv_nsec >= info.st_mtim.tv_nsec;
+}
+
+}  // namespace
+
+Shell::Shell(OutputSink* output, size_t cols, size_t rows)
+    : output_(output), cols_(cols), rows_(rows) {
+  output_->Put(term::kSaveScreen);
+  output_->Put(term::kMoveCursorHome);
+  // The last row shows the status.
+  editor_.Resize(cols_, rows_ - std::min<size_t>(rows_, 1));
+  SetUndoBudget(kDefaultUndoBudget);
+}
+
+Shell::~Shell() {
+  // Quitting abandons the edits that were not saved.
+  CancelFilter();
+  CloseJournal();
+  editor_.text()->RemoveObserver(undo_history_.get());
+  output_->Put(term::kRestoreScreen);
+}
+
+void Shell::SetRenderMode(RenderMode mode) {
+  render_mode_ = mode;
+  painted_screen_.reset();
+  frame_screen_.reset();
+  if (render_mode_ == RenderMode::Diffed) {
+    painted_screen_.reset(new VirtualTerminal(cols_, rows_));
+    frame_screen_.reset(new VirtualTerminal(cols_, rows_));
+  }
+  screen_is_painted_ = false;
+  mark_needs_display();
+}
+
+void Shell::SetUndoBudget(size_t budget) {
+  if (undo_history_)
+    editor_.text()->RemoveObserver(undo_history_.get());
+  undo_history_.reset(new UndoHistory(budget));
+  undo_history_->SetArchive(undo_file_.get());
+  editor_.text()->AddObserver(undo_history_.get());
+}
+
+// The edits to the previous text cannot be undone in this one.
+void Shell::SetText(std::unique_ptr<TextBuffer> text) {
+  CancelFilter();
+  editor_.text()->RemoveObserver(undo_history_.get());
+  editor_.SetText(std::move(text));
+  undo_history_->Clear();
+  editor_.text()->AddObserver(undo_history_.get());
+}
+
+void Shell::OpenFile(const std::string& path) {
+  CloseJournal();
+  CloseUndoFile();
+  loader_.reset();
+  paged_file_.reset();
+  path_ = path;
+  size_t size = 0;
+  if (!GetFileSize(path, &size))
+    size = 0;
+  if (size > memory_budget_) {
+    paged_file_ = PagedFile::Open(path);
+    if (paged_file_ && LoadWindow(0, GetWindowSize()))
+      return;
+    paged_file_.reset();
+  }
+  const std::string journal_path = path + kJournalSuffix;
+  const bool has_journal = HasJournalToRecover(path, journal_path);
+  // Recovering needs the whole file up front.
+  if (size > kProgressiveLoadSize && !has_journal) {
+    loader_ = FileLoader::Create(path, kLoadChunkSize);
+    if (loader_) {
+      StartLoading();
+      StartJournal(loader_->size());
+      OpenUndoFile();
+      return;
+    }
+  }
+  std::unique_ptr<TextBuffer> text(
+      new TextBuffer(ReadFile(path, kInitialGapSize), kInitialGapSize));
+  const uint64_t base_size = text->size();
+  size_t edit_count = 0;
+  if (has_journal &&
+      !EditJournal::Replay(journal_path, text.get(), &edit_count)) {
+    // Leave the journal alone so that it is not lost.
+    status_ = "Unable to recover edits from " + journal_path;
+    SetText(std::move(text));
+    return;
+  }
+  SetText(std::move(text));
+  StartJournal(base_size);
+  // The history in the undo file leads up to the file, not to the edits
+  // recovered on top of it.
+  if (!has_journal)
+    OpenUndoFile();
+  if (has_journal) {
+    journal_->Checkpoint(editor_.text()->GetText());
+    status_ = "Recovered " + std::to_string(edit_count) + " edits from " +
+              journal_path;
+  }
+}
+
+void Shell::OpenUndoFile() {
+  undo_file_ = UndoFile::Open(path_ + kUndoSuffix, path_);
+  undo_history_->SetArchive(undo_file_.get());
+}
+
+void Shell::CloseUndoFile() {
+  undo_history_->SetArchive(nullptr);
+  undo_file_.reset();
+}
+
+void Shell::StartJournal(uint64_t base_size) {
+  journal_ = EditJournal::Create(path_ + kJournalSuffix, base_size);
+  editor_.text()->AddObserver(journal_.get());
+}
+
+void Shell::CloseJournal() {
+  if (!journal_)
+    return;
+  editor_.text()->RemoveObserver(journal_.get());
+  journal_->Remove();
+  journal_.reset();
+}
+
+void Shell::MaybeCheckpointJournal() {
+  if (!journal_)
+    return;
+  TextBuffer* text = editor_.text();
+  const size_t limit = std::max(kJournalCheckpointSize, text->size());
+  if (journal_->edit_size() > limit)
+    journal_->Checkpoint(text->GetText());
+}
+
+// Shows the first chunk of the file as soon as it is read. The rest of the
+// chunks are appended as they arrive, into capacity reserved up front.
+void Shell::StartLoading() {
+  std::vector<char> buffer(kInitialGapSize);
+  buffer.reserve(kInitialGapSize + loader_->size());
+  std::vector<char> chunk;
+  if (loader_->WaitForChunk(&chunk))
+    buffer.insert(buffer.end(), chunk.begin(), chunk.end());
+  std::unique_ptr<TextBuffer> text(
+      new TextBuffer(std::move(buffer), kInitialGapSize));
+  SetText(std::move(text));
+  ContinueLoading();
+}
+
+void Shell::ContinueLoading() {
+  if (!loader_)
+    return;
+  TRACE_EVENT0("shell", "Shell::ContinueLoading");
+  std::vector<std::vector<char>> chunks;
+  loader_->TakeChunks(&chunks);
+  for (const auto& chunk : chunks)
+    editor_.AppendText(StringView(chunk.data(), chunk.data() + chunk.size()));
+  UpdateLoadStatus();
+  if (!chunks.empty())
+    mark_needs_display();
+}
+
+void Shell::FinishLoading() {
+  if (!loader_)
+    return;
+  std::vector<char> chunk;
+  while (loader_->WaitForChunk(&chunk))
+    editor_.AppendText(StringView(chunk.data(), chunk.data() + chunk.size()));
+  UpdateLoadStatus();
+  mark_needs_display();
+}
+
+void Shell::UpdateLoadStatus() {
+  // Leave the status alone while the user is typing a command.
+  const bool can_show_status = mode_ != Mode::Command;
+  if (loader_->is_finished()) {
+    if (can_show_status && showing_load_status_)
+      status_ = loader_->failed() ? "Unable to read all of " + path_ : "";
+    showing_load_status_ = false;
+    loader_.reset();
+    mark_needs_display();
+    return;
+  }
+  if (!can_show_status)
+    return;
+  const size_t size = std::max<size_t>(loader_->size(), 1);
+  const size_t percent =
+      std::min<size_t>(editor_.text()->size() * 100 / size, 99);
+  status_ = "Loading " + path_ + " (" + std::to_string(percent) + "%)";
+  showing_load_status_ = true;
+}
+
+size_t Shell::GetWindowSize() const {
+  return std::max<size_t>(memory_budget_ / 4, 1);
+}
+
+// Replaces the editor's text with about |length| bytes of the paged file from
+// |start|, rounded to whole lines.
+bool Shell::LoadWindow(uint64_t start, uint64_t length) {
+  TRACE_EVENT0("shell", "Shell::LoadWindow");
+  std::vector<char> buffer;
+  uint64_t end = 0;
+  if (!paged_file_->ReadWindow(length, &start, &end, &buffer,
+                               kInitialGapSize)) {
+    status_ = "Unable to read " + path_;
+    return false;
+  }
+  std::unique_ptr<TextBuffer> text(
+      new TextBuffer(std::move(buffer), kInitialGapSize));
+  SetText(std::move(text));
+  window_start_ = start;
+  window_end_ = end;
+  window_modified_ = false;
+  if (mode_ != Mode::Command) {
+    const uint64_t size = std::max<uint64_t>(paged_file_->size(), 1);
+    status_ = "Paging " + path_ + " (" +
+              std::to_string(window_start_ * 100 / size) + "%)";
+  }
+  mark_needs_display();
+  return true;
+}
+
+// Keeps the edits to the window as an overlay. Unless |force|, refuses once
+// the overlays would outgrow their half of the memory budget.
+bool Shell::CommitWindow(bool force) {
+  if (!window_modified_)
+    return true;
+  TextBuffer* text = editor_.text();
+  if (!force &&
+      paged_file_->overlay_size() + text->size() > memory_budget_ / 2) {
+    status_ = "Too many unsaved edits; save with :w";
+    return false;
+  }
+  paged_file_->SetOverlay(window_start_, window_end_, text->GetText());
+  window_modified_ = false;
+  return true;
+}
+
+bool Shell::PageForward() {
+  if (window_end_ >= paged_file_->size() || !CommitWindow(false))
+    return false;
+  return LoadWindow(window_end_, GetWindowSize());
+}
+
+// Loads the window that ends where the current one starts, with the cursor on
+// its last line.
+bool Shell::PageBackward() {
+  if (window_start_ == 0 || !CommitWindow(false))
+    return false;
+  const uint64_t end = window_start_;
+  const uint64_t start = end - std::min<uint64_t>(end, GetWindowSize());
+  if (!LoadWindow(start, end - start))
+    return false;
+  return editor_.MoveCursorToLine(editor_.GetLineCount() - 1);
+}
+
+// Writes the original bytes and the overlays to a new file and reopens it at
+// the window the cursor is in.
+void Shell::SavePagedFile() {
+  CommitWindow(true);
+  const uint64_t start = paged_file_->GetEditedOffset(window_start_);
+  const size_t row = editor_.cursor_row();
+  if (!paged_file_->WriteTo(path_, durability_)) {
+    status_ = "Unable to save " + path_;
+    return;
+  }
+  // If the saved file cannot be reopened, the old one still has the edits.
+  std::unique_ptr<PagedFile> saved = PagedFile::Open(path_);
+  if (!saved)
+    return;
+  paged_file_ = std::move(saved);
+  status_ = "Saved " + std::to_string(paged_file_->size()) + " bytes to " +
+            path_;
+  if (LoadWindow(start, GetWindowSize()))
+    editor_.MoveCursorToLine(row);
+}
+
+void Shell::Save() {
+  if (paged_file_) {
+    SavePagedFile();
+    return;
+  }
+  // Saving a partly loaded file would truncate it.
+  FinishLoading();
+  if (!saver_)
+    saver_ = FileSaver::Create();
+  const uint64_t mark = journal_ ? journal_->GetMark() : 0;
+  TextView text = editor_.text()->GetText();
+  if (undo_file_) {
+    undo_history_->ArchiveSteps();
+    // Only the size is known here. The hash waits for the save, which has
+    // to read every byte anyway.
+    undo_file_->WriteKey(text.length());
+    undo_key_tag_ = mark;
+  }
+  if (!saver_) {
+    if (!WriteAtomically(path_, text, durability_)) {
+      status_ = "Unable to save " + path_;
+      return;
+    }
+    if (journal_)
+      journal_->Rebase(mark, text.length());
+    if (undo_file_)
+      undo_file_->ConfirmKey(path_, UndoFile::HashText(text));
+    return;
+  }
+  // The snapshot lets the user keep editing while the write is in progress.
+  // The journal mark tells which edits the snapshot has.
+  saver_->Save(path_, editor_.text()->Snapshot(), durability_, mark,
+               undo_file_ != nullptr);
+}
+
+void Shell::FinishSaving() {
+  if (!saver_)
+    return;
+  saver_->WaitForIdle();
+  CheckSaves();
+}
+
+void Shell::CheckSaves() {
+  if (!saver_)
+    return;
+  FileSaver::Result result;
+  while (saver_->TakeResult(&result)) {
+    if (result.succeeded && journal_ && result.path == path_)
+      journal_->Rebase(result.tag, result.size);
+    if (result.succeeded && undo_file_ && result.path == path_ &&
+        result.tag == undo_key_tag_)
+      undo_file_->ConfirmKey(path_, result.hash);
+    // Leave the status alone while the user is typing a command.
+    if (mode_ == Mode::Command)
+      continue;
+    if (!result.succeeded)
+      status_ = "Unable to save " + result.path;
+    else
+      status_ = "Saved " + std::to_string(result.size) + " bytes to " +
+                result.path;
+    mark_needs_display();
+  }
+}
+
+int Shell::Run(InputTraceWriter* input_trace) {
+  Display();
+  while (!should_quit_) {
+    // Give up once nothing reaches the terminal anymore.
+    if (output_->failed())
+      return 1;
+    if ((loader_ || saver_ || filter_) && !WaitForInputWhileBusy())
+      continue;
+    char buffer[kInputBufferSize];
+    int count = read(STDIN_FILENO, buffer, kInputBufferSize);
+    if (count == -1)
+      return 1;
+    if (count == 0)
+      continue;
+    const LatencyStats::Clock::time_point read_time =
+        LatencyStats::Clock::now();
+    if (input_trace)
+      input_trace->Record(buffer, count);
+    HandleInput(buffer, count, read_time);
+  }
+  return 0;
+}
+
+// Returns true once there is input to read, after painting whatever part of
+// the file arrived and whichever saves and filters completed in the meantime.
+bool Shell::WaitForInputWhileBusy() {
+  struct pollfd fds[4] = {
+      {STDIN_FILENO, POLLIN, 0},
+      {loader_ ? loader_->ready_fd() : -1, POLLIN, 0},
+      {saver_ ? saver_->ready_fd() : -1, POLLIN, 0},
+      {filter_ ? filter_->ready_fd() : -1, POLLIN, 0},
+  };
+  if (poll(fds, 4, -1) == -1)
+    return errno != EINTR;
+  if (fds[1].revents)
+    ContinueLoading();
+  if (fds[2].revents)
+    CheckSaves();
+  if (fds[3].revents)
+    CheckFilter();
+  if (needs_display_ && (fds[1].revents || fds[2].revents || fds[3].revents))
+    Display();
+  return fds[0].revents != 0;
+}
+
+void Shell::ProcessInput(const char* data, size_t length) {
+  HandleInput(data, length, LatencyStats::Clock::now());
+}
+
+void Shell::HandleInput(const char* data,
+                        size_t length,
+                        LatencyStats::Clock::time_point read_time) {
+  TRACE_EVENT0("shell", "Shell::HandleInput");
+  const uint64_t allocation_count = GetThreadAllocationCount();
+  // Let the input see as much of a loading file as we have.
+  ContinueLoading();
+  CheckSaves();
+  CheckFilter();
+  for (size_t i = 0; i < length && !should_quit_; ++i)
+    HandleCharacter(data[i]);
+  MaybeCheckpointJournal();
+  stats_.Record(LatencyStats::kHandleInput,
+                LatencyStats::Clock::now() - read_time);
+  if (needs_display_) {
+    Display();
+    stats_.Record(LatencyStats::kInputToPaint,
+                  LatencyStats::Clock::now() - read_time);
+    last_frame_allocation_count_ =
+        GetThreadAllocationCount() - allocation_count;
+  }
+}
+
+void Shell::Bell() {
+  if (replay_depth_ > 0)
+    replay_failed_ = true;
+  else
+    output_->Put(term::kBell);
+}
+
+void Shell::HandleCharacter(char c) {
+  if (recording_register_)
+    registers_[recording_register_ - 'a'].push_back(c);
+  DispatchCharacter(c);
+}
+
+void Shell::DispatchCharacter(char c) {
+  switch (mode_) {
+    case Mode::Vi:
+      HandleCharacterInViMode(c);
+      break;
+    case Mode::Command:
+      HandleCharacterInCommandMode(c);
+      break;
+    case Mode::Input:
+      HandleCharacterInInputMode(c);
+      break;
+  }
+}
+
+void Shell::HandleCharacterInViMode(char c) {
+  if (pending_command_) {
+    HandlePendingCommand(c);
+    return;
+  }
+  if ((c >= '1' && c <= '9') || (c == '0' && count_ > 0)) {
+    count_ = count_ * 10 + (c - '0');
+    return;
+  }
+  switch (c) {
+    case 'h':
+      MoveCursor(&Editor::MoveCursorLeft, TakeCount());
+      break;
+    case 'j':
+      MoveCursor(&Editor::MoveCursorDown, TakeCount());
+      break;
+    case 'k':
+      MoveCursor(&Editor::MoveCursorUp, TakeCount());
+      break;
+    case 'l':
+      MoveCursor(&Editor::MoveCursorRight, TakeCount());
+      break;
+    case 'w':
+      MoveCursor(&Editor::MoveCursorToNextWord, TakeCount());
+      break;
+    case 'W':
+      MoveCursor(&Editor::MoveCursorToNextBigWord, TakeCount());
+      break;
+    case 'b':
+      MoveCursor(&Editor::MoveCursorToPreviousWord, TakeCount());
+      break;
+    case 'B':
+      MoveCursor(&Editor::MoveCursorToPreviousBigWord, TakeCount());
+      break;
+    case 'e':
+      MoveCursor(&Editor::MoveCursorToWordEnd, TakeCount());
+      break;
+    case 'E':
+      MoveCursor(&Editor::MoveCursorToBigWordEnd, TakeCount());
+      break;
+    case '}':
+      MoveCursor(&Editor::MoveCursorToNextParagraph, TakeCount());
+      break;
+    case '{':
+      MoveCursor(&Editor::MoveCursorToPreviousParagraph, TakeCount());
+      break;
+    case '+':
+      // Leaves a cursor behind on each line, to type on all of them at once.
+      MoveCursor(&Editor::AddCursorBelow, TakeCount());
+      break;
+    case '\x1b':
+      if (editor_.ClearExtraCursors())
+        mark_needs_display();
+      break;
+    case '\x03':  // Ctrl-C
+      CancelFilter();
+      break;
+    case 'i':
+      mode_ = Mode::Input;
+      undo_history_->BeginGroup();
+      break;
+    case 'u':
+      StepHistory(&Editor::Undo, TakeCount());
+      break;
+    case '\x12':  // Ctrl-R
+      StepHistory(&Editor::Redo, TakeCount());
+      break;
+    case 'q':
+      if (recording_register_)
+        StopRecording();
+      else
+        pending_command_ = c;
+      return;
+    case '@':
+      // Keep |count_| for the replay.
+      pending_command_ = c;
+      return;
+    case '>':
+    case '<':
+    case 'g':
+      // Keep |count_| for the operator.
+      pending_command_ = c;
+      return;
+    case 'J':
+      ApplyLineOperator(c, editor_.cursor_row(),
+                        editor_.cursor_row() + TakeCount() - 1);
+      break;
+    case 'Z':
+      should_quit_ = true;
+      break;
+    case ':':
+      mode_ = Mode::Command;
+      status_ = ":";
+      mark_needs_display();
+      break;
+    default:
+      break;
+  }
+  count_ = 0;
+}
+
+void Shell::HandlePendingCommand(char c) {
+  const char command = pending_command_;
+  pending_command_ = '\0';
+  if (command == 'g' && c == 'c') {
+    pending_command_ = kToggleComment;
+    return;
+  }
+  const size_t count = TakeCount();
+  if (command == '>' || command == '<' || command == kToggleComment ||
+      command == 'g') {
+    // Doubling an operator, as in ">>" or "gcc", applies it to |count| lines.
+    if (command == 'g' || c != command) {
+      Bell();
+      return;
+    }
+    ApplyLineOperator(command, editor_.cursor_row(),
+                      editor_.cursor_row() + count - 1);
+    return;
+  }
+  if (command == '@' && c == '@')
+    c = last_executed_register_;
+  if (!IsRegisterName(c)) {
+    Bell();
+    return;
+  }
+  if (command == 'q') {
+    StartRecording(c);
+  } else if (command == '@') {
+    last_executed_register_ = c;
+    ExecuteRegister(c, count);
+  }
+}
+
+size_t Shell::TakeCount() {
+  size_t count = std::max<size_t>(count_, 1);
+  count_ = 0;
+  return count;
+}
+
+void Shell::MoveCursor(bool (Editor::*move)(), size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if ((editor_.*move)())
+      continue;
+    // A paged file continues in the neighbouring window.
+    if (paged_file_ && move == &Editor::MoveCursorDown && PageForward())
+      continue;
+    if (paged_file_ && move == &Editor::MoveCursorUp && PageBackward())
+      continue;
+    Bell();
+    break;
+  }
+  mark_needs_display();
+}
+
+// In paging mode, |line| counts the lines of the file on disk to the nearest
+// checkpoint indexed so far and the lines of the windows after that.
+void Shell::GoToLine(size_t line) {
+  mark_needs_display();
+  if (!paged_file_) {
+    if (!editor_.MoveCursorToLine(line))
+      Bell();
+    return;
+  }
+  uint64_t checkpoint_line = 0;
+  uint64_t offset = 0;
+  paged_file_->GetCheckpoint(line, &checkpoint_line, &offset);
+  if (!CommitWindow(false) || !LoadWindow(offset, GetWindowSize()))
+    return;
+  size_t remaining = line - checkpoint_line;
+  while (!editor_.MoveCursorToLine(remaining)) {
+    remaining -= editor_.GetLineCount();
+    if (!PageForward()) {
+      Bell();
+      return;
+    }
+  }
+}
+
+// Undoes or redoes |count| steps.
+void Shell::StepHistory(bool (Editor::*step)(UndoHistory*), size_t count) {
+  // The steps in the undo file need the whole text.
+  if (!undo_history_->can_undo())
+    FinishLoading();
+  for (size_t i = 0; i < count; ++i) {
+    if (!(editor_.*step)(undo_history_.get())) {
+      Bell();
+      break;
+    }
+    window_modified_ = true;
+  }
+  mark_needs_display();
+}
+
+void Shell::StartRecording(char name) {
+  recording_register_ = name;
+  registers_[name - 'a'].clear();
+  status_ = std::string("recording @") + name;
+  mark_needs_display();
+}
+
+void Shell::StopRecording() {
+  // The "q" that stopped the recording was recorded as well, unless it came
+  // from a macro.
+  if (replay_depth_ == 0)
+    registers_[recording_register_ - 'a'].pop_back();
+  recording_register_ = '\0';
+  status_.clear();
+  mark_needs_display();
+}
+
+void Shell::ExecuteRegister(char name, size_t count) {
+  if (replay_depth_ >= kMaxReplayDepth) {
+    Bell();
+    return;
+  }
+  // Copy the keys because the macro might record over its own register.
+  const std::string keys = registers_[name - 'a'];
+  ++replay_depth_;
+  undo_history_->BeginGroup();
+  for (size_t i = 0; i < count && !replay_failed_; ++i) {
+    for (char c : keys) {
+      DispatchCharacter(c);
+      if (replay_failed_)
+        break;
+    }
+  }
+  undo_history_->EndGroup();
+  if (--replay_depth_ == 0 && replay_failed_) {
+    replay_failed_ = false;
+    Bell();
+  }
+  mark_needs_display();
+}
+
+void Shell::HandleCharacterInCommandMode(char c) {
+  if (c == '\n' || c == '\r') {
+    ExecuteCommand(status_);
+    mark_needs_display();
+  } else if (c == '\x8') {
+    status_.pop_back();
+    mark_needs_display();
+  } else if (c == '\x1b') {
+    status_.clear();
+    mode_ = Mode::Vi;
+    mark_needs_display();
+  } else {
+    status_.push_back(c);
+    mark_needs_display();
+  }
+}
+
+void Shell::HandleCharacterInInputMode(char c) {
+  if (c != '\x1b')
+    window_modified_ = true;
+  if (c == '\x09') {
+    // TODO(abarth): Tab handling.
+    editor_.InsertCharacter(c);
+  } else if (c == '\x0A' || c == '\x0D') {
+    editor_.InsertLineBreak();
+  } else if (c == '\x1b') {
+    mode_ = Mode::Vi;
+    undo_history_->EndGroup();
+  } else if (c >= ' ' && c < '\x7F') {
+    editor_.InsertCharacter(c);
+  } else if (c == '\x7F') {
+    if (!editor_.Backspace())
+      Bell();
+  } else {
+    status_ = "Unknown character: " + std::to_string(c);
+  }
+  mark_needs_display();
+}
+
+void Shell::ExecuteCommand(const std::string& command) {
+  std::string name;
+  if (command == ":q")
+    should_quit_ = true;
+  else if (command == ":w") {
+    status_ = "Saving " + path_;
+    Save();
+  } else if (MatchCommand(command, ":stats", &name)) {
+    LatencyStats::Phase phase = LatencyStats::kInputToPaint;
+    if (name.empty() || LatencyStats::GetPhaseForName(name, &phase))
+      status_ = stats_.GetSummary(phase);
+    else
+      status_ = "Unknown phase: " + name;
+  } else if (command.size() > 1 &&
+             command.find_first_not_of("0123456789", 1) == std::string::npos) {
+    const size_t line = strtoull(command.c_str() + 1, nullptr, 10);
+    GoToLine(std::max<size_t>(line, 1) - 1);
+  } else if (MatchCommand(command, ":trace", &name)) {
+    ExecuteTraceCommand(name);
+  } else {
+    ExecuteRangeCommand(command);
+  }
+  mode_ = Mode::Vi;
+}
+
+// ":[range]s", ":[range]sort", ":[range]!", ":[range]>", ":[range]<" and
+// ":[range]j[oin]" work on a range of lines. The range is "%" for every
+// line, a line or two lines separated by a comma, and is the cursor's line if
+// it is left out, except that ":sort" sorts every line. Other commands are
+// ignored. A paged file only holds a window of its lines, so there only the
+// cursor's line works.
+void Shell::ExecuteRangeCommand(const std::string& command) {
+  size_t pos = 1;
+  size_t first_line = kCursorLine;
+  size_t last_line = kCursorLine;
+  if (pos < command.size() && command[pos] == '%') {
+    first_line = 0;
+    last_line = kLastLine;
+    ++pos;
+  } else if (ParseLineAddress(command, &pos, &first_line)) {
+    last_line = first_line;
+    if (pos < command.size() && command[pos] == ',' &&
+        !ParseLineAddress(command, &++pos, &last_line))
+      return;
+  }
+  const bool has_range = pos > 1;
+  if (pos >= command.size())
+    return;
+  if (paged_file_ && (has_range || command.compare(pos, 4, "sort") == 0)) {
+    status_ = "Line ranges do not work while paging " + path_;
+    return;
+  }
+  if (command.compare(pos, 4, "sort") == 0) {
+    if (!has_range) {
+      first_line = 0;
+      last_line = kLastLine;
+    }
+    ExecuteSortCommand(command, pos + 4, first_line, last_line);
+  } else if (command.compare(pos, std::string::npos, ">") == 0 ||
+             command.compare(pos, std::string::npos, "<") == 0) {
+    ResolveLineRange(&first_line, &last_line);
+    ApplyLineOperator(command[pos], first_line, last_line);
+  } else if (command.compare(pos, std::string::npos, "j") == 0 ||
+             command.compare(pos, std::string::npos, "join") == 0) {
+    ResolveLineRange(&first_line, &last_line);
+    ApplyLineOperator('J', first_line, last_line);
+  } else if (command[pos] == 's') {
+    ExecuteSubstituteCommand(command, pos + 1, first_line, last_line);
+  } else if (command[pos] == '!') {
+    // Without a range, vi would run the command without filtering anything.
+    if (has_range)
+      StartFilter(command.substr(pos + 1), first_line, last_line);
+    else
+      status_ = "Give a range to filter, e.g., :%!sort";
+  }
+}
+
+// Turns line addresses into zero-based line numbers, in order.
+void Shell::ResolveLineRange(size_t* first_line, size_t* last_line) {
+  // The range can reach the end of the file.
+  FinishLoading();
+  const size_t line_count = editor_.GetLineCount();
+  const size_t cursor_line = editor_.cursor_row();
+  auto resolve = [line_count, cursor_line](size_t line) -> size_t {
+    if (line == kCursorLine)
+      return cursor_line;
+    if (line == kLastLine)
+      return std::max<size_t>(line_count, 1) - 1;
+    return line;
+  };
+  *first_line = resolve(*first_line);
+  *last_line = resolve(*last_line);
+  if (*first_line > *last_line)
+    std::swap(*first_line, *last_line);
+}
+
+// "s/pattern/replacement/[g]" replaces the first match on each line of the
+// range, or every match with "g". Any punctuation can stand in for the
+// slashes. The pattern matches literally.
+void Shell::ExecuteSubstituteCommand(const std::string& command,
+                                     size_t pos,
+                                     size_t first_line,
+                                     size_t last_line) {
+  if (pos >= command.size() || !ispunct(command[pos]) ||
+      command[pos] == '\\')
+    return;
+  const char delimiter = command[pos++];
+  const std::string pattern = ParseDelimited(command, &pos, delimiter);
+  const std::string replacement = ParseDelimited(command, &pos, delimiter);
+  bool global = false;
+  for (; pos < command.size(); ++pos) {
+    if (command[pos] != 'g') {
+      status_ = std::string("Unknown flag: ") + command[pos];
+      return;
+    }
+    global = true;
+  }
+  if (pattern.empty()) {
+    status_ = "Empty pattern";
+    return;
+  }
+
+  ResolveLineRange(&first_line, &last_line);
+  undo_history_->BeginGroup();
+  const Substitution result = editor_.Substitute(
+      first_line, last_line, StringView(pattern), StringView(replacement),
+      global);
+  undo_history_->EndGroup();
+  if (!result.count) {
+    status_ = "Pattern not found: " + pattern;
+    return;
+  }
+  window_modified_ = true;
+  status_ = CountNoun(result.count, "substitution") + " on " +
+            CountNoun(result.line_count, "line");
+}
+
+// ">" indents, "<" outdents, "J" joins and kToggleComment comments out or
+// uncomments the lines, as one step of undo.
+void Shell::ApplyLineOperator(char command,
+                              size_t first_line,
+                              size_t last_line) {
+  const size_t line_count = std::max<size_t>(editor_.GetLineCount(), 1);
+  last_line = std::min(last_line, line_count - 1);
+  const std::string lines = CountNoun(last_line - first_line + 1, "line");
+  undo_history_->BeginGroup();
+  bool changed = true;
+  switch (command) {
+    case '>':
+      editor_.IndentLines(first_line, last_line);
+      status_ = "Indented " + lines;
+      break;
+    case '<':
+      editor_.OutdentLines(first_line, last_line);
+      status_ = "Outdented " + lines;
+      break;
+    case kToggleComment: {
+      const std::string prefix = GetCommentPrefix(path_);
+      const bool commented =
+          editor_.ToggleComment(first_line, last_line, StringView(prefix));
+      status_ = (commented ? "Commented out " : "Uncommented ") + lines;
+      break;
+    }
+    case 'J':
+      changed = editor_.JoinLines(first_line, last_line);
+      break;
+  }
+  undo_history_->EndGroup();
+  mark_needs_display();
+  if (changed)
+    window_modified_ = true;
+  else
+    Bell();
+}
+
+// "sort [u] [n] [r]" sorts the lines byte by byte, or by the first number in
+// each line with "n". "u" drops repeated lines and "r", or "sort!", reverses
+// the order.
+void Shell::ExecuteSortCommand(const std::string& command,
+                               size_t pos,
+                               size_t first_line,
+                               size_t last_line) {
+  SortOptions options;
+  for (; pos < command.size(); ++pos) {
+    switch (command[pos]) {
+      case ' ':
+        break;
+      case 'u':
+        options.unique = true;
+        break;
+      case 'n':
+        options.numeric = true;
+        break;
+      case 'r':
+      case '!':
+        options.reverse = true;
+        break;
+      default:
+        status_ = std::string("Unknown flag: ") + command[pos];
+        return;
+    }
+  }
+
+  ResolveLineRange(&first_line, &last_line);
+  const size_t line_count = editor_.GetLineCount();
+  undo_history_->BeginGroup();
+  editor_.SortLines(first_line, last_line, options);
+  undo_history_->EndGroup();
+  window_modified_ = true;
+  status_ = "Sorted " + CountNoun(last_line - first_line + 1, "line");
+  const size_t removed = line_count - editor_.GetLineCount();
+  if (removed)
+    status_ += ", removed " + CountNoun(removed, "repeated line");
+}
+
+// Sends the lines to |command| and replaces them with what it writes, once it
+// exits. The command runs in the background, and Ctrl-C cancels it.
+void Shell::StartFilter(const std::string& command,
+                        size_t first_line,
+                        size_t last_line) {
+  if (filter_) {
+    status_ = "Already filtering through " + filter_command_;
+    return;
+  }
+  if (command.empty()) {
+    status_ = "No command to filter through";
+    return;
+  }
+  ResolveLineRange(&first_line, &last_line);
+  const TextRange range = editor_.GetLineRange(first_line, last_line);
+  TextBuffer* text = editor_.text();
+  filter_ = ProcessFilter::Start(
+      command, text->Snapshot().Slice(range.start(), range.end()));
+  if (!filter_) {
+    status_ = "Unable to run " + command;
+    return;
+  }
+  filter_command_ = command;
+  filter_range_.MoveTo(range.start(), range.end());
+  filter_range_.MarkClean();
+  text->AddRange(&filter_range_);
+  status_ = "Filtering through " + command + " (Ctrl-C cancels)";
+}
+
+void Shell::FinishFiltering() {
+  if (!filter_)
+    return;
+  filter_->Wait();
+  CheckFilter();
+}
+
+void Shell::CheckFilter() {
+  ProcessFilter::Result result;
+  if (!filter_ || !filter_->TakeResult(&result))
+    return;
+  filter_.reset();
+  editor_.text()->RemoveRange(&filter_range_);
+  mark_needs_display();
+  std::string status;
+  if (filter_range_.is_dirty()) {
+    status = "The lines changed while filtering; dropped the output of " +
+             filter_command_;
+  } else if (result.exit_status != 0) {
+    status = filter_command_ + " failed with status " +
+             std::to_string(result.exit_status);
+  } else {
+    const std::vector<char>& output = result.output;
+    undo_history_->BeginGroup();
+    editor_.ReplaceText(
+        filter_range_.range(),
+        StringView(output.data(), output.data() + output.size()));
+    undo_history_->EndGroup();
+    window_modified_ = true;
+    status = "Filtered " + CountNoun(filter_range_.length(), "byte") +
+             " through " + filter_command_;
+  }
+  // Leave the status alone while the user is typing a command.
+  if (mode_ != Mode::Command)
+    status_ = status;
+}
+
+void Shell::CancelFilter() {
+  if (!filter_)
+    return;
+  filter_.reset();
+  editor_.text()->RemoveRange(&filter_range_);
+  status_ = "Cancelled " + filter_command_;
+  mark_needs_display();
+}
+
+// ":trace" starts recording trace events and ":trace <path>" writes the
+// events recorded so far to |path|.
+void Shell::ExecuteTraceCommand(const std::string& path) {
+  TraceLog* log = TraceLog::GetInstance();
+  if (!kTraceEventsCompiledIn) {
+    status_ = "Tracing is not compiled into this build";
+  } else if (path.empty()) {
+    log->SetEnabled(true);
+    status_ = "Tracing";
+  } else if (log->WriteToFile(path)) {
+    status_ = "Wrote " + std::to_string(log->GetEventCount()) +
+              " trace events to " + path;
+  } else {
+    status_ = "Unable to write " + path;
+  }
+}
+
+void Shell::Display() {
+  TRACE_EVENT0("shell", "Shell::Display");
+  needs_display_ = false;
+  typedef LatencyStats::Clock Clock;
+  const Clock::time_point start = Clock::now();
+  editor_.UpdateLines();
+  const Clock::time_point lines_updated = Clock::now();
+  stats_.Record(LatencyStats::kUpdateLines, lines_updated - start);
+
+  CommandBuffer& frame = frame_commands_;
+  frame.Clear();
+  frame << term::kEraseScreen;
+  editor_.Display(&frame);
+  frame.MoveCursorTo(0, rows_ - 1);
+  // A status wider than the screen would wrap and scroll the whole screen.
+  // Erasing after a full row would erase its last character.
+  frame.Write(status_.data(), std::min(status_.size(), cols_));
+  if (status_.size() < cols_)
+    frame << term::kEraseToEndOfLine;
+  editor_.UpdateCursor(&frame);
+  ++frame_count_;
+  const Clock::time_point built = Clock::now();
+  stats_.Record(LatencyStats::kBuildFrame, built - lines_updated);
+
+  // In RenderMode::Diffed, computing the difference counts as executing.
+  if (render_mode_ == RenderMode::Diffed) {
+    PaintDiff(&frame);
+  } else {
+    last_frame_size_ = frame.size();
+    frame.Execute(output_);
+  }
+  stats_.Record(LatencyStats::kExecute, Clock::now() - built);
+}
+
+// Applies |frame| to an off-screen copy of the terminal and sends only the
+// rows that differ from what we painted last time.
+void Shell::PaintDiff(CommandBuffer* frame) {
+  frame->Execute(frame_screen_.get());
+  CommandBuffer& commands = diff_commands_;
+  commands.Clear();
+  if (!screen_is_painted_) {
+    // We do not know what the terminal shows until we erase it once.
+    commands << term::kEraseScreen;
+    painted_screen_->Put(term::kEraseScreen);
+    screen_is_painted_ = true;
+  }
+  painted_screen_->Diff(*frame_screen_, &commands);
+  last_frame_size_ = commands.size();
+  commands.Execute(painted_screen_.get());
+  commands.Execute(output_);
+}
+
+}  // namespace zi
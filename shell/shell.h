@@ -0,0 +1,255 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "editing/editor.h"
+#include "files/atomic_file.h"
+#include "shell/latency_stats.h"
+#include "terminal/command_buffer.h"
+#include "text/text_buffer_range.h"
+#include "zen/macros.h"
+
+namespace zi {
+class EditJournal;
+class FileLoader;
+class FileSaver;
+class InputTraceWriter;
+class OutputSink;
+class PagedFile;
+class ProcessFilter;
+class UndoFile;
+class UndoHistory;
+class VirtualTerminal;
+
+enum class Mode {
+  Vi,
+  Command,
+  Input,
+};
+
+enum class RenderMode {
+  // Erase the screen and paint every row in each frame.
+  FullRedraw,
+  // Paint only the rows that changed since the previous frame.
+  Diffed,
+};
+
+// Macros are stored in the named registers 'a' through 'z'.
+constexpr size_t kRegisterCount = 26;
+
+constexpr size_t kDefaultMemoryBudget = size_t(1) << 30;
+constexpr size_t kDefaultUndoBudget = size_t(64) << 20;
+
+class Shell {
+ public:
+  // |output| must outlive the shell.
+  Shell(OutputSink* output, size_t cols, size_t rows);
+  ~Shell();
+
+  void SetRenderMode(RenderMode mode);
+  // Files larger than |budget| bytes are paged: the shell holds a window of
+  // about a quarter of the budget in memory and keeps edits outside the window
+  // as overlays, within half of the budget, until the file is saved.
+  void SetMemoryBudget(size_t budget) { memory_budget_ = budget; }
+  void SetDurability(Durability durability) { durability_ = durability; }
+  // Once the undo history takes more than |budget| bytes, its oldest steps
+  // are forgotten. Changing the budget forgets the whole history.
+  void SetUndoBudget(size_t budget);
+
+  // Large files load in the background. Their first screen is ready when
+  // this returns, and the rest is added as the shell runs. If the shell
+  // crashed while editing |path|, the edits are recovered from its journal.
+  void OpenFile(const std::string& path);
+  // Blocks until the file being opened is completely loaded.
+  void FinishLoading();
+  bool is_loading() const { return loader_ != nullptr; }
+  bool is_paged() const { return paged_file_ != nullptr; }
+  // Starts writing a snapshot of the text on a background thread. The status
+  // reports when the write completes.
+  void Save();
+  // Blocks until every save has been written.
+  void FinishSaving();
+  // Blocks until the command that ":!" started exits and its output replaces
+  // the lines it filtered.
+  void FinishFiltering();
+  bool is_filtering() const { return filter_ != nullptr; }
+
+  // Reads the terminal until the user quits. If |input_trace| is non-null,
+  // every read is recorded to it.
+  int Run(InputTraceWriter* input_trace);
+
+  // Handles a batch of input as if it had been read from the terminal and
+  // paints the result.
+  void ProcessInput(const char* data, size_t length);
+
+  void mark_needs_display() { needs_display_ = true; }
+
+  bool should_quit() const { return should_quit_; }
+  const std::string& status() const { return status_; }
+  size_t frame_count() const { return frame_count_; }
+  size_t last_frame_size() const { return last_frame_size_; }
+  // The heap allocations made between reading the input of the last frame and
+  // painting it. Always zero unless the binary links //zen:allocation_hooks.
+  uint64_t last_frame_allocation_count() const {
+    return last_frame_allocation_count_;
+  }
+  const LatencyStats& stats() const { return stats_; }
+
+ private:
+  void SetText(std::unique_ptr<TextBuffer> text);
+
+  void StartLoading();
+  void ContinueLoading();
+  void UpdateLoadStatus();
+  bool WaitForInputWhileBusy();
+  void CheckSaves();
+  void CheckFilter();
+  void CancelFilter();
+
+  size_t GetWindowSize() const;
+  bool LoadWindow(uint64_t start, uint64_t length);
+  bool CommitWindow(bool force);
+  bool PageForward();
+  bool PageBackward();
+  void SavePagedFile();
+
+  void OpenUndoFile();
+  void CloseUndoFile();
+
+  void StartJournal(uint64_t base_size);
+  void CloseJournal();
+  void MaybeCheckpointJournal();
+
+  void HandleInput(const char* data,
+                   size_t length,
+                   LatencyStats::Clock::time_point read_time);
+  void Display();
+  void PaintDiff(CommandBuffer* frame);
+  void Bell();
+
+  void HandleCharacter(char c);
+  void DispatchCharacter(char c);
+  void HandleCharacterInViMode(char c);
+  void HandleCharacterInCommandMode(char c);
+  void HandleCharacterInInputMode(char c);
+  void HandlePendingCommand(char c);
+
+  size_t TakeCount();
+  void MoveCursor(bool (Editor::*move)(), size_t count);
+  void GoToLine(size_t line);
+  void StepHistory(bool (Editor::*step)(UndoHistory*), size_t count);
+
+  void StartRecording(char name);
+  void StopRecording();
+  void ExecuteRegister(char name, size_t count);
+
+  void ExecuteCommand(const std::string& command);
+  void ExecuteTraceCommand(const std::string& path);
+  void ExecuteRangeCommand(const std::string& command);
+  void ResolveLineRange(size_t* first_line, size_t* last_line);
+  void ExecuteSubstituteCommand(const std::string& command,
+                                size_t pos,
+                                size_t first_line,
+                                size_t last_line);
+  void ApplyLineOperator(char command, size_t first_line, size_t last_line);
+  void ExecuteSortCommand(const std::string& command,
+                          size_t pos,
+                          size_t first_line,
+                          size_t last_line);
+  void StartFilter(const std::string& command,
+                   size_t first_line,
+                   size_t last_line);
+
+  OutputSink* output_;
+  const size_t cols_;
+  const size_t rows_;
+
+  RenderMode render_mode_ = RenderMode::FullRedraw;
+  // In RenderMode::Diffed, what the terminal shows and what the next frame
+  // should look like.
+  std::unique_ptr<VirtualTerminal> painted_screen_;
+  std::unique_ptr<VirtualTerminal> frame_screen_;
+  bool screen_is_painted_ = false;
+
+  // Reused from frame to frame so that painting does not allocate.
+  CommandBuffer frame_commands_;
+  CommandBuffer diff_commands_;
+
+  std::string path_;
+  std::unique_ptr<FileLoader> loader_;
+  bool showing_load_status_ = false;
+  std::unique_ptr<FileSaver> saver_;
+  Durability durability_ = Durability::FileAndDirectory;
+
+  // The command that ":!" is running and the lines its output replaces. If
+  // the lines change in the meantime, the output is dropped.
+  std::unique_ptr<ProcessFilter> filter_;
+  std::string filter_command_;
+  TextBufferRange filter_range_;
+
+  // Records the edits to the text so that they can be recovered after a
+  // crash. Paged files are not journaled.
+  std::unique_ptr<EditJournal> journal_;
+
+  // In paging mode, the editor holds [window_start_, window_end_) of the file.
+  size_t memory_budget_ = kDefaultMemoryBudget;
+  std::unique_ptr<PagedFile> paged_file_;
+  uint64_t window_start_ = 0;
+  uint64_t window_end_ = 0;
+  bool window_modified_ = false;
+  Mode mode_ = Mode::Vi;
+  std::string status_;
+  Editor editor_;
+
+  // An insert session or a macro replay undoes as one step. In paging mode,
+  // the history covers the edits to the current window. Otherwise, the steps
+  // are moved to the undo file when the text is saved, so that they can be
+  // undone in later sessions.
+  std::unique_ptr<UndoFile> undo_file_;
+  std::unique_ptr<UndoHistory> undo_history_;
+  // The save tag of the last key in the undo file.
+  uint64_t undo_key_tag_ = 0;
+
+  bool should_quit_ = false;
+  bool needs_display_ = false;
+
+  size_t frame_count_ = 0;
+  size_t last_frame_size_ = 0;
+  uint64_t last_frame_allocation_count_ = 0;
+  LatencyStats stats_;
+
+  // Vi mode state that spans several keystrokes, e.g. "3@a".
+  size_t count_ = 0;
+  char pending_command_ = '\0';
+
+  std::string registers_[kRegisterCount];
+  char recording_register_ = '\0';
+  char last_executed_register_ = '\0';
+
+  // While a macro replays, keystrokes are dispatched without painting in
+  // between. The first failing command aborts the rest of the replay.
+  int replay_depth_ = 0;
+  bool replay_failed_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(Shell);
+};
+
+}  // namespace zi
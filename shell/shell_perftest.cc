@@ -0,0 +1,117 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "shell/shell.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "terminal/virtual_terminal.h"
+#include "zen/allocation_counter.h"
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+constexpr size_t kCols = 120;
+constexpr size_t kRows = 40;
+
+// Moves through a 10k line file and edits it, one keystroke per frame, and
+// reports how much output and how many allocations each frame takes with the
+// given render mode.
+void RunEditingWorkload(BenchmarkState* state, RenderMode mode) {
+  char path[] = "/tmp/zi_shell_perftest_XXXXXX";
+  int fd = mkstemp(path);
+  std::string text;
+  for (size_t i = 0; i < 10000; ++i)
+    text += "line " + std::to_string(i) + " of the benchmark text\n";
+  write(fd, text.data(), text.size());
+  close(fd);
+
+  VirtualTerminal terminal(kCols, kRows);
+  Shell shell(&terminal, kCols, kRows);
+  shell.SetRenderMode(mode);
+  shell.OpenFile(path);
+  unlink(path);
+
+  const std::string keys = "jjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjj"
+                           "ihello\x1bjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjjj";
+  // Go through the keys once so that the counts reflect the steady state
+  // rather than building the line index and buffers for the first time.
+  for (char c : keys)
+    shell.ProcessInput(&c, 1);
+
+  size_t i = 0;
+  const size_t bytes_written = terminal.bytes_written();
+  const size_t escape_count = terminal.escape_count();
+  ScopedAllocationCounter allocations;
+  while (state->KeepRunning()) {
+    shell.ProcessInput(&keys[i], 1);
+    i = (i + 1) % keys.size();
+  }
+  const double frames = state->iterations();
+  state->SetBytesProcessed(terminal.bytes_written() - bytes_written);
+  state->SetCounter("bytes_per_frame",
+                    (terminal.bytes_written() - bytes_written) / frames);
+  state->SetCounter("escapes_per_frame",
+                    (terminal.escape_count() - escape_count) / frames);
+  state->SetCounter("allocations_per_frame", allocations.count() / frames);
+}
+
+void Shell_FullRedraw(BenchmarkState* state) {
+  RunEditingWorkload(state, RenderMode::FullRedraw);
+}
+BENCHMARK(Shell_FullRedraw);
+
+void Shell_DiffedRedraw(BenchmarkState* state) {
+  RunEditingWorkload(state, RenderMode::Diffed);
+}
+BENCHMARK(Shell_DiffedRedraw);
+
+// Types and deletes in a 10k line file with a cursor on each of the first
+// |arg| lines, one keystroke per frame.
+void Shell_TypeWithCursors(BenchmarkState* state) {
+  char path[] = "/tmp/zi_shell_perftest_XXXXXX";
+  int fd = mkstemp(path);
+  std::string text;
+  for (size_t i = 0; i < 10000; ++i)
+    text += "line " + std::to_string(i) + " of the benchmark text\n";
+  write(fd, text.data(), text.size());
+  close(fd);
+
+  VirtualTerminal terminal(kCols, kRows);
+  Shell shell(&terminal, kCols, kRows);
+  shell.SetRenderMode(RenderMode::Diffed);
+  shell.OpenFile(path);
+  unlink(path);
+
+  std::string setup = "i";
+  if (state->arg() > 1)
+    setup = std::to_string(state->arg() - 1) + "+" + setup;
+  shell.ProcessInput(setup.data(), setup.size());
+  // Deleting what was typed keeps the lines from growing.
+  const char keys[] = "hello\x7f\x7f\x7f\x7f\x7f";
+  size_t i = 0;
+  while (state->KeepRunning()) {
+    shell.ProcessInput(&keys[i], 1);
+    i = (i + 1) % (sizeof(keys) - 1);
+  }
+  state->SetItemsProcessed(state->iterations() * state->arg());
+}
+BENCHMARK(Shell_TypeWithCursors, 1, 100, 10000);
+
+}  // namespace
+}  // namespace zi
@@ -0,0 +1,567 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "shell/shell.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "files/edit_journal.h"
+#include "gtest/gtest.h"
+#include "terminal/virtual_terminal.h"
+#include "text/text_buffer.h"
+#include "zen/allocation_counter.h"
+
+namespace zi {
+namespace {
+
+class ShellTest : public ::testing::Test {
+ protected:
+  ShellTest() : terminal_(20, 5), shell_(&terminal_, 20, 5) {}
+
+  void OpenText(const std::string& text) {
+    char path[] = "/tmp/zi_shell_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    ASSERT_EQ(static_cast<ssize_t>(text.size()),
+              write(fd, text.data(), text.size()));
+    close(fd);
+    shell_.OpenFile(path);
+    unlink(path);
+  }
+
+  void Type(const std::string& keys) {
+    shell_.ProcessInput(keys.data(), keys.size());
+  }
+
+  VirtualTerminal terminal_;
+  Shell shell_;
+};
+
+TEST_F(ShellTest, Display) {
+  OpenText("one\ntwo\n");
+  Type("jiX");
+  EXPECT_EQ("one", terminal_.GetRowText(0));
+  EXPECT_EQ("Xtwo", terminal_.GetRowText(1));
+  EXPECT_EQ("~", terminal_.GetRowText(2));
+  EXPECT_EQ(1u, terminal_.cursor_col());
+  EXPECT_EQ(1u, terminal_.cursor_row());
+}
+
+TEST_F(ShellTest, Macro) {
+  OpenText("a\nb\nc\nd\n");
+  Type("qqi-\x1bjq");
+  const size_t frame_count = shell_.frame_count();
+  Type("2@q");
+  // The whole replay paints once.
+  EXPECT_EQ(frame_count + 1, shell_.frame_count());
+  EXPECT_EQ("-a", terminal_.GetRowText(0));
+  EXPECT_EQ("-b", terminal_.GetRowText(1));
+  EXPECT_EQ("-c", terminal_.GetRowText(2));
+  EXPECT_EQ("d", terminal_.GetRowText(3));
+  EXPECT_EQ(0u, terminal_.bell_count());
+  // The "j" fails on the last line, which stops the replay and rings the bell
+  // once, however large the count.
+  Type("5@@");
+  EXPECT_EQ("-d", terminal_.GetRowText(3));
+  EXPECT_EQ(1u, terminal_.bell_count());
+}
+
+TEST_F(ShellTest, UndoRedo) {
+  OpenText("one\ntwo\n");
+  Type("jiab\x1bix\x1b");
+  EXPECT_EQ("abxtwo", terminal_.GetRowText(1));
+  // Each insert session undoes as one step.
+  Type("u");
+  EXPECT_EQ("abtwo", terminal_.GetRowText(1));
+  EXPECT_EQ(2u, terminal_.cursor_col());
+  EXPECT_EQ(1u, terminal_.cursor_row());
+  Type("u");
+  EXPECT_EQ("two", terminal_.GetRowText(1));
+  EXPECT_EQ(0u, terminal_.bell_count());
+  Type("u");
+  EXPECT_EQ(1u, terminal_.bell_count());
+  Type("2\x12");
+  EXPECT_EQ("abxtwo", terminal_.GetRowText(1));
+  Type("\x12");
+  EXPECT_EQ(2u, terminal_.bell_count());
+}
+
+TEST_F(ShellTest, UndoMacro) {
+  OpenText("a\nb\nc\nd\n");
+  Type("qqi-\x1bjq2@q");
+  EXPECT_EQ("-c", terminal_.GetRowText(2));
+  // The whole replay undoes as one step.
+  Type("u");
+  EXPECT_EQ("-a", terminal_.GetRowText(0));
+  EXPECT_EQ("b", terminal_.GetRowText(1));
+  EXPECT_EQ("c", terminal_.GetRowText(2));
+  EXPECT_EQ(1u, terminal_.cursor_row());
+}
+
+TEST_F(ShellTest, ExtraCursors) {
+  OpenText("one\ntwo\nthree\n");
+  Type("l2+");
+  EXPECT_EQ(2u, terminal_.cursor_row());
+  // The extra cursors show in reverse video.
+  EXPECT_TRUE(terminal_.GetCell(1, 0).attributes &
+              VirtualTerminal::kReverseVideo);
+  EXPECT_TRUE(terminal_.GetCell(1, 1).attributes &
+              VirtualTerminal::kReverseVideo);
+  EXPECT_FALSE(terminal_.GetCell(1, 2).attributes &
+               VirtualTerminal::kReverseVideo);
+  Type("i[]\x1b");
+  EXPECT_EQ("o[]ne", terminal_.GetRowText(0));
+  EXPECT_EQ("t[]wo", terminal_.GetRowText(1));
+  EXPECT_EQ("t[]hree", terminal_.GetRowText(2));
+  EXPECT_EQ(3u, terminal_.cursor_col());
+  // Typing at every cursor undoes as one step.
+  Type("u");
+  EXPECT_EQ("one", terminal_.GetRowText(0));
+  EXPECT_EQ("three", terminal_.GetRowText(2));
+  // Undoing moves the cursor to the first line, and escape leaves it as the
+  // only cursor.
+  Type("\x1bix");
+  EXPECT_EQ("oxne", terminal_.GetRowText(0));
+  EXPECT_EQ("two", terminal_.GetRowText(1));
+  EXPECT_FALSE(terminal_.GetCell(1, 1).attributes &
+               VirtualTerminal::kReverseVideo);
+  EXPECT_EQ(0u, terminal_.bell_count());
+}
+
+TEST_F(ShellTest, LineOperators) {
+  OpenText("a\nb\nc\nd\n");
+  Type("2>>");
+  EXPECT_EQ("Indented 2 lines", shell_.status());
+  EXPECT_EQ("  a", terminal_.GetRowText(0));
+  EXPECT_EQ("  b", terminal_.GetRowText(1));
+  EXPECT_EQ(2u, terminal_.cursor_col());
+
+  Type("j<<");
+  EXPECT_EQ("Outdented 1 line", shell_.status());
+  EXPECT_EQ("b", terminal_.GetRowText(1));
+
+  Type("3gcc");
+  EXPECT_EQ("Commented out 3 lines", shell_.status());
+  EXPECT_EQ("// b", terminal_.GetRowText(1));
+  EXPECT_EQ("// d", terminal_.GetRowText(3));
+  Type("gcc");
+  EXPECT_EQ("Uncommented 1 line", shell_.status());
+  EXPECT_EQ("b", terminal_.GetRowText(1));
+
+  Type(":1,2j\r");
+  EXPECT_EQ("  a b", terminal_.GetRowText(0));
+  EXPECT_EQ("// c", terminal_.GetRowText(1));
+  EXPECT_EQ(3u, terminal_.cursor_col());
+  Type("u");
+  EXPECT_EQ("  a", terminal_.GetRowText(0));
+  EXPECT_EQ("b", terminal_.GetRowText(1));
+
+  Type(":%<\r");
+  EXPECT_EQ("Outdented 4 lines", shell_.status());
+  EXPECT_EQ("a", terminal_.GetRowText(0));
+
+  EXPECT_EQ(0u, terminal_.bell_count());
+  Type("jjjJ");
+  EXPECT_EQ(1u, terminal_.bell_count());
+  Type("gx");
+  EXPECT_EQ(2u, terminal_.bell_count());
+  Type("kJ");
+  EXPECT_EQ("// c // d", terminal_.GetRowText(2));
+}
+
+TEST_F(ShellTest, WordAndParagraphMotions) {
+  OpenText("foo bar\n\nbaz qux\n");
+  Type("w");
+  EXPECT_EQ(0u, terminal_.cursor_row());
+  EXPECT_EQ(4u, terminal_.cursor_col());
+  Type("w");
+  EXPECT_EQ(1u, terminal_.cursor_row());
+  Type("we");
+  EXPECT_EQ(2u, terminal_.cursor_row());
+  EXPECT_EQ(2u, terminal_.cursor_col());
+  Type("b");
+  EXPECT_EQ(0u, terminal_.cursor_col());
+
+  Type("}");
+  EXPECT_EQ(2u, terminal_.cursor_row());
+  EXPECT_EQ(6u, terminal_.cursor_col());
+  Type("{");
+  EXPECT_EQ(1u, terminal_.cursor_row());
+  Type("{");
+  EXPECT_EQ(0u, terminal_.cursor_row());
+  EXPECT_EQ(0u, terminal_.cursor_col());
+
+  Type("3W");
+  EXPECT_EQ(2u, terminal_.cursor_row());
+  EXPECT_EQ(0u, terminal_.cursor_col());
+  EXPECT_EQ(0u, terminal_.bell_count());
+  Type("100w");
+  EXPECT_EQ(2u, terminal_.cursor_row());
+  EXPECT_EQ(6u, terminal_.cursor_col());
+  EXPECT_EQ(1u, terminal_.bell_count());
+}
+
+TEST_F(ShellTest, Sort) {
+  OpenText("b\n10\nb\n9\n");
+  Type("j");
+  // Without a range, every line is sorted.
+  Type(":sort\r");
+  EXPECT_EQ("Sorted 4 lines", shell_.status());
+  EXPECT_EQ("10", terminal_.GetRowText(0));
+  EXPECT_EQ("9", terminal_.GetRowText(1));
+  EXPECT_EQ("b", terminal_.GetRowText(3));
+  EXPECT_EQ(0u, terminal_.cursor_row());
+
+  Type(":1,2sort n\r");
+  EXPECT_EQ("9", terminal_.GetRowText(0));
+  EXPECT_EQ("10", terminal_.GetRowText(1));
+
+  Type(":3,$sort u\r");
+  EXPECT_EQ("Sorted 2 lines, removed 1 repeated line", shell_.status());
+  EXPECT_EQ("b", terminal_.GetRowText(2));
+  EXPECT_EQ("~", terminal_.GetRowText(3));
+
+  Type(":sort x\r");
+  EXPECT_EQ("Unknown flag: x", shell_.status());
+
+  // Each sort undoes as one step.
+  Type("u");
+  EXPECT_EQ("b", terminal_.GetRowText(3));
+  Type(":sort!\r");
+  EXPECT_EQ("b", terminal_.GetRowText(0));
+  EXPECT_EQ("9", terminal_.GetRowText(2));
+  EXPECT_EQ("10", terminal_.GetRowText(3));
+  Type(":%sort r n\r");
+  EXPECT_EQ("10", terminal_.GetRowText(0));
+  EXPECT_EQ("9", terminal_.GetRowText(1));
+}
+
+TEST_F(ShellTest, Stats) {
+  OpenText("one\ntwo\n");
+  Type("j");
+  Type("k");
+  Type(":stats\r");
+  EXPECT_EQ(0u, shell_.status().find("paint: p50 "));
+  EXPECT_EQ(3u, shell_.stats().histogram(LatencyStats::kInputToPaint).count());
+  Type(":stats lines\r");
+  EXPECT_EQ(0u, shell_.status().find("lines: p50 "));
+  Type(":stats bogus\r");
+  EXPECT_EQ("Unknown phase: bogus", shell_.status());
+  Type(":statsXlines\r");
+  EXPECT_EQ(std::string::npos, shell_.status().find("p50"));
+}
+
+TEST_F(ShellTest, TraceCommand) {
+  OpenText("one\n");
+  Type(":traceoff\r");
+  EXPECT_NE(0u, shell_.status().find("Trac"));
+  EXPECT_NE(0u, shell_.status().find("Wrote"));
+  EXPECT_NE(0u, shell_.status().find("Unable"));
+}
+
+TEST_F(ShellTest, Substitute) {
+  OpenText("a a\nb a\na a\nb\n");
+  Type(":%s/a/xy/\r");
+  EXPECT_EQ("3 substitutions on 3 lines", shell_.status());
+  EXPECT_EQ("xy a", terminal_.GetRowText(0));
+  EXPECT_EQ("b xy", terminal_.GetRowText(1));
+  EXPECT_EQ("xy a", terminal_.GetRowText(2));
+  // The cursor goes to the last line that changed.
+  EXPECT_EQ(2u, terminal_.cursor_row());
+  EXPECT_EQ(0u, terminal_.cursor_col());
+
+  Type(":1,2s# #\\##g\r");
+  EXPECT_EQ("2 substitutions on 2 lines", shell_.status());
+  EXPECT_EQ("xy#a", terminal_.GetRowText(0));
+  EXPECT_EQ("b#xy", terminal_.GetRowText(1));
+  EXPECT_EQ("xy a", terminal_.GetRowText(2));
+  EXPECT_EQ(1u, terminal_.cursor_row());
+
+  Type(":s/x/X/\r");
+  EXPECT_EQ("1 substitution on 1 line", shell_.status());
+  EXPECT_EQ("b#Xy", terminal_.GetRowText(1));
+  Type(":$s/z/Z/\r");
+  EXPECT_EQ("Pattern not found: z", shell_.status());
+  Type(":s/a/b/q\r");
+  EXPECT_EQ("Unknown flag: q", shell_.status());
+  Type(":s//b/\r");
+  EXPECT_EQ("Empty pattern", shell_.status());
+
+  // Each substitution undoes as one step.
+  Type("u");
+  EXPECT_EQ("b#xy", terminal_.GetRowText(1));
+  Type("u");
+  EXPECT_EQ("xy a", terminal_.GetRowText(0));
+  EXPECT_EQ("b xy", terminal_.GetRowText(1));
+  EXPECT_EQ(0u, terminal_.bell_count());
+}
+
+TEST_F(ShellTest, Filter) {
+  OpenText("c\nb\na\nd\n");
+  Type(":1,3!sort\r");
+  EXPECT_TRUE(shell_.is_filtering());
+  shell_.FinishFiltering();
+  EXPECT_FALSE(shell_.is_filtering());
+  Type("\x1b");
+  EXPECT_EQ("Filtered 6 bytes through sort", shell_.status());
+  EXPECT_EQ("a", terminal_.GetRowText(0));
+  EXPECT_EQ("b", terminal_.GetRowText(1));
+  EXPECT_EQ("c", terminal_.GetRowText(2));
+  EXPECT_EQ("d", terminal_.GetRowText(3));
+  Type("u");
+  EXPECT_EQ("c", terminal_.GetRowText(0));
+  EXPECT_EQ("a", terminal_.GetRowText(2));
+
+  Type(":%!exit 2\r");
+  shell_.FinishFiltering();
+  EXPECT_EQ("exit 2 failed with status 2", shell_.status());
+  EXPECT_EQ("c", terminal_.GetRowText(0));
+  Type(":!sort\r");
+  EXPECT_EQ("Give a range to filter, e.g., :%!sort", shell_.status());
+
+  // Ctrl-C stops the command and leaves the text alone.
+  Type(":.!sleep 10\r");
+  EXPECT_TRUE(shell_.is_filtering());
+  Type("\x03");
+  EXPECT_FALSE(shell_.is_filtering());
+  EXPECT_EQ("Cancelled sleep 10", shell_.status());
+
+  // The output is dropped if the lines change while the command runs.
+  Type(":2,3!sleep 0.2; tr a-z A-Z\r");
+  Type("jjix\x1b");
+  shell_.FinishFiltering();
+  Type("\x1b");
+  EXPECT_EQ("b", terminal_.GetRowText(1));
+  EXPECT_EQ("xa", terminal_.GetRowText(2));
+  EXPECT_EQ(0u, shell_.status().find("The lines changed while filtering"));
+}
+
+TEST_F(ShellTest, ProgressiveLoad) {
+  std::string text;
+  for (size_t i = 0; text.size() < (6 << 20); ++i)
+    text += "line " + std::to_string(i) + "\n";
+  OpenText(text);
+  EXPECT_TRUE(shell_.is_loading());
+  Type("j");
+  EXPECT_EQ("line 0", terminal_.GetRowText(0));
+  EXPECT_EQ("Loading /tmp/zi_shel", terminal_.GetRowText(4));
+  EXPECT_EQ(1u, terminal_.cursor_row());
+  EXPECT_EQ(0u, shell_.status().find("Loading "));
+
+  shell_.FinishLoading();
+  EXPECT_FALSE(shell_.is_loading());
+  EXPECT_EQ("", shell_.status());
+  Type("k");
+  EXPECT_EQ(0u, terminal_.cursor_row());
+}
+
+TEST_F(ShellTest, BackgroundSave) {
+  char path[] = "/tmp/zi_shell_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  shell_.OpenFile(path);
+  Type("ione\x1b:w\r");
+  EXPECT_EQ(std::string("Saving ") + path, shell_.status());
+  // Editing continues while the snapshot is written.
+  Type("itwo\x1b");
+  shell_.FinishSaving();
+  EXPECT_EQ(std::string("Saved 3 bytes to ") + path, shell_.status());
+  std::string saved(4, '\0');
+  fd = open(path, O_RDONLY);
+  ASSERT_NE(-1, fd);
+  EXPECT_EQ(3, read(fd, &saved[0], saved.size()));
+  close(fd);
+  unlink(path);
+  unlink((std::string(path) + ".undo").c_str());
+  EXPECT_EQ("one", saved.substr(0, 3));
+}
+
+TEST_F(ShellTest, UndoesEditsFromEarlierSessions) {
+  char path[] = "/tmp/zi_shell_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(4, write(fd, "one\n", 4));
+  close(fd);
+  shell_.OpenFile(path);
+  Type("ia\x1b:w\r");
+  Type("ib\x1b:w\r");
+  shell_.FinishSaving();
+  shell_.OpenFile(path);
+  EXPECT_EQ("abone", terminal_.GetRowText(0));
+  Type("u");
+  EXPECT_EQ("aone", terminal_.GetRowText(0));
+  Type("u");
+  EXPECT_EQ("one", terminal_.GetRowText(0));
+  EXPECT_EQ(0u, terminal_.bell_count());
+  Type("u");
+  EXPECT_EQ(1u, terminal_.bell_count());
+  Type("\x12");
+  EXPECT_EQ("aone", terminal_.GetRowText(0));
+  unlink(path);
+  unlink((std::string(path) + ".undo").c_str());
+}
+
+TEST_F(ShellTest, RecoversEditsFromJournal) {
+  char path[] = "/tmp/zi_shell_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(6, write(fd, "hello\n", 6));
+  close(fd);
+  // Leave a journal behind as if the editor had crashed.
+  const std::string journal_path = std::string(path) + ".journal";
+  {
+    TextBuffer text(std::vector<char>({'h', 'e', 'l', 'l', 'o', '\n'}));
+    std::unique_ptr<EditJournal> journal =
+        EditJournal::Create(journal_path, 6);
+    text.AddObserver(journal.get());
+    text.InsertText(TextPosition(5), std::string(", world"));
+    text.RemoveObserver(journal.get());
+  }
+  shell_.OpenFile(path);
+  EXPECT_EQ("Recovered 1 edits from " + journal_path, shell_.status());
+  Type("l");
+  EXPECT_EQ("hello, world", terminal_.GetRowText(0));
+  shell_.OpenFile(path);
+  unlink(path);
+  // Abandoning the edits removes the journal.
+  EXPECT_EQ(-1, access(journal_path.c_str(), F_OK));
+}
+
+TEST_F(ShellTest, PagedFile) {
+  std::string text;
+  for (size_t i = 0; i < 100; ++i)
+    text += "line " + std::to_string(i) + "\n";
+  char path[] = "/tmp/zi_shell_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(static_cast<ssize_t>(text.size()),
+            write(fd, text.data(), text.size()));
+  close(fd);
+  // Windows of 100 bytes hold lines 0 to 12, 13 to 24, and so on.
+  shell_.SetMemoryBudget(400);
+  shell_.OpenFile(path);
+  EXPECT_TRUE(shell_.is_paged());
+  EXPECT_EQ(std::string("Paging ") + path + " (0%)", shell_.status());
+
+  Type("13j");
+  EXPECT_EQ("line 13", terminal_.GetRowText(terminal_.cursor_row()));
+  Type("k");
+  EXPECT_EQ("line 12", terminal_.GetRowText(terminal_.cursor_row()));
+  Type("iX\x1b:50\r");
+  EXPECT_EQ("line 49", terminal_.GetRowText(terminal_.cursor_row()));
+  Type("30k");
+  EXPECT_EQ("line 19", terminal_.GetRowText(terminal_.cursor_row()));
+  Type("7k");
+  EXPECT_EQ("Xline 12", terminal_.GetRowText(terminal_.cursor_row()));
+
+  Type(":w\r");
+  std::string saved(text.size() + 1, '\0');
+  fd = open(path, O_RDONLY);
+  ASSERT_NE(-1, fd);
+  EXPECT_EQ(static_cast<ssize_t>(saved.size()),
+            read(fd, &saved[0], saved.size() + 1));
+  close(fd);
+  unlink(path);
+  EXPECT_EQ(text.substr(0, 86) + "X" + text.substr(86), saved);
+  EXPECT_EQ("Xline 12", terminal_.GetRowText(terminal_.cursor_row()));
+}
+
+TEST_F(ShellTest, PagedFileRefusesLineRanges) {
+  std::string text;
+  for (size_t i = 0; i < 100; ++i)
+    text += "line " + std::to_string(i) + "\n";
+  char path[] = "/tmp/zi_shell_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(static_cast<ssize_t>(text.size()),
+            write(fd, text.data(), text.size()));
+  close(fd);
+  shell_.SetMemoryBudget(400);
+  shell_.OpenFile(path);
+  unlink(path);
+  ASSERT_TRUE(shell_.is_paged());
+
+  // Line numbers count lines of the file, but only a window of them is
+  // loaded.
+  const std::string refused =
+      std::string("Line ranges do not work while paging ") + path;
+  Type(":50s/line/X/\r");
+  EXPECT_EQ(refused, shell_.status());
+  Type(":%s/line/X/g\r");
+  EXPECT_EQ(refused, shell_.status());
+  Type(":sort\r");
+  EXPECT_EQ(refused, shell_.status());
+  Type(":%!sort\r");
+  EXPECT_EQ(refused, shell_.status());
+  EXPECT_EQ("line 0", terminal_.GetRowText(0));
+  EXPECT_EQ("line 1", terminal_.GetRowText(1));
+
+  // The cursor's line is in the window.
+  Type("j:s/line/X/\r");
+  EXPECT_EQ("1 substitution on 1 line", shell_.status());
+  EXPECT_EQ("X 1", terminal_.GetRowText(1));
+}
+
+TEST_F(ShellTest, DiffedMatchesFullRedraw) {
+  VirtualTerminal full_terminal(20, 5);
+  Shell full_shell(&full_terminal, 20, 5);
+  shell_.SetRenderMode(RenderMode::Diffed);
+
+  const std::string keys = "jjiHello\rworld\x1bkkl";
+  for (char c : keys) {
+    Type(std::string(1, c));
+    full_shell.ProcessInput(&c, 1);
+    for (size_t row = 0; row < 5; ++row)
+      EXPECT_EQ(full_terminal.GetRowText(row), terminal_.GetRowText(row));
+    EXPECT_EQ(full_terminal.cursor_col(), terminal_.cursor_col());
+    EXPECT_EQ(full_terminal.cursor_row(), terminal_.cursor_row());
+  }
+  EXPECT_LT(terminal_.bytes_written(), full_terminal.bytes_written());
+}
+
+// Once the buffers have grown to fit, a keystroke should not touch the heap
+// between reading the input and painting the frame.
+void ExpectKeystrokesDoNotAllocate(Shell* shell, RenderMode mode) {
+  ASSERT_TRUE(IsAllocationCountingEnabled());
+  shell->SetRenderMode(mode);
+  // Warm up: the first edit grows the gap and the first frames grow the
+  // command buffers and line index.
+  const std::string warm_up = "jjiab\x1bkkjj";
+  for (char c : warm_up)
+    shell->ProcessInput(&c, 1);
+
+  const std::string keys = "ihello, world\x7f\x7f\x1bjjkkllhh";
+  for (char c : keys) {
+    shell->ProcessInput(&c, 1);
+    EXPECT_EQ(0u, shell->last_frame_allocation_count()) << "key " << int(c);
+  }
+}
+
+TEST_F(ShellTest, KeystrokesDoNotAllocate) {
+  OpenText(std::string(400, 'a') + "\n" + std::string(400, 'b') + "\nc\nd\n");
+  ExpectKeystrokesDoNotAllocate(&shell_, RenderMode::FullRedraw);
+}
+
+TEST_F(ShellTest, DiffedKeystrokesDoNotAllocate) {
+  OpenText(std::string(400, 'a') + "\n" + std::string(400, 'b') + "\nc\nd\n");
+  ExpectKeystrokesDoNotAllocate(&shell_, RenderMode::Diffed);
+}
+
+}  // namespace
+}  // namespace zi
@@ -14,6 +14,10 @@
 
 #include "terminal/command_buffer.h"
 
+#include <string.h>
+
+#include "zen/trace_event.h"
+
 namespace zi {
 
 CommandBuffer::CommandBuffer() {}
@@ -30,24 +34,55 @@ CommandBuffer& CommandBuffer::operator<<(const TextView& text) {
   return *this << text.left() << text.right();
 }
 
+CommandBuffer& CommandBuffer::operator<<(const std::string& text) {
+  buffer_.append(text);
+  return *this;
+}
+
+CommandBuffer& CommandBuffer::operator<<(const char* text) {
+  buffer_.append(text, strlen(text));
+  return *this;
+}
+
+CommandBuffer& CommandBuffer::operator<<(int value) {
+  // Formats by hand because std::to_string would allocate.
+  char digits[16];
+  char* end = digits + sizeof(digits);
+  char* begin = end;
+  unsigned magnitude = value < 0 ? 0u - value : value;
+  do {
+    *--begin = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude);
+  if (value < 0)
+    *--begin = '-';
+  buffer_.append(begin, end - begin);
+  return *this;
+}
+
 void CommandBuffer::Write(const char* buffer, size_t length) {
-  stream_.write(buffer, length);
+  buffer_.append(buffer, length);
 }
 
 void CommandBuffer::MoveCursorTo(int x, int y) {
-  stream_ << ESC "[" << y + 1 << ";" << x + 1 << "H";
+  *this << ESC "[" << y + 1 << ";" << x + 1 << "H";
 }
 
 void CommandBuffer::SetForegroundColor(term::Color color) {
-  stream_ << ESC "[" << term::kForegroundColors[static_cast<int>(color)] << "m";
+  *this << ESC "[" << term::kForegroundColors[static_cast<int>(color)] << "m";
 }
 
 void CommandBuffer::SetBackgroundColor(term::Color color) {
-  stream_ << ESC "[" << term::kBackgroundColors[static_cast<int>(color)] << "m";
+  *this << ESC "[" << term::kBackgroundColors[static_cast<int>(color)] << "m";
+}
+
+void CommandBuffer::Execute(OutputSink* output) {
+  TRACE_EVENT0("terminal", "CommandBuffer::Execute");
+  output->Write(buffer_.data(), buffer_.size());
 }
 
-void CommandBuffer::Execute() {
-  term::Put(stream_.str());
+void CommandBuffer::Clear() {
+  buffer_.clear();
 }
 
 }  // namespace zi
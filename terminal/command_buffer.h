@@ -14,9 +14,11 @@
 
 #pragma once
 
-#include <sstream>
-#include <utility>
+#include <stddef.h>
 
+#include <string>
+
+#include "terminal/output_sink.h"
 #include "terminal/term.h"
 #include "zen/string_view.h"
 #include "text/text_view.h"
@@ -24,6 +26,9 @@
 
 namespace zi {
 
+// Accumulates the bytes of a frame so that they reach the terminal in a single
+// write. Reusing a CommandBuffer with Clear() keeps its storage, so painting a
+// frame no larger than the previous ones does not allocate.
 class CommandBuffer {
  public:
   CommandBuffer();
@@ -31,21 +36,22 @@ class CommandBuffer {
 
   CommandBuffer& operator<<(const StringView& text);
   CommandBuffer& operator<<(const TextView& text);
-
-  template <typename T>
-  CommandBuffer& operator<<(const T& value) {
-    stream_ << value;
-    return *this;
-  }
+  CommandBuffer& operator<<(const std::string& text);
+  CommandBuffer& operator<<(const char* text);
+  CommandBuffer& operator<<(int value);
 
   void Write(const char* buffer, size_t length);
   void MoveCursorTo(int x, int y);
   void SetForegroundColor(term::Color color);
   void SetBackgroundColor(term::Color color);
-  void Execute();
+  void Execute(OutputSink* output);
+  void Clear();
+
+  // The number of bytes written to the buffer so far.
+  size_t size() const { return buffer_.size(); }
 
  private:
-  std::ostringstream stream_;
+  std::string buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(CommandBuffer);
 };
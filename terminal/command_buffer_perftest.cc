@@ -0,0 +1,47 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "terminal/command_buffer.h"
+
+#include <string>
+
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Builds a full frame of |arg| rows of 80 columns into a reused buffer, as
+// Editor::Display does.
+void CommandBuffer_BuildFrame(BenchmarkState* state) {
+  const std::string line(80, 'a');
+  const TextView text(StringView(line.data(), line.data() + 40),
+                      StringView(line.data() + 40, line.data() + 80));
+  size_t frame_size = 0;
+  CommandBuffer commands;
+  while (state->KeepRunning()) {
+    commands.Clear();
+    commands << term::kEraseScreen;
+    for (size_t row = 0; row < state->arg(); ++row) {
+      commands.MoveCursorTo(0, row);
+      commands << text;
+    }
+    frame_size = commands.size();
+    DoNotOptimize(frame_size);
+  }
+  state->SetBytesProcessed(state->iterations() * frame_size);
+}
+BENCHMARK(CommandBuffer_BuildFrame, 24, 100);
+
+}  // namespace
+}  // namespace zi
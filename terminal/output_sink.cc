@@ -0,0 +1,42 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "terminal/output_sink.h"
+
+#include "files/file_util.h"
+
+namespace zi {
+
+OutputSink::OutputSink() = default;
+
+OutputSink::~OutputSink() = default;
+
+bool OutputSink::failed() const {
+  return false;
+}
+
+FileOutputSink::FileOutputSink(int fd) : fd_(fd) {}
+
+FileOutputSink::~FileOutputSink() = default;
+
+void FileOutputSink::Write(const char* data, size_t length) {
+  if (!failed_ && !WriteFileDescriptor(fd_, data, length))
+    failed_ = true;
+}
+
+bool FileOutputSink::failed() const {
+  return failed_;
+}
+
+}  // namespace zi
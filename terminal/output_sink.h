@@ -0,0 +1,66 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+
+#include "zen/macros.h"
+
+namespace zi {
+
+// Where the shell sends the bytes it wants the terminal to see.
+class OutputSink {
+ public:
+  OutputSink();
+  virtual ~OutputSink();
+
+  virtual void Write(const char* data, size_t length) = 0;
+  // True once the bytes no longer reach the terminal, for example because it
+  // went away.
+  virtual bool failed() const;
+
+  template <size_t n>
+  void Put(const char (&message)[n]) {
+    Write(message, n - 1);
+  }
+
+  void Put(const std::string& message) {
+    Write(message.data(), message.size());
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(OutputSink);
+};
+
+// Writes to a file descriptor, usually STDOUT_FILENO.
+class FileOutputSink : public OutputSink {
+ public:
+  explicit FileOutputSink(int fd);
+  ~FileOutputSink() override;
+
+  void Write(const char* data, size_t length) override;
+  bool failed() const override;
+
+ private:
+  int fd_;
+  // Set by the first write that fails. Nothing is written after it.
+  bool failed_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(FileOutputSink);
+};
+
+}  // namespace zi
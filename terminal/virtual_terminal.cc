@@ -0,0 +1,365 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "terminal/virtual_terminal.h"
+
+#include <algorithm>
+
+#include "terminal/command_buffer.h"
+#include "terminal/term.h"
+
+namespace zi {
+namespace {
+
+constexpr size_t kTabWidth = 8;
+
+// The SGR parameter for each bit of VirtualTerminal::Attribute, in order.
+constexpr int kAttributeParameters[] = {1, 2, 3, 4, 5, 7, 8};
+
+void SetGraphicsRenditionFor(const VirtualTerminal::Cell& cell,
+                             CommandBuffer* commands) {
+  *commands << ESC "[0";
+  for (size_t i = 0; i < sizeof(kAttributeParameters) / sizeof(int); ++i) {
+    if (cell.attributes & (1 << i))
+      *commands << ";" << kAttributeParameters[i];
+  }
+  if (cell.foreground >= 0)
+    *commands << ";" << term::kForegroundColors[cell.foreground];
+  if (cell.background >= 0)
+    *commands << ";" << term::kBackgroundColors[cell.background];
+  *commands << "m";
+}
+
+bool HasSameRendition(const VirtualTerminal::Cell& a,
+                      const VirtualTerminal::Cell& b) {
+  return a.attributes == b.attributes && a.foreground == b.foreground &&
+         a.background == b.background;
+}
+
+}  // namespace
+
+bool VirtualTerminal::Cell::operator==(const Cell& other) const {
+  return character == other.character && HasSameRendition(*this, other);
+}
+
+VirtualTerminal::VirtualTerminal(size_t cols, size_t rows)
+    : cols_(cols),
+      rows_(rows),
+      cells_(cols * rows),
+      alternate_cells_(cols * rows) {}
+
+VirtualTerminal::~VirtualTerminal() = default;
+
+void VirtualTerminal::Write(const char* data, size_t length) {
+  bytes_written_ += length;
+  for (size_t i = 0; i < length; ++i) {
+    const char c = data[i];
+    switch (state_) {
+      case State::Ground:
+        if (c == '\x1B') {
+          state_ = State::Escape;
+        } else if (c == '\a') {
+          ++bell_count_;
+        } else if (c == '\b') {
+          cursor_col_ -= std::min<size_t>(cursor_col_, 1);
+          pending_wrap_ = false;
+        } else if (c == '\r') {
+          cursor_col_ = 0;
+          pending_wrap_ = false;
+        } else if (c == '\n') {
+          LineFeed();
+        } else if (c == '\t') {
+          cursor_col_ = std::min(cols_ - 1, (cursor_col_ / kTabWidth + 1) *
+                                                kTabWidth);
+        } else if (static_cast<unsigned char>(c) >= ' ' && c != '\x7F') {
+          Print(c);
+        }
+        break;
+      case State::Escape:
+        if (c == '[') {
+          state_ = State::ControlSequence;
+          sequence_.clear();
+        } else {
+          ExecuteEscape(c);
+          ++escape_count_;
+          state_ = State::Ground;
+        }
+        break;
+      case State::ControlSequence:
+        if (c >= '\x40' && c <= '\x7E') {
+          ExecuteControlSequence(c);
+          ++escape_count_;
+          state_ = State::Ground;
+        } else {
+          sequence_.push_back(c);
+        }
+        break;
+    }
+  }
+}
+
+void VirtualTerminal::Diff(const VirtualTerminal& target,
+                           CommandBuffer* commands) const {
+  const Cell blank;
+  Cell pen;
+  for (size_t row = 0; row < rows_; ++row) {
+    const Cell* current = GetRow(row);
+    const Cell* next = target.GetRow(row);
+    size_t first = 0;
+    while (first < cols_ && current[first] == next[first])
+      ++first;
+    if (first == cols_)
+      continue;
+    size_t length = cols_;
+    while (length > first && next[length - 1] == blank)
+      --length;
+    bool needs_erase = false;
+    for (size_t col = length; col < cols_ && !needs_erase; ++col)
+      needs_erase = current[col] != blank;
+    if (first == length && !needs_erase)
+      continue;
+    commands->MoveCursorTo(first, row);
+    for (size_t col = first; col < length; ++col) {
+      if (!HasSameRendition(pen, next[col])) {
+        pen = next[col];
+        SetGraphicsRenditionFor(pen, commands);
+      }
+      commands->Write(&next[col].character, 1);
+    }
+    if (needs_erase) {
+      if (!HasSameRendition(pen, blank)) {
+        pen = blank;
+        *commands << term::kClearCharacterAttributes;
+      }
+      *commands << term::kEraseToEndOfLine;
+    }
+  }
+  if (!HasSameRendition(pen, blank))
+    *commands << term::kClearCharacterAttributes;
+  commands->MoveCursorTo(target.cursor_col_, target.cursor_row_);
+  if (cursor_visible_ != target.cursor_visible_)
+    *commands << (target.cursor_visible_ ? term::kShowCursor
+                                         : term::kHideCursor);
+}
+
+const VirtualTerminal::Cell& VirtualTerminal::GetCell(size_t col,
+                                                      size_t row) const {
+  return GetRow(row)[col];
+}
+
+std::string VirtualTerminal::GetRowText(size_t row) const {
+  std::string text;
+  const Cell* cells = GetRow(row);
+  for (size_t col = 0; col < cols_; ++col)
+    text.push_back(cells[col].character);
+  text.erase(text.find_last_not_of(' ') + 1);
+  return text;
+}
+
+void VirtualTerminal::Print(char c) {
+  if (pending_wrap_) {
+    cursor_col_ = 0;
+    LineFeed();
+  }
+  Cell& cell = GetRow(cursor_row_)[cursor_col_];
+  cell = pen_;
+  cell.character = c;
+  if (cursor_col_ + 1 < cols_)
+    ++cursor_col_;
+  else
+    pending_wrap_ = auto_wrap_;
+}
+
+void VirtualTerminal::LineFeed() {
+  pending_wrap_ = false;
+  if (cursor_row_ + 1 < rows_) {
+    ++cursor_row_;
+    return;
+  }
+  std::copy(cells_.begin() + cols_, cells_.end(), cells_.begin());
+  Erase(0, rows_ - 1, cols_, rows_ - 1);
+}
+
+// Erases from (begin_col, begin_row) up to, but not including, end_col in
+// end_row.
+void VirtualTerminal::Erase(size_t begin_col,
+                            size_t begin_row,
+                            size_t end_col,
+                            size_t end_row) {
+  Cell blank;
+  blank.background = pen_.background;
+  auto begin = cells_.begin() + begin_row * cols_ + begin_col;
+  auto end = cells_.begin() + end_row * cols_ + end_col;
+  if (begin < end)
+    std::fill(begin, end, blank);
+}
+
+void VirtualTerminal::ExecuteEscape(char c) {
+  switch (c) {
+    case '7':
+      saved_cursor_col_ = cursor_col_;
+      saved_cursor_row_ = cursor_row_;
+      break;
+    case '8':
+      MoveCursorTo(saved_cursor_col_, saved_cursor_row_);
+      break;
+    case 'c':
+      Reset();
+      break;
+    case 'D':
+      LineFeed();
+      break;
+    case 'M':
+      if (cursor_row_ > 0) {
+        --cursor_row_;
+      } else {
+        std::copy_backward(cells_.begin(), cells_.end() - cols_, cells_.end());
+        Erase(0, 0, cols_, 0);
+      }
+      pending_wrap_ = false;
+      break;
+    default:
+      break;
+  }
+}
+
+void VirtualTerminal::ExecuteControlSequence(char c) {
+  const bool is_private = !sequence_.empty() && sequence_[0] == '?';
+  parameters_.clear();
+  parameters_.push_back(0);
+  for (size_t i = is_private ? 1 : 0; i < sequence_.size(); ++i) {
+    if (sequence_[i] >= '0' && sequence_[i] <= '9')
+      parameters_.back() = parameters_.back() * 10 + (sequence_[i] - '0');
+    else if (sequence_[i] == ';')
+      parameters_.push_back(0);
+  }
+
+  switch (c) {
+    case 'H':
+    case 'f':
+      MoveCursorTo(GetParameter(1, 1) - 1, GetParameter(0, 1) - 1);
+      break;
+    case 'A':
+      MoveCursorTo(cursor_col_,
+                   cursor_row_ - std::min<size_t>(cursor_row_,
+                                                  GetParameter(0, 1)));
+      break;
+    case 'B':
+      MoveCursorTo(cursor_col_, cursor_row_ + GetParameter(0, 1));
+      break;
+    case 'C':
+      MoveCursorTo(cursor_col_ + GetParameter(0, 1), cursor_row_);
+      break;
+    case 'D':
+      MoveCursorTo(cursor_col_ - std::min<size_t>(cursor_col_,
+                                                  GetParameter(0, 1)),
+                   cursor_row_);
+      break;
+    case 'K':
+      switch (GetParameter(0, 0)) {
+        case 0:
+          Erase(cursor_col_, cursor_row_, cols_, cursor_row_);
+          break;
+        case 1:
+          Erase(0, cursor_row_, cursor_col_ + 1, cursor_row_);
+          break;
+        case 2:
+          Erase(0, cursor_row_, cols_, cursor_row_);
+          break;
+      }
+      break;
+    case 'J':
+      switch (GetParameter(0, 0)) {
+        case 0:
+          Erase(cursor_col_, cursor_row_, cols_, rows_ - 1);
+          break;
+        case 1:
+          Erase(0, 0, cursor_col_ + 1, cursor_row_);
+          break;
+        case 2:
+          Erase(0, 0, cols_, rows_ - 1);
+          break;
+      }
+      break;
+    case 'm':
+      SetGraphicsRendition();
+      break;
+    case 'h':
+    case 'l': {
+      const bool enable = c == 'h';
+      const int mode = GetParameter(0, 0);
+      if (mode == 7) {
+        auto_wrap_ = enable;
+      } else if (is_private && mode == 25) {
+        cursor_visible_ = enable;
+      } else if (is_private && (mode == 47 || mode == 1049)) {
+        // Each screen keeps its contents while the other one is shown.
+        if (enable != alternate_screen_) {
+          cells_.swap(alternate_cells_);
+          alternate_screen_ = enable;
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void VirtualTerminal::SetGraphicsRendition() {
+  for (int parameter : parameters_) {
+    if (parameter == 0) {
+      pen_ = Cell();
+    } else if (parameter >= 30 && parameter <= 37) {
+      pen_.foreground = parameter - 30;
+    } else if (parameter == 39) {
+      pen_.foreground = -1;
+    } else if (parameter >= 40 && parameter <= 47) {
+      pen_.background = parameter - 40;
+    } else if (parameter == 49) {
+      pen_.background = -1;
+    } else if (parameter == 22) {
+      pen_.attributes &= ~(kBold | kLowIntensity);
+    } else {
+      for (size_t i = 0; i < sizeof(kAttributeParameters) / sizeof(int); ++i) {
+        if (parameter == kAttributeParameters[i])
+          pen_.attributes |= 1 << i;
+        else if (parameter == kAttributeParameters[i] + 20)
+          pen_.attributes &= ~(1 << i);
+      }
+    }
+  }
+}
+
+int VirtualTerminal::GetParameter(size_t index, int default_value) const {
+  if (index < parameters_.size() && parameters_[index] > 0)
+    return parameters_[index];
+  return default_value;
+}
+
+void VirtualTerminal::MoveCursorTo(size_t col, size_t row) {
+  cursor_col_ = std::min(col, cols_ - 1);
+  cursor_row_ = std::min(row, rows_ - 1);
+  pending_wrap_ = false;
+}
+
+void VirtualTerminal::Reset() {
+  std::fill(cells_.begin(), cells_.end(), Cell());
+  MoveCursorTo(0, 0);
+  pen_ = Cell();
+  cursor_visible_ = true;
+  auto_wrap_ = true;
+}
+
+}  // namespace zi
@@ -0,0 +1,126 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "terminal/output_sink.h"
+#include "zen/macros.h"
+
+namespace zi {
+class CommandBuffer;
+
+// An in-process terminal that applies the escape sequences zi emits to a grid
+// of cells. It lets tests check what is on the screen and lets benchmarks
+// measure how much output a frame takes, all without a TTY.
+class VirtualTerminal : public OutputSink {
+ public:
+  enum Attribute : uint8_t {
+    kBold = 1 << 0,
+    kLowIntensity = 1 << 1,
+    kStandout = 1 << 2,
+    kUnderline = 1 << 3,
+    kBlink = 1 << 4,
+    kReverseVideo = 1 << 5,
+    kInvisible = 1 << 6,
+  };
+
+  struct Cell {
+    char character = ' ';
+    uint8_t attributes = 0;
+    // -1 for the default color, otherwise a term::Color.
+    int8_t foreground = -1;
+    int8_t background = -1;
+
+    bool operator==(const Cell& other) const;
+    bool operator!=(const Cell& other) const { return !(*this == other); }
+  };
+
+  VirtualTerminal(size_t cols, size_t rows);
+  ~VirtualTerminal() override;
+
+  void Write(const char* data, size_t length) override;
+
+  // Appends the output that turns this screen into |target|, which must have
+  // the same size. Only rows that differ are repainted.
+  void Diff(const VirtualTerminal& target, CommandBuffer* commands) const;
+
+  const Cell& GetCell(size_t col, size_t row) const;
+  // The characters in |row| without trailing spaces.
+  std::string GetRowText(size_t row) const;
+
+  size_t cols() const { return cols_; }
+  size_t rows() const { return rows_; }
+  size_t cursor_col() const { return cursor_col_; }
+  size_t cursor_row() const { return cursor_row_; }
+  bool cursor_visible() const { return cursor_visible_; }
+
+  size_t bytes_written() const { return bytes_written_; }
+  size_t escape_count() const { return escape_count_; }
+  size_t bell_count() const { return bell_count_; }
+
+ private:
+  enum class State {
+    Ground,
+    Escape,
+    ControlSequence,
+  };
+
+  Cell* GetRow(size_t row) { return &cells_[row * cols_]; }
+  const Cell* GetRow(size_t row) const { return &cells_[row * cols_]; }
+
+  void Print(char c);
+  void LineFeed();
+  void Erase(size_t begin_col, size_t begin_row, size_t end_col,
+             size_t end_row);
+  void ExecuteEscape(char c);
+  void ExecuteControlSequence(char c);
+  void SetGraphicsRendition();
+  int GetParameter(size_t index, int default_value) const;
+  void MoveCursorTo(size_t col, size_t row);
+  void Reset();
+
+  const size_t cols_;
+  const size_t rows_;
+  std::vector<Cell> cells_;
+  std::vector<Cell> alternate_cells_;
+
+  size_t cursor_col_ = 0;
+  size_t cursor_row_ = 0;
+  size_t saved_cursor_col_ = 0;
+  size_t saved_cursor_row_ = 0;
+  bool cursor_visible_ = true;
+  // Set after printing in the last column. The next character wraps.
+  bool pending_wrap_ = false;
+  bool auto_wrap_ = true;
+  bool alternate_screen_ = false;
+  Cell pen_;
+
+  State state_ = State::Ground;
+  std::string sequence_;
+  std::vector<int> parameters_;
+
+  size_t bytes_written_ = 0;
+  size_t escape_count_ = 0;
+  size_t bell_count_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(VirtualTerminal);
+};
+
+}  // namespace zi
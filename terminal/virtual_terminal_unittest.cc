@@ -0,0 +1,118 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "terminal/virtual_terminal.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "terminal/command_buffer.h"
+#include "terminal/term.h"
+
+namespace zi {
+namespace {
+
+TEST(VirtualTerminal, Control) {
+  VirtualTerminal terminal(10, 3);
+  EXPECT_EQ("", terminal.GetRowText(0));
+  terminal.Put("Hello");
+  EXPECT_EQ("Hello", terminal.GetRowText(0));
+  EXPECT_EQ(5u, terminal.cursor_col());
+  EXPECT_EQ(0u, terminal.cursor_row());
+  terminal.Put(ESC "[2;3Hworld");
+  EXPECT_EQ("  world", terminal.GetRowText(1));
+  EXPECT_EQ(7u, terminal.cursor_col());
+  EXPECT_EQ(1u, terminal.cursor_row());
+  terminal.Put(ESC "[1;3H" ESC "[K");
+  EXPECT_EQ("He", terminal.GetRowText(0));
+  terminal.Put(term::kEraseScreen);
+  EXPECT_EQ("", terminal.GetRowText(1));
+  EXPECT_EQ(16u + 9u + 4u, terminal.bytes_written());
+  EXPECT_EQ(4u, terminal.escape_count());
+}
+
+TEST(VirtualTerminal, WrapAndScroll) {
+  VirtualTerminal terminal(4, 2);
+  terminal.Put("abcd");
+  EXPECT_EQ(3u, terminal.cursor_col());
+  EXPECT_EQ(0u, terminal.cursor_row());
+  terminal.Put("efghij");
+  EXPECT_EQ("efgh", terminal.GetRowText(0));
+  EXPECT_EQ("ij", terminal.GetRowText(1));
+  terminal.Put("\r\nk");
+  EXPECT_EQ("ij", terminal.GetRowText(0));
+  EXPECT_EQ("k", terminal.GetRowText(1));
+}
+
+TEST(VirtualTerminal, SplitSequences) {
+  VirtualTerminal terminal(10, 3);
+  terminal.Put(ESC "[");
+  terminal.Put("3;");
+  terminal.Put("4");
+  terminal.Put("Hx");
+  EXPECT_EQ("   x", terminal.GetRowText(2));
+  EXPECT_EQ(1u, terminal.escape_count());
+}
+
+TEST(VirtualTerminal, Attributes) {
+  VirtualTerminal terminal(10, 3);
+  terminal.Put(term::kSetLowIntensity);
+  terminal.Put("~");
+  terminal.Put(term::kClearCharacterAttributes);
+  terminal.Put(ESC "[31mr");
+  EXPECT_EQ(VirtualTerminal::kLowIntensity, terminal.GetCell(0, 0).attributes);
+  EXPECT_EQ(0, terminal.GetCell(1, 0).attributes);
+  EXPECT_EQ(1, terminal.GetCell(1, 0).foreground);
+  terminal.Put(term::kBell);
+  EXPECT_EQ(1u, terminal.bell_count());
+  terminal.Put(term::kHideCursor);
+  EXPECT_FALSE(terminal.cursor_visible());
+}
+
+TEST(VirtualTerminal, AlternateScreen) {
+  VirtualTerminal terminal(10, 3);
+  terminal.Put("shell");
+  terminal.Put(term::kSaveScreen);
+  EXPECT_EQ("", terminal.GetRowText(0));
+  terminal.Put(term::kMoveCursorHome);
+  terminal.Put("zi");
+  terminal.Put(term::kRestoreScreen);
+  EXPECT_EQ("shell", terminal.GetRowText(0));
+}
+
+TEST(VirtualTerminal, Diff) {
+  VirtualTerminal painted(10, 3);
+  VirtualTerminal target(10, 3);
+  painted.Put("one\r\ntwo\r\nthree");
+  target.Put("one\r\ntwice\r\n" ESC "[2mthr");
+
+  CommandBuffer commands;
+  painted.Diff(target, &commands);
+  commands.Execute(&painted);
+  for (size_t row = 0; row < 3; ++row) {
+    EXPECT_EQ(target.GetRowText(row), painted.GetRowText(row));
+    for (size_t col = 0; col < 10; ++col)
+      EXPECT_EQ(target.GetCell(col, row), painted.GetCell(col, row));
+  }
+  EXPECT_EQ(target.cursor_col(), painted.cursor_col());
+  EXPECT_EQ(target.cursor_row(), painted.cursor_row());
+
+  // Nothing but the cursor position needs to be sent for identical screens.
+  CommandBuffer empty;
+  painted.Diff(target, &empty);
+  EXPECT_EQ(std::string(ESC "[3;4H").size(), empty.size());
+}
+
+}  // namespace
+}  // namespace zi
@@ -0,0 +1,258 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/char_class.h"
+
+#if defined(__x86_64__)
+#include <tmmintrin.h>
+#endif
+
+#include <algorithm>
+
+namespace zi {
+namespace {
+
+constexpr uint8_t ClassifyByte(unsigned c) {
+  return c == ' ' || c == '\t'
+             ? kBlank
+             : c == '\n' ? kLineBreak
+                         : (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') ||
+                                   (c >= 'a' && c <= 'z') || c == '_' ||
+                                   c >= 0x80
+                               ? kWord
+                               : kPunctuation;
+}
+
+// The vector scan classifies 16 bytes at once by looking up each byte's low
+// and high nibble in a 16-entry table and and-ing the two. Each bit of the
+// result covers a rectangle of the byte table:
+//
+//   0x01: '\t'                  low 9,      high 0
+//   0x02: ' '                   low 0,      high 2
+//   0x04: '\n'                  low A,      high 0
+//   0x08: "1-9A-IQ-Ya-iq-y"     low 1-9,    high 3-F
+//   0x10: "0Pp"                 low 0,      high 3, 5, 7-F
+//   0x20: "J-Oj-o"              low A-F,    high 4, 6, 8-F
+//   0x40: "Zz"                  low A,      high 5, 7
+//   0x80: "_"                   low F,      high 5
+//
+// and every byte from 0x80 up is covered by 0x08, 0x10 or 0x20. Punctuation
+// is what no bit covers.
+constexpr uint8_t kLowNibbleBits[16] = {
+    0x12, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08,
+    0x08, 0x09, 0x64, 0x20, 0x20, 0x20, 0x20, 0xA0,
+};
+constexpr uint8_t kHighNibbleBits[16] = {
+    0x05, 0x00, 0x02, 0x18, 0x28, 0xD8, 0x28, 0x58,
+    0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38,
+};
+constexpr uint8_t kBlankBits = 0x03;
+constexpr uint8_t kLineBreakBits = 0x04;
+constexpr uint8_t kWordBits = 0xF8;
+
+constexpr uint8_t ClassifyNibbles(unsigned c) {
+  return (kLowNibbleBits[c & 0xF] & kHighNibbleBits[c >> 4]) & kBlankBits
+             ? kBlank
+             : (kLowNibbleBits[c & 0xF] & kHighNibbleBits[c >> 4]) &
+                       kLineBreakBits
+                   ? kLineBreak
+                   : (kLowNibbleBits[c & 0xF] & kHighNibbleBits[c >> 4]) &
+                             kWordBits
+                         ? kWord
+                         : kPunctuation;
+}
+
+constexpr bool NibblesMatchFrom(unsigned c) {
+  return c == 256 ||
+         (ClassifyNibbles(c) == ClassifyByte(c) && NibblesMatchFrom(c + 1));
+}
+static_assert(NibblesMatchFrom(0),
+              "The nibble tables disagree with ClassifyByte");
+
+// Returns the bits of the nibble lookup that stand for |classes|, other than
+// punctuation.
+constexpr uint8_t GetNibbleBits(uint8_t classes) {
+  return (classes & kBlank ? kBlankBits : 0) |
+         (classes & kLineBreak ? kLineBreakBits : 0) |
+         (classes & kWord ? kWordBits : 0);
+}
+
+constexpr size_t kBytesBeforeVectors = 16;
+
+// Returns the first offset in [pos, end) whose byte's class is not one of
+// |classes|, or |end|.
+size_t SkipForwardBytes(const char* data,
+                        size_t pos,
+                        size_t end,
+                        uint8_t classes) {
+  while (pos < end && (GetCharClass(data[pos]) & classes))
+    ++pos;
+  return pos;
+}
+
+size_t SkipBackwardBytes(const char* data,
+                         size_t begin,
+                         size_t end,
+                         uint8_t classes) {
+  while (end > begin && (GetCharClass(data[end - 1]) & classes))
+    --end;
+  return end;
+}
+
+#if defined(__x86_64__)
+
+bool HasSsse3() {
+  static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+  return has_ssse3;
+}
+
+// Returns a mask with a bit set for each of the 16 bytes at |data| whose class
+// is not one of |classes|.
+__attribute__((target("ssse3"))) inline unsigned FindOtherClasses(
+    const char* data,
+    __m128i low_table,
+    __m128i high_table,
+    __m128i wanted_bits,
+    bool wants_punctuation) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  const __m128i bytes =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  const __m128i low = _mm_and_si128(bytes, nibble);
+  const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+  const __m128i bits = _mm_and_si128(_mm_shuffle_epi8(low_table, low),
+                                     _mm_shuffle_epi8(high_table, high));
+  const __m128i zero = _mm_setzero_si128();
+  unsigned others = _mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_and_si128(bits, wanted_bits), zero));
+  if (wants_punctuation)
+    others &= ~_mm_movemask_epi8(_mm_cmpeq_epi8(bits, zero));
+  return others;
+}
+
+__attribute__((target("ssse3"))) size_t SkipForwardVectors(const char* data,
+                                                           size_t pos,
+                                                           size_t end,
+                                                           uint8_t classes) {
+  const __m128i low_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(kLowNibbleBits));
+  const __m128i high_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(kHighNibbleBits));
+  const __m128i wanted_bits = _mm_set1_epi8(GetNibbleBits(classes));
+  const bool wants_punctuation = classes & kPunctuation;
+  for (; pos + 16 <= end; pos += 16) {
+    const unsigned others = FindOtherClasses(data + pos, low_table, high_table,
+                                             wanted_bits, wants_punctuation);
+    if (others)
+      return pos + __builtin_ctz(others);
+  }
+  return SkipForwardBytes(data, pos, end, classes);
+}
+
+__attribute__((target("ssse3"))) size_t SkipBackwardVectors(const char* data,
+                                                            size_t begin,
+                                                            size_t end,
+                                                            uint8_t classes) {
+  const __m128i low_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(kLowNibbleBits));
+  const __m128i high_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(kHighNibbleBits));
+  const __m128i wanted_bits = _mm_set1_epi8(GetNibbleBits(classes));
+  const bool wants_punctuation = classes & kPunctuation;
+  for (; end >= begin + 16; end -= 16) {
+    const unsigned others =
+        FindOtherClasses(data + end - 16, low_table, high_table, wanted_bits,
+                         wants_punctuation);
+    if (others)
+      return end - 16 + (32 - __builtin_clz(others));
+  }
+  return SkipBackwardBytes(data, begin, end, classes);
+}
+
+#endif  // defined(__x86_64__)
+
+size_t SkipForward(const char* data, size_t pos, size_t end, uint8_t classes) {
+  // Most runs are short, so look at a few bytes before setting up vectors.
+  const size_t bytes_end = std::min(end, pos + kBytesBeforeVectors);
+  pos = SkipForwardBytes(data, pos, bytes_end, classes);
+  if (pos < bytes_end || pos == end)
+    return pos;
+#if defined(__x86_64__)
+  if (HasSsse3())
+    return SkipForwardVectors(data, pos, end, classes);
+#endif
+  return SkipForwardBytes(data, pos, end, classes);
+}
+
+size_t SkipBackward(const char* data,
+                    size_t begin,
+                    size_t end,
+                    uint8_t classes) {
+  const size_t bytes_begin =
+      end - std::min(end - begin, kBytesBeforeVectors);
+  end = SkipBackwardBytes(data, bytes_begin, end, classes);
+  if (end > bytes_begin || end == begin)
+    return end;
+#if defined(__x86_64__)
+  if (HasSsse3())
+    return SkipBackwardVectors(data, begin, end, classes);
+#endif
+  return SkipBackwardBytes(data, begin, end, classes);
+}
+
+}  // namespace
+
+#define CLASSIFY_ROW(row)                                                    \
+  ClassifyByte(row * 16 + 0), ClassifyByte(row * 16 + 1),                    \
+      ClassifyByte(row * 16 + 2), ClassifyByte(row * 16 + 3),                \
+      ClassifyByte(row * 16 + 4), ClassifyByte(row * 16 + 5),                \
+      ClassifyByte(row * 16 + 6), ClassifyByte(row * 16 + 7),                \
+      ClassifyByte(row * 16 + 8), ClassifyByte(row * 16 + 9),                \
+      ClassifyByte(row * 16 + 10), ClassifyByte(row * 16 + 11),              \
+      ClassifyByte(row * 16 + 12), ClassifyByte(row * 16 + 13),              \
+      ClassifyByte(row * 16 + 14), ClassifyByte(row * 16 + 15)
+
+constexpr uint8_t kCharClasses[256] = {
+    CLASSIFY_ROW(0),  CLASSIFY_ROW(1),  CLASSIFY_ROW(2),  CLASSIFY_ROW(3),
+    CLASSIFY_ROW(4),  CLASSIFY_ROW(5),  CLASSIFY_ROW(6),  CLASSIFY_ROW(7),
+    CLASSIFY_ROW(8),  CLASSIFY_ROW(9),  CLASSIFY_ROW(10), CLASSIFY_ROW(11),
+    CLASSIFY_ROW(12), CLASSIFY_ROW(13), CLASSIFY_ROW(14), CLASSIFY_ROW(15),
+};
+
+#undef CLASSIFY_ROW
+
+size_t SkipClasses(const TextView& text, size_t pos, uint8_t classes) {
+  const StringView& left = text.left();
+  if (pos < left.length()) {
+    pos = SkipForward(left.data(), pos, left.length(), classes);
+    if (pos < left.length())
+      return pos;
+  }
+  const StringView& right = text.right();
+  return left.length() + SkipForward(right.data(), pos - left.length(),
+                                     right.length(), classes);
+}
+
+size_t SkipClassesBackward(const TextView& text, size_t end, uint8_t classes) {
+  const StringView& left = text.left();
+  if (end > left.length()) {
+    const size_t begin = SkipBackward(text.right().data(), 0,
+                                      end - left.length(), classes);
+    if (begin > 0)
+      return left.length() + begin;
+    end = left.length();
+  }
+  return SkipBackward(left.data(), 0, end, classes);
+}
+
+}  // namespace zi
@@ -0,0 +1,49 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "text/text_view.h"
+
+namespace zi {
+
+// The classes of bytes that word and paragraph motions tell apart. Each is a
+// bit, so that a scan can skip several classes at once.
+enum CharClass : uint8_t {
+  kBlank = 1 << 0,
+  kLineBreak = 1 << 1,
+  kPunctuation = 1 << 2,
+  // Letters, digits, '_' and the bytes of non-ASCII characters.
+  kWord = 1 << 3,
+};
+
+extern const uint8_t kCharClasses[256];
+
+inline CharClass GetCharClass(char c) {
+  return static_cast<CharClass>(kCharClasses[static_cast<unsigned char>(c)]);
+}
+
+// Returns the offset of the first byte at or after |pos| whose class is not
+// one of |classes|, or the length of |text| if there is none. Scans 16 bytes at
+// a time where the processor allows.
+size_t SkipClasses(const TextView& text, size_t pos, uint8_t classes);
+
+// Returns the offset just past the last byte before |end| whose class is not
+// one of |classes|, or zero if there is none.
+size_t SkipClassesBackward(const TextView& text, size_t end, uint8_t classes);
+
+}  // namespace zi
@@ -0,0 +1,79 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/char_class.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+TEST(CharClass, GetCharClass) {
+  EXPECT_EQ(kBlank, GetCharClass(' '));
+  EXPECT_EQ(kBlank, GetCharClass('\t'));
+  EXPECT_EQ(kLineBreak, GetCharClass('\n'));
+  EXPECT_EQ(kWord, GetCharClass('_'));
+  EXPECT_EQ(kWord, GetCharClass('Z'));
+  EXPECT_EQ(kWord, GetCharClass('\xc3'));
+  EXPECT_EQ(kPunctuation, GetCharClass('{'));
+  EXPECT_EQ(kPunctuation, GetCharClass('\0'));
+  EXPECT_EQ(kPunctuation, GetCharClass('\x7f'));
+}
+
+// Puts each byte in the middle of a run long enough for the vector scan, so
+// the scan has to classify it the way the table does.
+TEST(CharClass, EveryByte) {
+  for (int i = 0; i < 256; ++i) {
+    const char c = static_cast<char>(i);
+    const uint8_t others = ~GetCharClass(c);
+    const char filler = GetCharClass(c) == kPunctuation ? 'a' : '.';
+    const std::string text = std::string(20, c) + filler + std::string(20, c);
+    EXPECT_EQ(20u, SkipClasses(TextView(text), 0, GetCharClass(c))) << i;
+    EXPECT_EQ(0u, SkipClasses(TextView(text), 0, others)) << i;
+    EXPECT_EQ(21u, SkipClassesBackward(TextView(text), text.size(),
+                                       GetCharClass(c)))
+        << i;
+  }
+}
+
+TEST(CharClass, SkipClasses) {
+  const std::string text = "foo_bar(baz,  qux)\n\n";
+  EXPECT_EQ(7u, SkipClasses(TextView(text), 0, kWord));
+  EXPECT_EQ(7u, SkipClasses(TextView(text), 7, kBlank));
+  EXPECT_EQ(18u,
+            SkipClasses(TextView(text), 0, kWord | kPunctuation | kBlank));
+  EXPECT_EQ(text.size(), SkipClasses(TextView(text), 18, kLineBreak));
+  EXPECT_EQ(text.size(), SkipClasses(TextView(text), text.size(), kWord));
+
+  EXPECT_EQ(14u, SkipClassesBackward(TextView(text), 17, kWord));
+  EXPECT_EQ(0u, SkipClassesBackward(TextView(text), 7, kWord));
+  EXPECT_EQ(0u, SkipClassesBackward(TextView(text), 0, kWord));
+}
+
+TEST(CharClass, AcrossTheGap) {
+  const std::string left = "aaaaaaaaaaaaaaaaaaaa";
+  const std::string right = "aaaaaaaaaaaaaaaaaaaa b";
+  const TextView text{StringView(left), StringView(right)};
+  EXPECT_EQ(40u, SkipClasses(text, 3, kWord));
+  EXPECT_EQ(22u, SkipClasses(text, 22, kBlank));
+  EXPECT_EQ(0u, SkipClassesBackward(text, 40, kWord));
+  EXPECT_EQ(41u, SkipClassesBackward(text, 41, kWord));
+  const TextView swapped{StringView(right), StringView(left)};
+  EXPECT_EQ(21u, SkipClassesBackward(swapped, 42, kWord));
+}
+
+}  // namespace
+}  // namespace zi
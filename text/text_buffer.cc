@@ -19,33 +19,57 @@
 #include <algorithm>
 #include <utility>
 
+#include "zen/trace_event.h"
+
 #ifndef NDEBUG
 #include <iostream>
 #endif
 
 namespace zi {
 
-TextBuffer::TextBuffer() = default;
+TextBuffer::TextBuffer() : storage_(new TextStorage()) {}
 
-TextBuffer::TextBuffer(std::vector<char> text) : buffer_(std::move(text)) {}
+TextBuffer::TextBuffer(std::vector<char> text) : storage_(new TextStorage()) {
+  storage_->bytes = std::move(text);
+}
+
+TextBuffer::TextBuffer(std::vector<char> buffer, size_t gap_size)
+    : gap_end_(std::min(gap_size, buffer.size())),
+      storage_(new TextStorage()) {
+  storage_->bytes = std::move(buffer);
+}
 
 TextBuffer::~TextBuffer() = default;
 
 void TextBuffer::InsertCharacter(const TextPosition& position, char c) {
+  if (edit_depth_) {
+    QueueEdit(position.offset(), position.offset(), StringView(&c, &c + 1));
+    return;
+  }
+  if (!observers_.empty())
+    NotifyWillReplace(position.offset(), TextView(), StringView(&c, &c + 1));
   if (gap_start_ == gap_end_)
     Expand(1);
   MoveInsertionPointTo(position.offset());
-  buffer_[gap_start_++] = c;
+  EnsureWritable(gap_start_, gap_start_ + 1);
+  buffer()[gap_start_++] = c;
   // TODO(abarth): Consider the affinity when adjusting the TextBufferRanges.
   DidInsert(1);
 }
 
 void TextBuffer::InsertText(const TextPosition& position, StringView text) {
+  if (edit_depth_) {
+    QueueEdit(position.offset(), position.offset(), text);
+    return;
+  }
+  if (!observers_.empty())
+    NotifyWillReplace(position.offset(), TextView(), text);
   const size_t length = text.length();
   if (gap_start_ + length > gap_end_)
     Expand(length);
   MoveInsertionPointTo(position.offset());
-  memcpy(&buffer_[gap_start_], text.data(), length);
+  EnsureWritable(gap_start_, gap_start_ + length);
+  memcpy(&buffer()[gap_start_], text.data(), length);
   gap_start_ += length;
   // TODO(abarth): Consider the affinity when adjusting the TextBufferRanges.
   DidInsert(length);
@@ -56,37 +80,85 @@ void TextBuffer::InsertText(const TextPosition& position,
   InsertText(position, StringView(text));
 }
 
+void TextBuffer::Append(StringView text) {
+  // Ranges end at or before the end of the text, so none of them move.
+  // Snapshots end there too, unless appending reallocates the buffer.
+  const size_t end = buffer().size() + text.length();
+  if (end > buffer().capacity() && IsShared())
+    Unshare(end);
+  buffer().insert(buffer().end(), text.begin(), text.end());
+}
+
 void TextBuffer::DeleteCharacterAfter(size_t position) {
   DeleteRange(TextBufferRange(position, position + 1));
 }
 
 void TextBuffer::DeleteRange(const TextBufferRange& range) {
+  if (edit_depth_) {
+    if (range.start() < range.end())
+      QueueEdit(range.start(), range.end(), StringView());
+    return;
+  }
   const size_t size = this->size();
   const size_t begin = std::min(range.start(), size);
   const size_t end = std::min(range.end(), size);
   if (begin == end)
     return;
   const size_t count = end - begin;
+  if (!observers_.empty()) {
+    TextBufferRange deleted(begin, end);
+    NotifyWillReplace(begin, GetTextForRange(&deleted), StringView());
+  }
   MoveInsertionPointTo(end);
   gap_start_ -= count;
   DidDelete(count);
   DidMoveInsertionPointBackward();
 }
 
+void TextBuffer::ReplaceRange(const TextBufferRange& range, StringView text) {
+  BeginEdit();
+  QueueEdit(range.start(), std::max(range.start(), range.end()), text);
+  Commit();
+}
+
+void TextBuffer::BeginEdit() {
+  ++edit_depth_;
+}
+
+void TextBuffer::Commit() {
+  if (--edit_depth_ > 0)
+    return;
+  if (!queued_edits_.empty())
+    ApplyQueuedEdits();
+  // Keep the storage for the next transaction.
+  queued_edits_.clear();
+  edit_text_.clear();
+}
+
 void TextBuffer::MoveInsertionPointForward(size_t offset) {
-  size_t delta = std::min(offset, buffer_.size() - gap_end_);
-  memmove(&buffer_[gap_start_], &buffer_[gap_end_], delta);
-  gap_start_ += delta;
-  gap_end_ += delta;
+  MoveGapForward(offset);
   DidMoveInsertionPointForward();
 }
 
 void TextBuffer::MoveInsertionPointBackward(size_t offset) {
+  MoveGapBackward(offset);
+  DidMoveInsertionPointBackward();
+}
+
+void TextBuffer::MoveGapForward(size_t offset) {
+  size_t delta = std::min(offset, buffer().size() - gap_end_);
+  EnsureWritable(gap_start_, gap_start_ + delta);
+  memmove(&buffer()[gap_start_], &buffer()[gap_end_], delta);
+  gap_start_ += delta;
+  gap_end_ += delta;
+}
+
+void TextBuffer::MoveGapBackward(size_t offset) {
   size_t delta = std::min(offset, gap_start_);
+  EnsureWritable(gap_end_ - delta, gap_end_);
   gap_start_ -= delta;
   gap_end_ -= delta;
-  memmove(&buffer_[gap_end_], &buffer_[gap_start_], delta);
-  DidMoveInsertionPointBackward();
+  memmove(&buffer()[gap_end_], &buffer()[gap_start_], delta);
 }
 
 void TextBuffer::MoveInsertionPointTo(size_t position) {
@@ -98,15 +170,15 @@ void TextBuffer::MoveInsertionPointTo(size_t position) {
 
 size_t TextBuffer::Find(char c, size_t pos) {
   if (pos < gap_start_) {
-    char* ptr = static_cast<char*>(memchr(&buffer_[pos], c, gap_start_ - pos));
+    char* ptr = static_cast<char*>(memchr(&buffer()[pos], c, gap_start_ - pos));
     if (ptr)
       return ptr - data();
     pos = gap_start_;
   }
   pos += gap_size();
-  if (pos < buffer_.size()) {
+  if (pos < buffer().size()) {
     char* ptr =
-        static_cast<char*>(memchr(&buffer_[pos], c, buffer_.size() - pos));
+        static_cast<char*>(memchr(&buffer()[pos], c, buffer().size() - pos));
     if (ptr)
       return ptr - data() - gap_size();
   }
@@ -132,45 +204,71 @@ std::string TextBuffer::ToString() const {
   result.resize(size());
   if (gap_start_ > 0)
     result.replace(0, gap_start_, data(), gap_start_);
-  if (gap_end_ < buffer_.size()) {
+  if (gap_end_ < buffer().size()) {
     const size_t tail_size = this->tail_size();
-    result.replace(gap_start_, tail_size, &buffer_[gap_end_], tail_size);
+    result.replace(gap_start_, tail_size, &buffer()[gap_end_], tail_size);
   }
   return result;
 }
 
 TextView TextBuffer::GetText() const {
-  const char* data = buffer_.data();
+  const char* data = buffer().data();
   return TextView(StringView(data, data + gap_start_),
-                  StringView(data + gap_end_, data + buffer_.size()));
+                  StringView(data + gap_end_, data + buffer().size()));
+}
+
+TextSnapshot TextBuffer::Snapshot() {
+  if (!IsShared()) {
+    writable_begin_ = 0;
+    writable_end_ = std::string::npos;
+  }
+  writable_begin_ = std::max(writable_begin_, gap_start_);
+  writable_end_ = std::min(writable_end_, gap_end_);
+  return TextSnapshot(storage_, GetText());
 }
 
 TextView TextBuffer::GetTextForRange(TextBufferRange* range) const {
   if (range->end() <= gap_start_) {
-    const char* begin = &buffer_[range->start()];
+    const char* begin = &buffer()[range->start()];
     return TextView(StringView(begin, begin + range->length()));
   } else if (range->start() >= gap_start_) {
-    const char* begin = &buffer_[range->start() + gap_size()];
+    const char* begin = &buffer()[range->start() + gap_size()];
     // TODO(abarth): Should we handle the case where the range extends beyond
     // the
     // buffer?
     return TextView(StringView(begin, begin + range->length()));
   } else {
     // The range crosses the gap.
-    const char* first_begin = &buffer_[range->start()];
-    const char* first_end = &buffer_[gap_start_];
+    const char* first_begin = &buffer()[range->start()];
+    const char* first_end = &buffer()[gap_start_];
     const size_t first_length = first_end - first_begin;
-    const char* second_begin = &buffer_[gap_end_];
+    const char* second_begin = &buffer()[gap_end_];
     const char* second_end = second_begin + (range->length() - first_length);
     return TextView(StringView(first_begin, first_end),
                     StringView(second_begin, second_end));
   }
 }
 
+void TextBuffer::AddObserver(TextBufferObserver* observer) {
+  observers_.push_back(observer);
+}
+
+void TextBuffer::RemoveObserver(TextBufferObserver* observer) {
+  observers_.erase(std::remove(observers_.begin(), observers_.end(), observer),
+                   observers_.end());
+}
+
+void TextBuffer::NotifyWillReplace(size_t offset,
+                                   const TextView& deleted,
+                                   const StringView& inserted) {
+  for (TextBufferObserver* observer : observers_)
+    observer->WillReplace(offset, deleted, inserted);
+}
+
 char TextBuffer::At(size_t offset) {
   if (offset >= gap_start_)
     offset += gap_size();
-  return buffer_[offset];
+  return buffer()[offset];
 }
 
 void TextBuffer::AddRange(TextBufferRange* range) {
@@ -183,7 +281,7 @@ void TextBuffer::AddRange(TextBufferRange* range) {
 }
 
 void TextBuffer::RemoveRange(TextBufferRange* range) {
-  RemoveRanges(&range, &range);
+  RemoveRanges(&range, &range + 1);
 }
 
 #ifndef NDEBUG
@@ -198,7 +296,7 @@ static void DebugDumpTextBufferRangeVector(
 
 void TextBuffer::DebugDumpRanges() {
   std::cout << "gap_begin=" << gap_start_ << " gap_end=" << gap_end_
-            << " size=" << buffer_.size() << std::endl;
+            << " size=" << buffer().size() << std::endl;
   std::cout << "== Before gap ==" << std::endl;
   DebugDumpTextBufferRangeVector(before_gap_.debug_container());
   std::cout << "== Across gap ==" << std::endl;
@@ -213,19 +311,59 @@ void TextBuffer::Expand(size_t required_gap_size) {
   size_t existing_gap = gap_size();
   if (existing_gap >= required_gap_size)
     return;
-  size_t min_size = buffer_.size() - existing_gap + required_gap_size;
-  std::vector<char> new_buffer(min_size * 1.5 + 1);
+  size_t min_size = buffer().size() - existing_gap + required_gap_size;
+  std::vector<char> new_buffer;
+  // Keep any capacity that was reserved for appending.
+  const size_t reserved = buffer().capacity() - buffer().size();
+  new_buffer.reserve(min_size * 1.5 + 1 + reserved);
+  new_buffer.resize(min_size * 1.5 + 1);
   if (gap_start_ > 0)
     memcpy(&new_buffer[0], data(), gap_start_);
-  if (gap_end_ < buffer_.size()) {
+  if (gap_end_ < buffer().size()) {
     const size_t tail_size = this->tail_size();
     memcpy(&new_buffer[new_buffer.size() - tail_size],
-           &buffer_[buffer_.size() - tail_size], tail_size);
+           &buffer()[buffer().size() - tail_size], tail_size);
+  }
+  gap_end_ += new_buffer.size() - buffer().size();
+  // The snapshots keep the old buffer.
+  if (IsShared()) {
+    storage_.reset(new TextStorage());
+    writable_begin_ = 0;
+    writable_end_ = std::string::npos;
+  }
+  buffer().swap(new_buffer);
+}
+
+// The acquire pairs with the release in ~TextSnapshot.
+bool TextBuffer::IsShared() const {
+  return storage_->snapshot_count.load(std::memory_order_acquire) != 0;
+}
+
+void TextBuffer::EnsureWritable(size_t begin, size_t end) {
+  if ((begin >= writable_begin_ && end <= writable_end_) ||
+      begin >= buffer().size())
+    return;
+  if (IsShared()) {
+    Unshare(buffer().capacity());
+    return;
   }
-  gap_end_ += new_buffer.size() - buffer_.size();
-  buffer_.swap(new_buffer);
+  writable_begin_ = 0;
+  writable_end_ = std::string::npos;
+}
+
+// Copies the bytes into storage of our own with room for |capacity| bytes and
+// leaves the old storage to the snapshots.
+void TextBuffer::Unshare(size_t capacity) {
+  TRACE_EVENT0("text", "TextBuffer::Unshare");
+  std::shared_ptr<TextStorage> shared = std::move(storage_);
+  storage_.reset(new TextStorage());
+  storage_->bytes.reserve(std::max(capacity, shared->bytes.size()));
+  storage_->bytes.assign(shared->bytes.begin(), shared->bytes.end());
+  writable_begin_ = 0;
+  writable_end_ = std::string::npos;
 }
 
+
 void TextBuffer::DidInsert(size_t count) {
   for (auto& range : across_gap_)
     range->PushBack(count);
@@ -233,45 +371,249 @@ void TextBuffer::DidInsert(size_t count) {
 }
 
 void TextBuffer::DidDelete(size_t count) {
-  std::vector<TextBufferRange*> displaced;
+  displaced_.clear();
   while (!before_gap_.empty()) {
     TextBufferRange* range = before_gap_.top();
     if (range->end() <= gap_start_)
       break;
     before_gap_.pop();
-    displaced.push_back(range);
+    displaced_.push_back(range);
     range->PopBack(range->end() - gap_start_);
   }
-  AddRanges(displaced.begin(), displaced.end());
+  AddRanges(displaced_.begin(), displaced_.end());
   for (auto& range : across_gap_)
     range->PopBack(count);
   after_gap_.ShiftBackward(count);
 }
 
+void TextBuffer::QueueEdit(size_t begin, size_t end, StringView text) {
+  QueuedEdit edit;
+  edit.begin = begin;
+  edit.end = end;
+  edit.text_offset = edit_text_.size();
+  edit.text_length = text.length();
+  edit.new_begin = 0;
+  edit_text_.insert(edit_text_.end(), text.begin(), text.end());
+  queued_edits_.push_back(edit);
+}
+
+// Sorts the queued edits by offset, trims them so that none of them overlap
+// and works out where each of them lands. Returns how much room the gap needs
+// for the edits to be made from front to back.
+size_t TextBuffer::SortQueuedEdits() {
+  // Inserts sort before deletes at the same offset, and in the order they
+  // were queued. Edits often arrive in order, e.g., from a search.
+  auto less = [](const QueuedEdit& lhs, const QueuedEdit& rhs) {
+    if (lhs.begin != rhs.begin)
+      return lhs.begin < rhs.begin;
+    if (lhs.end != rhs.end)
+      return lhs.end < rhs.end;
+    return lhs.text_offset < rhs.text_offset;
+  };
+  if (!std::is_sorted(queued_edits_.begin(), queued_edits_.end(), less))
+    std::sort(queued_edits_.begin(), queued_edits_.end(), less);
+  const size_t size = this->size();
+  size_t deleted_end = 0;
+  size_t inserted = 0;
+  size_t deleted = 0;
+  size_t growth = 0;
+  auto out = queued_edits_.begin();
+  for (QueuedEdit edit : queued_edits_) {
+    edit.begin = std::min(std::max(edit.begin, deleted_end), size);
+    edit.end = std::min(std::max(edit.end, edit.begin), size);
+    if (edit.begin == edit.end && !edit.text_length)
+      continue;
+    edit.new_begin = edit.begin + inserted - deleted;
+    inserted += edit.text_length;
+    deleted += edit.end - edit.begin;
+    if (inserted > deleted)
+      growth = std::max(growth, inserted - deleted);
+    deleted_end = edit.end;
+    *out++ = edit;
+  }
+  queued_edits_.erase(out, queued_edits_.end());
+  return growth;
+}
+
+void TextBuffer::ApplyQueuedEdits() {
+  TRACE_EVENT0("text", "TextBuffer::ApplyQueuedEdits");
+  const size_t growth = SortQueuedEdits();
+  if (queued_edits_.empty())
+    return;
+  if (!observers_.empty()) {
+    for (const QueuedEdit& edit : queued_edits_) {
+      TextBufferRange deleted(edit.begin, edit.end);
+      const char* text = edit_text_.data() + edit.text_offset;
+      NotifyWillReplace(edit.new_begin, GetTextForRange(&deleted),
+                        StringView(text, text + edit.text_length));
+    }
+  }
+
+  // Copy the buffer once up front, if need be, rather than part way through.
+  // If it has to be copied anyway, make the edits while copying it.
+  const QueuedEdit& first = queued_edits_.front();
+  const QueuedEdit& last = queued_edits_.back();
+  const size_t written_end = last.new_begin + last.text_length;
+  const size_t write_begin = std::min(first.begin, gap_start_);
+  const size_t write_end = first.begin < gap_start_
+                               ? std::max(gap_end_, written_end)
+                               : written_end;
+  const bool writable = (write_begin >= writable_begin_ &&
+                         write_end <= writable_end_) ||
+                        write_begin >= buffer().size() || !IsShared();
+  if (growth > gap_size() || !writable) {
+    RebuildWithQueuedEdits();
+    MapRangesThroughQueuedEdits();
+    return;
+  }
+  EnsureWritable(write_begin, write_end);
+
+  if (first.begin < gap_start_)
+    MoveGapBackward(gap_start_ - first.begin);
+  else
+    MoveGapForward(first.begin - gap_start_);
+  // |offset| is where the text after the gap was before the transaction.
+  size_t offset = first.begin;
+  for (const QueuedEdit& edit : queued_edits_) {
+    MoveGapForward(edit.begin - offset);
+    gap_end_ += edit.end - edit.begin;
+    memcpy(&buffer()[gap_start_], &edit_text_[edit.text_offset],
+           edit.text_length);
+    gap_start_ += edit.text_length;
+    offset = edit.end;
+  }
+  MapRangesThroughQueuedEdits();
+}
+
+// Copies the text into a new buffer, making the queued edits on the way, which
+// reads and writes each byte once rather than growing the buffer and then
+// moving the gap through it. The gap ends up after the last edit, as it does
+// when the edits are made in place.
+void TextBuffer::RebuildWithQueuedEdits() {
+  TRACE_EVENT0("text", "TextBuffer::RebuildWithQueuedEdits");
+  const QueuedEdit& last = queued_edits_.back();
+  const size_t written_end = last.new_begin + last.text_length;
+  const size_t new_size = written_end + size() - last.end;
+  const size_t buffer_size = new_size * 1.5 + 1;
+  std::vector<char> new_buffer;
+  // Keep any capacity that was reserved for appending.
+  const size_t reserved = buffer().capacity() - buffer().size();
+  new_buffer.reserve(buffer_size + reserved);
+  new_buffer.resize(buffer_size);
+  char* out = new_buffer.data();
+  // Copies [begin, end) of the text to |out|, wherever the gap is.
+  auto copy = [this, &out](size_t begin, size_t end) {
+    if (begin < gap_start_) {
+      const size_t split = std::min(end, gap_start_);
+      memcpy(out, data() + begin, split - begin);
+      out += split - begin;
+      begin = split;
+    }
+    if (begin < end) {
+      memcpy(out, data() + gap_size() + begin, end - begin);
+      out += end - begin;
+    }
+  };
+  size_t offset = 0;
+  for (const QueuedEdit& edit : queued_edits_) {
+    copy(offset, edit.begin);
+    if (edit.text_length) {
+      memcpy(out, &edit_text_[edit.text_offset], edit.text_length);
+      out += edit.text_length;
+    }
+    offset = edit.end;
+  }
+  out += buffer_size - new_size;
+  copy(offset, size());
+  gap_start_ = written_end;
+  gap_end_ = written_end + buffer_size - new_size;
+  // The snapshots keep the old buffer.
+  if (IsShared()) {
+    storage_.reset(new TextStorage());
+    writable_begin_ = 0;
+    writable_end_ = std::string::npos;
+  }
+  buffer().swap(new_buffer);
+}
+
+// Moves every range once, no matter how many edits there were, and sorts them
+// into the queues around where the gap ended up.
+void TextBuffer::MapRangesThroughQueuedEdits() {
+  displaced_.clear();
+  before_gap_.TakeAll(&displaced_);
+  displaced_.insert(displaced_.end(), across_gap_.begin(), across_gap_.end());
+  across_gap_.clear();
+  after_gap_.TakeAll(&displaced_);
+  typedef std::vector<QueuedEdit>::const_iterator Iterator;
+  // Returns where |offset| lands. |after| is the first edit that starts after
+  // |offset|, which decides whether text inserted at |offset| goes before it.
+  auto map_offset = [this](Iterator after, size_t offset) -> size_t {
+    if (after == queued_edits_.cbegin())
+      return offset;
+    const QueuedEdit& edit = *(after - 1);
+    if (offset < edit.end)
+      return edit.new_begin;
+    return edit.new_begin + edit.text_length + (offset - edit.end);
+  };
+  for (TextBufferRange* range : displaced_) {
+    const size_t start = range->start();
+    const size_t end = range->end();
+    // Text inserted at the start of a range goes before it, and text inserted
+    // at its end goes after it, unless the range is empty.
+    const Iterator after_start = std::upper_bound(
+        queued_edits_.cbegin(), queued_edits_.cend(), start,
+        [](size_t offset, const QueuedEdit& edit) {
+          return offset < edit.begin;
+        });
+    const Iterator after_end = std::lower_bound(
+        after_start, queued_edits_.cend(), end,
+        [](const QueuedEdit& edit, size_t offset) {
+          return edit.begin < offset;
+        });
+    const size_t new_start = map_offset(after_start, start);
+    if (start == end) {
+      range->MoveTo(new_start, new_start);
+      continue;
+    }
+    const size_t new_end = map_offset(after_end, end);
+    range->MoveTo(new_start, std::max(new_start, new_end));
+    // Dirty if an edit starts inside the range or deletes its first byte.
+    if (after_start != after_end ||
+        (after_start != queued_edits_.cbegin() &&
+         (after_start - 1)->end > start))
+      range->MarkDirty();
+  }
+  AddRanges(displaced_.begin(), displaced_.end());
+}
+
 void TextBuffer::DidMoveInsertionPointForward() {
-  std::vector<TextBufferRange*> displaced;
-  across_gap_.swap(displaced);
+  // Swapping keeps the capacity of both vectors, so steady-state edits do not
+  // allocate.
+  displaced_.clear();
+  across_gap_.swap(displaced_);
   while (!after_gap_.empty()) {
     TextBufferRange* range = after_gap_.top();
     if (range->start() >= gap_start_)
       break;
     after_gap_.pop();
-    displaced.push_back(range);
+    displaced_.push_back(range);
   }
-  AddRanges(displaced.begin(), displaced.end());
+  AddRanges(displaced_.begin(), displaced_.end());
 }
 
 void TextBuffer::DidMoveInsertionPointBackward() {
-  std::vector<TextBufferRange*> displaced;
-  across_gap_.swap(displaced);
+  // Swapping keeps the capacity of both vectors, so steady-state edits do not
+  // allocate.
+  displaced_.clear();
+  across_gap_.swap(displaced_);
   while (!before_gap_.empty()) {
     TextBufferRange* range = before_gap_.top();
     if (range->end() <= gap_start_)
       break;
     before_gap_.pop();
-    displaced.push_back(range);
+    displaced_.push_back(range);
   }
-  AddRanges(displaced.begin(), displaced.end());
+  AddRanges(displaced_.begin(), displaced_.end());
 }
 
 }  // namespace zi
@@ -14,12 +14,15 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "text/text_position.h"
+#include "text/text_buffer_observer.h"
 #include "text/text_buffer_range_queue.h"
 #include "text/text_buffer_range.h"
+#include "text/text_snapshot.h"
 #include "text/text_view.h"
 #include "zen/macros.h"
 #include "zen/string_view.h"
@@ -31,29 +34,59 @@ class TextBuffer {
  public:
   TextBuffer();
   explicit TextBuffer(std::vector<char> text);
+  // |buffer| holds |gap_size| bytes of gap followed by the text, so the first
+  // edits near the start of the text do not have to expand the buffer.
+  TextBuffer(std::vector<char> buffer, size_t gap_size);
   ~TextBuffer();
 
   void InsertCharacter(const TextPosition& position, char c);
   void InsertText(const TextPosition& position, StringView text);
   void InsertText(const TextPosition& position, const std::string& text);
+  // Adds |text| after the end of the text without moving the gap. The room
+  // for it comes from the capacity of the buffer, if it has any, so a loader
+  // that reserves capacity up front can append without copying.
+  void Append(StringView text);
   void DeleteCharacterAfter(size_t position);
   void DeleteRange(const TextBufferRange& range);
+  // Observers hear about this as one edit rather than a delete and an insert.
+  void ReplaceRange(const TextBufferRange& range, StringView text);
+
+  // Between BeginEdit() and Commit(), the edits above are queued instead of
+  // made. Their offsets refer to the text as it was at BeginEdit(), which is
+  // also what reads see until Commit(). Commit() makes the edits in order of
+  // offset in one pass through the buffer and then adjusts each range once,
+  // so an edit at many places costs about as much as one edit. Inserts at the
+  // same offset keep their order, text inserted into deleted text goes where
+  // the deleted text was, and text that several edits delete is deleted once.
+  // Observers hear about the edits in order of offset. Transactions nest.
+  void BeginEdit();
+  void Commit();
+  bool is_editing() const { return edit_depth_ > 0; }
 
   // Returns std::string::npos if |c| is not found.
   size_t Find(char c, size_t pos = 0u);
   size_t RFind(char c, size_t pos = std::string::npos);
 
   bool is_empty() const { return size() == 0u; }
-  size_t size() const { return buffer_.size() - gap_size(); }
+  size_t size() const { return buffer().size() - gap_size(); }
 
   std::string ToString() const;
   TextView GetText() const;
+  // Returns an immutable copy of the text without copying it. The first edit
+  // after the snapshot that would overwrite bytes the snapshot sees copies the
+  // buffer instead, unless the snapshot is gone by then. Typing where the
+  // snapshot was taken fills the gap and never copies.
+  TextSnapshot Snapshot();
   TextView GetTextForRange(TextBufferRange* range) const;
   char At(size_t offset);
 
   void AddRange(TextBufferRange* range);
   void RemoveRange(TextBufferRange* range);
 
+  // Observers must be removed before they are destroyed.
+  void AddObserver(TextBufferObserver* observer);
+  void RemoveObserver(TextBufferObserver* observer);
+
   template <typename Iterator>
   void AddRanges(Iterator begin, Iterator end) {
     for (Iterator it = begin; it != end; ++it)
@@ -75,25 +108,68 @@ class TextBuffer {
   void MoveInsertionPointTo(size_t position);
   void MoveInsertionPointForward(size_t offset);
   void MoveInsertionPointBackward(size_t offset);
+  // Move the bytes without adjusting the ranges.
+  void MoveGapForward(size_t offset);
+  void MoveGapBackward(size_t offset);
   void DidMoveInsertionPointForward();
   void DidMoveInsertionPointBackward();
 
+  void NotifyWillReplace(size_t offset,
+                         const TextView& deleted,
+                         const StringView& inserted);
+
   void Expand(size_t required_gap_size);
+  bool IsShared() const;
+  void EnsureWritable(size_t begin, size_t end);
+  void Unshare(size_t capacity);
   void DidInsert(size_t count);
   void DidDelete(size_t count);
 
-  const char* data() const { return buffer_.data(); }
+  void QueueEdit(size_t begin, size_t end, StringView text);
+  size_t SortQueuedEdits();
+  void ApplyQueuedEdits();
+  void RebuildWithQueuedEdits();
+  void MapRangesThroughQueuedEdits();
+
+  std::vector<char>& buffer() { return storage_->bytes; }
+  const std::vector<char>& buffer() const { return storage_->bytes; }
+  const char* data() const { return buffer().data(); }
   size_t gap_size() const { return gap_end_ - gap_start_; }
-  size_t tail_size() const { return buffer_.size() - gap_end_; }
+  size_t tail_size() const { return buffer().size() - gap_end_; }
 
   size_t gap_start_ = 0;
   size_t gap_end_ = 0;
-  std::vector<char> buffer_;
+  std::shared_ptr<TextStorage> storage_;
+  // While snapshots share |storage_|, [writable_begin_, writable_end_) is the
+  // part of the buffer that none of them can see, along with anything past
+  // the end of the buffer.
+  size_t writable_begin_ = 0;
+  size_t writable_end_ = std::string::npos;
 
   TextBufferRangeQueue<TextBufferRange::AscendingByEnd> before_gap_;
   std::vector<TextBufferRange*> across_gap_;
   TextBufferRangeQueue<TextBufferRange::DescendingByStart> after_gap_;
 
+  // Scratch space for the ranges that the gap moved past.
+  std::vector<TextBufferRange*> displaced_;
+
+  std::vector<TextBufferObserver*> observers_;
+
+  // An edit queued by a transaction. It replaces [begin, end), which might be
+  // empty, with |text_length| bytes of |edit_text_| from |text_offset|.
+  struct QueuedEdit {
+    size_t begin;
+    size_t end;
+    size_t text_offset;
+    size_t text_length;
+    // Where |begin| ends up once the edits before this one are made.
+    size_t new_begin;
+  };
+
+  size_t edit_depth_ = 0;
+  std::vector<QueuedEdit> queued_edits_;
+  std::vector<char> edit_text_;
+
   DISALLOW_COPY_AND_ASSIGN(TextBuffer);
 };
 
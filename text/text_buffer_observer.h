@@ -0,0 +1,38 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+
+#include "text/text_view.h"
+#include "zen/string_view.h"
+
+namespace zi {
+
+// Learns about every edit to a TextBuffer, e.g., to journal it. Loading text
+// with TextBuffer::Append is not an edit.
+class TextBufferObserver {
+ public:
+  // Called before |deleted| at |offset| is replaced with |inserted|. Both
+  // views are only valid during the call.
+  virtual void WillReplace(size_t offset,
+                           const TextView& deleted,
+                           const StringView& inserted) = 0;
+
+ protected:
+  virtual ~TextBufferObserver() = default;
+};
+
+}  // namespace zi
@@ -0,0 +1,179 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/text_buffer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+constexpr size_t kTextSize = 1 << 20;
+
+// Lines of 63 characters followed by a line break.
+std::vector<char> MakeText(size_t size) {
+  std::vector<char> text(size, 'a');
+  for (size_t i = 63; i < size; i += 64)
+    text[i] = '\n';
+  return text;
+}
+
+// Moves the gap back and forth between two positions |arg| bytes apart.
+void TextBuffer_InsertCharacter(BenchmarkState* state) {
+  TextBuffer text(MakeText(kTextSize));
+  const size_t positions[] = {kTextSize / 2, kTextSize / 2 + state->arg()};
+  size_t i = 0;
+  while (state->KeepRunning())
+    text.InsertCharacter(TextPosition(positions[i++ & 1]), 'x');
+  state->SetItemsProcessed(state->iterations());
+}
+BENCHMARK(TextBuffer_InsertCharacter, 0, 64, 4096, 262144);
+
+void TextBuffer_InsertText(BenchmarkState* state) {
+  TextBuffer text(MakeText(kTextSize));
+  const std::string inserted(64, 'x');
+  const size_t positions[] = {kTextSize / 2, kTextSize / 2 + state->arg()};
+  size_t i = 0;
+  while (state->KeepRunning())
+    text.InsertText(TextPosition(positions[i++ & 1]), inserted);
+  state->SetBytesProcessed(state->iterations() * inserted.size());
+}
+BENCHMARK(TextBuffer_InsertText, 0, 64, 4096, 262144);
+
+// Deletes |arg| bytes and inserts them again so the buffer keeps its size.
+void TextBuffer_DeleteRange(BenchmarkState* state) {
+  TextBuffer text(MakeText(kTextSize));
+  const std::string inserted(state->arg(), 'x');
+  const size_t position = kTextSize / 2;
+  while (state->KeepRunning()) {
+    text.DeleteRange(TextBufferRange(position, position + inserted.size()));
+    text.InsertText(TextPosition(position), inserted);
+  }
+  state->SetBytesProcessed(state->iterations() * inserted.size());
+}
+BENCHMARK(TextBuffer_DeleteRange, 1, 64, 4096, 262144);
+
+// Searches |arg| bytes, split by the gap, for a character that is absent.
+void TextBuffer_Find(BenchmarkState* state) {
+  TextBuffer text(MakeText(state->arg()));
+  text.InsertCharacter(TextPosition(state->arg() / 2), 'a');
+  while (state->KeepRunning())
+    DoNotOptimize(text.Find('x'));
+  state->SetBytesProcessed(state->iterations() * text.size());
+}
+BENCHMARK(TextBuffer_Find, 4096, 1 << 20, 1 << 24);
+
+void TextBuffer_RFind(BenchmarkState* state) {
+  TextBuffer text(MakeText(state->arg()));
+  text.InsertCharacter(TextPosition(state->arg() / 2), 'a');
+  while (state->KeepRunning())
+    DoNotOptimize(text.RFind('x'));
+  state->SetBytesProcessed(state->iterations() * text.size());
+}
+BENCHMARK(TextBuffer_RFind, 4096, 1 << 20, 1 << 24);
+
+// The first insertion into a freshly loaded buffer has to make a gap.
+void TextBuffer_Expand(BenchmarkState* state) {
+  const std::vector<char> contents = MakeText(state->arg());
+  while (state->KeepRunning()) {
+    state->PauseTiming();
+    std::unique_ptr<TextBuffer> text(new TextBuffer(contents));
+    state->ResumeTiming();
+    text->InsertCharacter(TextPosition(0), 'x');
+    state->PauseTiming();
+    text.reset();
+    state->ResumeTiming();
+  }
+  state->SetBytesProcessed(state->iterations() * contents.size());
+}
+BENCHMARK(TextBuffer_Expand, 4096, 1 << 20, 1 << 24);
+
+// Takes a snapshot of an |arg| byte buffer and types a character, as saving
+// while typing does. Neither should depend on the size of the text.
+void TextBuffer_Snapshot(BenchmarkState* state) {
+  TextBuffer text(MakeText(state->arg()));
+  size_t position = text.size() / 2;
+  text.InsertCharacter(TextPosition(position++), 'x');
+  while (state->KeepRunning()) {
+    TextSnapshot snapshot = text.Snapshot();
+    text.InsertCharacter(TextPosition(position++), 'x');
+  }
+  state->SetItemsProcessed(state->iterations());
+}
+BENCHMARK(TextBuffer_Snapshot, 4096, 1 << 20, 1 << 24);
+
+std::vector<std::unique_ptr<TextBufferRange>> AddLineRanges(TextBuffer* text,
+                                                            size_t count) {
+  std::vector<std::unique_ptr<TextBufferRange>> ranges;
+  for (size_t i = 0; i < count; ++i) {
+    ranges.emplace_back(new TextBufferRange(i * 64 + 1, i * 64 + 63));
+    text->AddRange(ranges.back().get());
+  }
+  return ranges;
+}
+
+// Inserts before |arg| registered ranges, which all have to shift.
+void TextBuffer_ShiftRanges(BenchmarkState* state) {
+  TextBuffer text(MakeText(state->arg() * 64));
+  auto ranges = AddLineRanges(&text, state->arg());
+  while (state->KeepRunning())
+    text.InsertCharacter(TextPosition(0), 'x');
+  state->SetItemsProcessed(state->iterations() * ranges.size());
+}
+BENCHMARK(TextBuffer_ShiftRanges, 1, 1000, 1000000);
+
+// Moves the gap from one end of the text to the other, across |arg| ranges.
+void TextBuffer_MoveGapAcrossRanges(BenchmarkState* state) {
+  TextBuffer text(MakeText(state->arg() * 64));
+  auto ranges = AddLineRanges(&text, state->arg());
+  size_t i = 0;
+  while (state->KeepRunning()) {
+    const size_t position = (i++ & 1) ? text.size() : 0;
+    text.InsertCharacter(TextPosition(position), 'x');
+  }
+  state->SetItemsProcessed(state->iterations() * ranges.size());
+}
+BENCHMARK(TextBuffer_MoveGapAcrossRanges, 1, 1000, 1000000);
+
+// Inserts at 10,000 scattered offsets in a buffer with a range on every line,
+// one edit at a time if |arg| is zero and in one transaction otherwise.
+void TextBuffer_ScatteredEdits(BenchmarkState* state) {
+  constexpr size_t kEditCount = 10000;
+  const std::vector<char> contents = MakeText(kTextSize);
+  while (state->KeepRunning()) {
+    state->PauseTiming();
+    std::unique_ptr<TextBuffer> text(new TextBuffer(contents));
+    auto ranges = AddLineRanges(text.get(), kTextSize / 64);
+    state->ResumeTiming();
+    if (state->arg())
+      text->BeginEdit();
+    for (size_t i = 0; i < kEditCount; ++i)
+      text->InsertCharacter(TextPosition(i * 7919 % kTextSize), 'x');
+    if (state->arg())
+      text->Commit();
+    state->PauseTiming();
+    text.reset();
+    ranges.clear();
+    state->ResumeTiming();
+  }
+  state->SetItemsProcessed(state->iterations() * kEditCount);
+}
+BENCHMARK(TextBuffer_ScatteredEdits, 0, 1);
+
+}  // namespace
+}  // namespace zi
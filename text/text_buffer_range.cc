@@ -31,8 +31,6 @@ TextBufferRange::TextBufferRange(const TextRange& range)
 TextBufferRange::TextBufferRange(const TextSelection& selection)
     : TextBufferRange(selection.start_offset(), selection.end_offset()) {}
 
-TextBufferRange::~TextBufferRange() = default;
-
 void TextBufferRange::MarkDirty() {
   is_dirty_ = true;
 }
@@ -88,6 +86,11 @@ void TextBufferRange::ShiftBackward(size_t count) {
   end_ -= delta;
 }
 
+void TextBufferRange::MoveTo(size_t start, size_t end) {
+  start_ = start;
+  end_ = end;
+}
+
 bool TextBufferRange::DescendingByStart::operator()(
     const TextBufferRange* lhs,
     const TextBufferRange* rhs) const {
@@ -28,7 +28,8 @@ class TextBufferRange {
   TextBufferRange(size_t begin, size_t end);
   explicit TextBufferRange(const TextRange& range);
   explicit TextBufferRange(const TextSelection& selection);
-  ~TextBufferRange();
+  // Trivial so that TextBufferRangePool can release ranges in bulk.
+  ~TextBufferRange() = default;
 
   void MarkDirty();
   void MarkClean();
@@ -41,6 +42,8 @@ class TextBufferRange {
 
   void ShiftForward(size_t count);
   void ShiftBackward(size_t count);
+  // Moves the range to [start, end) without marking it dirty.
+  void MoveTo(size_t start, size_t end);
 
   bool is_dirty() const { return is_dirty_; }
 
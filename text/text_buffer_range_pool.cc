@@ -0,0 +1,70 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/text_buffer_range_pool.h"
+
+#include <new>
+
+namespace zi {
+
+// Clear() does not run destructors.
+static_assert(std::is_trivially_destructible<TextBufferRange>::value,
+              "TextBufferRange must be trivially destructible");
+static_assert(sizeof(TextBufferRange) >= sizeof(void*),
+              "A free slot must fit in a TextBufferRange");
+
+constexpr size_t TextBufferRangePool::kSlabSize;
+
+TextBufferRangePool::TextBufferRangePool() = default;
+
+TextBufferRangePool::~TextBufferRangePool() = default;
+
+TextBufferRange* TextBufferRangePool::New(size_t start, size_t end) {
+  void* slot;
+  if (free_list_) {
+    slot = free_list_;
+    free_list_ = free_list_->next;
+  } else {
+    slot = NextUnusedSlot();
+  }
+  ++size_;
+  return new (slot) TextBufferRange(start, end);
+}
+
+void TextBufferRangePool::Delete(TextBufferRange* range) {
+  range->~TextBufferRange();
+  FreeSlot* slot = new (range) FreeSlot;
+  slot->next = free_list_;
+  free_list_ = slot;
+  --size_;
+}
+
+void TextBufferRangePool::Clear() {
+  slab_index_ = 0;
+  slot_index_ = 0;
+  free_list_ = nullptr;
+  size_ = 0;
+}
+
+TextBufferRangePool::Slot* TextBufferRangePool::NextUnusedSlot() {
+  if (slot_index_ == kSlabSize) {
+    ++slab_index_;
+    slot_index_ = 0;
+  }
+  if (slab_index_ == slabs_.size())
+    slabs_.emplace_back(new Slot[kSlabSize]);
+  return &slabs_[slab_index_][slot_index_++];
+}
+
+}  // namespace zi
@@ -0,0 +1,70 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "text/text_buffer_range.h"
+#include "zen/macros.h"
+
+namespace zi {
+
+// Hands out TextBufferRanges from slabs of contiguous storage instead of one
+// heap allocation each. Ranges allocated one after another sit next to each
+// other in memory, so walking them (or the range queues that point at them)
+// stays in cache. Deleted ranges are recycled, and Clear() returns every
+// range to the pool at once while keeping the slabs for reuse.
+class TextBufferRangePool {
+ public:
+  TextBufferRangePool();
+  ~TextBufferRangePool();
+
+  TextBufferRange* New(size_t start, size_t end);
+  void Delete(TextBufferRange* range);
+
+  // Invalidates every range from this pool.
+  void Clear();
+
+  // The number of ranges in use.
+  size_t size() const { return size_; }
+  size_t capacity() const { return slabs_.size() * kSlabSize; }
+
+ private:
+  static constexpr size_t kSlabSize = 1024;
+
+  typedef std::aligned_storage<sizeof(TextBufferRange),
+                               alignof(TextBufferRange)>::type Slot;
+  struct FreeSlot {
+    FreeSlot* next;
+  };
+
+  Slot* NextUnusedSlot();
+
+  std::vector<std::unique_ptr<Slot[]>> slabs_;
+  // Slots are handed out in order from |slabs_[slab_index_]| on, starting at
+  // |slot_index_|, once the free list is empty.
+  size_t slab_index_ = 0;
+  size_t slot_index_ = 0;
+  FreeSlot* free_list_ = nullptr;
+  size_t size_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(TextBufferRangePool);
+};
+
+}  // namespace zi
@@ -0,0 +1,96 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/text_buffer_range_pool.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "text/text_buffer.h"
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+// Allocates and frees |arg| ranges one heap allocation at a time.
+void TextBufferRange_NewDelete(BenchmarkState* state) {
+  std::vector<std::unique_ptr<TextBufferRange>> ranges;
+  ranges.reserve(state->arg());
+  while (state->KeepRunning()) {
+    for (size_t i = 0; i < state->arg(); ++i)
+      ranges.emplace_back(new TextBufferRange(i, i + 1));
+    ranges.clear();
+  }
+  state->SetItemsProcessed(state->iterations() * state->arg());
+}
+BENCHMARK(TextBufferRange_NewDelete, 1000, 1000000);
+
+// Allocates |arg| ranges from a pool and releases them in bulk.
+void TextBufferRangePool_NewClear(BenchmarkState* state) {
+  TextBufferRangePool pool;
+  std::vector<TextBufferRange*> ranges;
+  ranges.reserve(state->arg());
+  while (state->KeepRunning()) {
+    for (size_t i = 0; i < state->arg(); ++i)
+      ranges.push_back(pool.New(i, i + 1));
+    ranges.clear();
+    pool.Clear();
+  }
+  state->SetItemsProcessed(state->iterations() * state->arg());
+}
+BENCHMARK(TextBufferRangePool_NewClear, 1000, 1000000);
+
+std::vector<char> MakeText(size_t size) {
+  std::vector<char> text(size, 'a');
+  for (size_t i = 63; i < size; i += 64)
+    text[i] = '\n';
+  return text;
+}
+
+// Inserts before |arg| ranges that were allocated between other objects, as
+// ranges created over an editing session are, so each one that shifts is
+// likely a cache miss.
+void TextBuffer_ShiftHeapRanges(BenchmarkState* state) {
+  TextBuffer text(MakeText(state->arg() * 64));
+  std::vector<std::unique_ptr<TextBufferRange>> ranges;
+  std::vector<std::string> neighbors;
+  for (size_t i = 0; i < state->arg(); ++i) {
+    ranges.emplace_back(new TextBufferRange(i * 64 + 1, i * 64 + 63));
+    neighbors.emplace_back(48 + i % 64, 'x');
+    text.AddRange(ranges.back().get());
+  }
+  while (state->KeepRunning())
+    text.InsertCharacter(TextPosition(0), 'x');
+  state->SetItemsProcessed(state->iterations() * state->arg());
+}
+BENCHMARK(TextBuffer_ShiftHeapRanges, 1000, 1000000);
+
+// The same with the ranges allocated from a TextBufferRangePool.
+void TextBuffer_ShiftPooledRanges(BenchmarkState* state) {
+  TextBuffer text(MakeText(state->arg() * 64));
+  TextBufferRangePool pool;
+  std::vector<std::string> neighbors;
+  for (size_t i = 0; i < state->arg(); ++i) {
+    neighbors.emplace_back(48 + i % 64, 'x');
+    text.AddRange(pool.New(i * 64 + 1, i * 64 + 63));
+  }
+  while (state->KeepRunning())
+    text.InsertCharacter(TextPosition(0), 'x');
+  state->SetItemsProcessed(state->iterations() * state->arg());
+}
+BENCHMARK(TextBuffer_ShiftPooledRanges, 1000, 1000000);
+
+}  // namespace
+}  // namespace zi
@@ -0,0 +1,65 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/text_buffer_range_pool.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+TEST(TextBufferRangePool, Contiguous) {
+  TextBufferRangePool pool;
+  TextBufferRange* first = pool.New(0, 1);
+  TextBufferRange* second = pool.New(1, 2);
+  EXPECT_EQ(first + 1, second);
+  EXPECT_EQ(0u, first->start());
+  EXPECT_EQ(2u, second->end());
+  EXPECT_EQ(2u, pool.size());
+}
+
+TEST(TextBufferRangePool, RecyclesDeletedRanges) {
+  TextBufferRangePool pool;
+  pool.New(0, 1);
+  TextBufferRange* range = pool.New(1, 2);
+  pool.New(2, 3);
+  pool.Delete(range);
+  EXPECT_EQ(2u, pool.size());
+  TextBufferRange* recycled = pool.New(5, 7);
+  EXPECT_EQ(range, recycled);
+  EXPECT_EQ(5u, recycled->start());
+  EXPECT_EQ(2u, recycled->length());
+  EXPECT_FALSE(recycled->is_dirty());
+}
+
+TEST(TextBufferRangePool, ClearKeepsSlabs) {
+  TextBufferRangePool pool;
+  std::vector<TextBufferRange*> ranges;
+  for (size_t i = 0; i < 3000; ++i)
+    ranges.push_back(pool.New(i, i + 1));
+  const size_t capacity = pool.capacity();
+  EXPECT_LE(3000u, capacity);
+
+  pool.Clear();
+  EXPECT_EQ(0u, pool.size());
+  // The same slots are handed out again, in the same order.
+  for (size_t i = 0; i < 3000; ++i)
+    EXPECT_EQ(ranges[i], pool.New(i, i + 2));
+  EXPECT_EQ(capacity, pool.capacity());
+}
+
+}  // namespace
+}  // namespace zi
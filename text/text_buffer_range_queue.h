@@ -36,6 +36,12 @@ class TextBufferRangeQueue
       value->ShiftBackward(count);
   }
 
+  // Moves every range in the queue to the end of |ranges|.
+  void TakeAll(std::vector<TextBufferRange*>* ranges) {
+    ranges->insert(ranges->end(), this->c.begin(), this->c.end());
+    this->c.clear();
+  }
+
   template <typename Iterator>
   void Erase(Iterator begin, Iterator end) {
     if (EraseAllValues(&this->c, begin, end))
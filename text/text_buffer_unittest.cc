@@ -14,12 +14,15 @@
 
 #include "text/text_buffer.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
 #include <iostream>
 
 #include "gtest/gtest.h"
+#include "text/text_buffer_observer.h"
+#include "zen/allocation_counter.h"
 
 namespace zi {
 namespace {
@@ -57,6 +60,18 @@ TEST(TextBuffer, Find) {
   EXPECT_EQ(14u, buffer.Find('d'));
 }
 
+TEST(TextBuffer, InitialGap) {
+  std::string text = "....Hello";
+  std::vector<char> data(text.begin(), text.end());
+  TextBuffer buffer(std::move(data), 4);
+  EXPECT_EQ("Hello", buffer.ToString());
+  const char* storage = buffer.GetText().right().data();
+  buffer.InsertText(TextPosition(0), std::string("abcd"));
+  EXPECT_EQ("abcdHello", buffer.ToString());
+  // The gap had room, so the text did not move.
+  EXPECT_EQ(storage, buffer.GetText().right().data());
+}
+
 TEST(TextBuffer, RFind) {
   TextBuffer empty_buffer;
   EXPECT_EQ(std::string::npos, empty_buffer.RFind('x'));
@@ -356,5 +371,194 @@ TEST(TextBuffer, AddRange) {
   EXPECT_EQ("", buffer.ToString());
 }
 
+TEST(TextBuffer, RemoveRange) {
+  std::string text = "Hello, world";
+  TextBuffer buffer(std::vector<char>(text.begin(), text.end()));
+  TextBufferRange hello(0, 5);
+  TextBufferRange world(7, 12);
+  buffer.AddRange(&hello);
+  buffer.AddRange(&world);
+  buffer.RemoveRange(&world);
+  buffer.InsertText(TextPosition(0), ">> ");
+  EXPECT_EQ("Hello", buffer.GetTextForRange(&hello).ToString());
+  EXPECT_EQ(7u, world.start());
+}
+
+TEST(TextBuffer, RemoveRangeDoesNotAllocate) {
+  std::string text = "Hello, world";
+  TextBuffer buffer(std::vector<char>(text.begin(), text.end()));
+  TextBufferRange hello(0, 5);
+  TextBufferRange world(7, 12);
+  buffer.AddRange(&hello);
+  buffer.AddRange(&world);
+  const ScopedAllocationCounter allocations;
+  buffer.RemoveRange(&world);
+  buffer.RemoveRange(&hello);
+  EXPECT_EQ(0u, allocations.count());
+}
+
+// Applies every edit it hears about to a string of its own.
+class ReplayingObserver : public TextBufferObserver {
+ public:
+  explicit ReplayingObserver(std::string text) : text_(std::move(text)) {}
+
+  void WillReplace(size_t offset,
+                   const TextView& deleted,
+                   const StringView& inserted) override {
+    EXPECT_EQ(text_.substr(offset, deleted.length()), deleted.ToString());
+    text_.replace(offset, deleted.length(), inserted.ToString());
+  }
+
+  const std::string& text() const { return text_; }
+
+ private:
+  std::string text_;
+};
+
+TEST(TextBuffer, EditTransaction) {
+  std::string text = "Hello, world";
+  TextBuffer buffer(std::vector<char>(text.begin(), text.end()));
+  ReplayingObserver observer(text);
+  buffer.AddObserver(&observer);
+
+  buffer.BeginEdit();
+  EXPECT_TRUE(buffer.is_editing());
+  buffer.InsertText(TextPosition(12), "!");
+  buffer.DeleteRange(TextBufferRange(5, 6));
+  buffer.InsertCharacter(TextPosition(0), 'O');
+  buffer.InsertText(TextPosition(0), "h, ");
+  buffer.BeginEdit();
+  buffer.InsertText(TextPosition(7), "big ");
+  buffer.Commit();
+  // Nothing changes until the outermost transaction commits.
+  EXPECT_EQ(text, buffer.ToString());
+  buffer.Commit();
+  EXPECT_FALSE(buffer.is_editing());
+  EXPECT_EQ("Oh, Hello big world!", buffer.ToString());
+  EXPECT_EQ(buffer.ToString(), observer.text());
+
+  // Edits that overlap.
+  buffer.BeginEdit();
+  buffer.DeleteRange(TextBufferRange(0, 4));
+  buffer.DeleteRange(TextBufferRange(2, 10));
+  buffer.InsertText(TextPosition(6), "Well");
+  buffer.InsertText(TextPosition(20), "?");
+  buffer.DeleteRange(TextBufferRange(19, 30));
+  buffer.Commit();
+  EXPECT_EQ("Wellbig world?", buffer.ToString());
+  EXPECT_EQ(buffer.ToString(), observer.text());
+  buffer.RemoveObserver(&observer);
+}
+
+TEST(TextBuffer, EditTransactionMatchesEdits) {
+  std::string text;
+  for (int i = 0; i < 1000; ++i)
+    text += "line " + std::to_string(i) + "\n";
+  TextBuffer buffer(std::vector<char>(text.begin(), text.end()));
+  TextBuffer expected(std::vector<char>(text.begin(), text.end()));
+  ReplayingObserver observer(text);
+  buffer.AddObserver(&observer);
+
+  // Scattered edits queued in no particular order. Making them from the back
+  // to the front one at a time keeps the offsets of the others valid.
+  std::vector<size_t> offsets;
+  for (size_t i = 0; i < 200; ++i)
+    offsets.push_back((i * 7919) % (text.size() / 8) * 8);
+  buffer.BeginEdit();
+  for (size_t offset : offsets) {
+    buffer.DeleteRange(TextBufferRange(offset, offset + 3));
+    buffer.InsertText(TextPosition(offset), "[" + std::to_string(offset) + "]");
+  }
+  buffer.Commit();
+  std::sort(offsets.begin(), offsets.end());
+  for (auto it = offsets.rbegin(); it != offsets.rend(); ++it) {
+    expected.DeleteRange(TextBufferRange(*it, *it + 3));
+    expected.InsertText(TextPosition(*it), "[" + std::to_string(*it) + "]");
+  }
+  EXPECT_EQ(expected.ToString(), buffer.ToString());
+  EXPECT_EQ(buffer.ToString(), observer.text());
+  buffer.RemoveObserver(&observer);
+}
+
+TEST(TextBuffer, EditTransactionRanges) {
+  std::string text = "one two three four";
+  TextBuffer buffer(std::vector<char>(text.begin(), text.end()));
+  TextBufferRange one(0, 3);
+  TextBufferRange two(4, 7);
+  TextBufferRange three(8, 13);
+  TextBufferRange four(14, 18);
+  TextBufferRange empty(7, 7);
+  buffer.AddRange(&one);
+  buffer.AddRange(&two);
+  buffer.AddRange(&three);
+  buffer.AddRange(&four);
+  buffer.AddRange(&empty);
+
+  buffer.BeginEdit();
+  buffer.InsertText(TextPosition(0), ">");
+  buffer.InsertText(TextPosition(3), "<");
+  buffer.InsertText(TextPosition(5), "W");
+  buffer.InsertText(TextPosition(7), "!");
+  buffer.DeleteRange(TextBufferRange(10, 16));
+  buffer.Commit();
+  EXPECT_EQ(">one< tWwo! thur", buffer.ToString());
+
+  EXPECT_EQ("one", buffer.GetTextForRange(&one).ToString());
+  EXPECT_FALSE(one.is_dirty());
+  EXPECT_EQ("tWwo", buffer.GetTextForRange(&two).ToString());
+  EXPECT_TRUE(two.is_dirty());
+  EXPECT_EQ("th", buffer.GetTextForRange(&three).ToString());
+  EXPECT_TRUE(three.is_dirty());
+  EXPECT_EQ("ur", buffer.GetTextForRange(&four).ToString());
+  EXPECT_TRUE(four.is_dirty());
+  EXPECT_EQ(11u, empty.start());
+  EXPECT_EQ(11u, empty.end());
+
+  // The ranges still follow ordinary edits.
+  buffer.InsertCharacter(TextPosition(0), '-');
+  EXPECT_EQ("one", buffer.GetTextForRange(&one).ToString());
+  EXPECT_EQ("ur", buffer.GetTextForRange(&four).ToString());
+}
+
+TEST(TextBuffer, ReplaceRange) {
+  std::string text = "one two three";
+  std::string gap_and_text = "    " + text;
+  TextBuffer buffer(
+      std::vector<char>(gap_and_text.begin(), gap_and_text.end()), 4);
+  ReplayingObserver observer(text);
+  buffer.AddObserver(&observer);
+  TextBufferRange two(4, 7);
+  TextBufferRange three(8, 13);
+  TextBufferRange inside(5, 6);
+  buffer.AddRange(&two);
+  buffer.AddRange(&three);
+  buffer.AddRange(&inside);
+  const TextSnapshot snapshot = buffer.Snapshot();
+
+  buffer.ReplaceRange(TextBufferRange(4, 7), std::string("2"));
+  EXPECT_EQ("one 2 three", buffer.ToString());
+  EXPECT_EQ("2", buffer.GetTextForRange(&two).ToString());
+  EXPECT_EQ(4u, inside.start());
+  EXPECT_EQ(4u, inside.end());
+
+  // Outgrows the gap, so the edits are made while copying the buffer.
+  buffer.BeginEdit();
+  buffer.ReplaceRange(TextBufferRange(0, 3), std::string("uno"));
+  buffer.ReplaceRange(TextBufferRange(4, 5), std::string("dos"));
+  buffer.ReplaceRange(TextBufferRange(6, 11), std::string("tres"));
+  buffer.InsertText(TextPosition(11), "!");
+  buffer.Commit();
+  EXPECT_EQ("uno dos tres!", buffer.ToString());
+  EXPECT_EQ("dos", buffer.GetTextForRange(&two).ToString());
+  EXPECT_EQ("tres", buffer.GetTextForRange(&three).ToString());
+  EXPECT_EQ(buffer.ToString(), observer.text());
+  EXPECT_EQ(text, snapshot.text().ToString());
+
+  // The gap is after the last edit.
+  buffer.InsertCharacter(TextPosition(13), '?');
+  EXPECT_EQ("uno dos tres!?", buffer.ToString());
+  buffer.RemoveObserver(&observer);
+}
+
 }  // namespace
 }  // namespace zi
@@ -0,0 +1,69 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/text_snapshot.h"
+
+#include <utility>
+
+namespace zi {
+
+TextSnapshot::TextSnapshot() = default;
+
+TextSnapshot::TextSnapshot(std::string text) : storage_(new TextStorage()) {
+  storage_->bytes.assign(text.begin(), text.end());
+  const char* data = storage_->bytes.data();
+  text_ = TextView(StringView(data, data + storage_->bytes.size()));
+  storage_->snapshot_count.store(1, std::memory_order_relaxed);
+}
+
+TextSnapshot::TextSnapshot(std::shared_ptr<TextStorage> storage,
+                           const TextView& text)
+    : storage_(std::move(storage)), text_(text) {
+  storage_->snapshot_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+TextSnapshot::TextSnapshot(const TextSnapshot& other)
+    : storage_(other.storage_), text_(other.text_) {
+  if (storage_)
+    storage_->snapshot_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+TextSnapshot::TextSnapshot(TextSnapshot&& other) : TextSnapshot() {
+  Swap(&other);
+}
+
+// The release pairs with the acquire in TextBuffer, so that our reads happen
+// before the buffer writes over the bytes.
+TextSnapshot::~TextSnapshot() {
+  if (storage_)
+    storage_->snapshot_count.fetch_sub(1, std::memory_order_release);
+}
+
+TextSnapshot& TextSnapshot::operator=(TextSnapshot other) {
+  Swap(&other);
+  return *this;
+}
+
+TextSnapshot TextSnapshot::Slice(size_t begin, size_t end) const {
+  if (!storage_)
+    return TextSnapshot();
+  return TextSnapshot(storage_, text_.Slice(begin, end));
+}
+
+void TextSnapshot::Swap(TextSnapshot* other) {
+  std::swap(storage_, other->storage_);
+  std::swap(text_, other->text_);
+}
+
+}  // namespace zi
@@ -0,0 +1,67 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "text/text_view.h"
+
+namespace zi {
+
+// The bytes of a TextBuffer, which its snapshots share. While any snapshot is
+// alive, the buffer only writes to bytes that none of them can see and copies
+// the bytes before writing anywhere else.
+struct TextStorage {
+  std::vector<char> bytes;
+  std::atomic<size_t> snapshot_count{0};
+};
+
+// An immutable view of the text of a TextBuffer at a point in time. Taking a
+// snapshot does not copy the text, and any thread may read a snapshot while
+// the buffer keeps changing.
+class TextSnapshot {
+ public:
+  TextSnapshot();
+  // A snapshot of |text| that is not taken from a buffer.
+  explicit TextSnapshot(std::string text);
+  TextSnapshot(const TextSnapshot& other);
+  TextSnapshot(TextSnapshot&& other);
+  ~TextSnapshot();
+
+  TextSnapshot& operator=(TextSnapshot other);
+
+  const TextView& text() const { return text_; }
+  size_t size() const { return text_.length(); }
+  std::string ToString() const { return text_.ToString(); }
+
+  // A snapshot of [begin, end) of this one that shares its bytes.
+  TextSnapshot Slice(size_t begin, size_t end) const;
+
+ private:
+  friend class TextBuffer;
+  TextSnapshot(std::shared_ptr<TextStorage> storage, const TextView& text);
+
+  void Swap(TextSnapshot* other);
+
+  std::shared_ptr<TextStorage> storage_;
+  TextView text_;
+};
+
+}  // namespace zi
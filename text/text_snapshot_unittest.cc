@@ -0,0 +1,126 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/text_snapshot.h"
+
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "text/text_buffer.h"
+
+namespace zi {
+namespace {
+
+TextBuffer* MakeBuffer(const std::string& text) {
+  return new TextBuffer(std::vector<char>(text.begin(), text.end()));
+}
+
+TEST(TextSnapshot, FromString) {
+  TextSnapshot empty;
+  EXPECT_EQ(0u, empty.size());
+  EXPECT_EQ("", empty.ToString());
+
+  TextSnapshot snapshot(std::string("hello"));
+  EXPECT_EQ(5u, snapshot.size());
+  TextSnapshot copy = snapshot;
+  snapshot = TextSnapshot();
+  EXPECT_EQ("hello", copy.ToString());
+}
+
+TEST(TextSnapshot, TypingAtTheGapDoesNotCopy) {
+  std::unique_ptr<TextBuffer> buffer(MakeBuffer("Hello, world"));
+  buffer->InsertText(TextPosition(5), "!");
+  TextSnapshot snapshot = buffer->Snapshot();
+  const char* data = snapshot.text().left().data();
+
+  buffer->InsertText(TextPosition(6), " there");
+  buffer->InsertCharacter(TextPosition(12), '!');
+  EXPECT_EQ("Hello! there!, world", buffer->ToString());
+  EXPECT_EQ("Hello!, world", snapshot.ToString());
+  EXPECT_EQ(data, buffer->GetText().left().data());
+}
+
+TEST(TextSnapshot, EditingElsewhereCopies) {
+  std::unique_ptr<TextBuffer> buffer(MakeBuffer("Hello, world"));
+  TextSnapshot snapshot = buffer->Snapshot();
+  const char* data = snapshot.text().left().data();
+
+  buffer->DeleteCharacterAfter(5);
+  buffer->InsertText(TextPosition(11), "s");
+  buffer->InsertText(TextPosition(0), "Oh, ");
+  EXPECT_EQ("Oh, Hello worlds", buffer->ToString());
+  EXPECT_EQ("Hello, world", snapshot.ToString());
+  EXPECT_NE(data, buffer->GetText().left().data());
+}
+
+TEST(TextSnapshot, DoesNotCopyOnceReleased) {
+  std::unique_ptr<TextBuffer> buffer(MakeBuffer("Hello, world"));
+  TextSnapshot snapshot = buffer->Snapshot();
+  snapshot = TextSnapshot();
+
+  const char* data = buffer->GetText().left().data();
+  buffer->DeleteCharacterAfter(0);
+  buffer->InsertText(TextPosition(0), "J");
+  EXPECT_EQ("Jello, world", buffer->ToString());
+  EXPECT_EQ(data, buffer->GetText().left().data());
+}
+
+TEST(TextSnapshot, SurvivesAppendAndTheBuffer) {
+  std::vector<char> text(5, 'a');
+  text.reserve(64);
+  std::unique_ptr<TextBuffer> buffer(new TextBuffer(std::move(text)));
+  TextSnapshot snapshot = buffer->Snapshot();
+  buffer->Append(std::string("bbbbb"));
+  EXPECT_EQ("aaaaabbbbb", buffer->ToString());
+  EXPECT_EQ("aaaaa", snapshot.ToString());
+
+  buffer->Append(std::string(100, 'c'));
+  EXPECT_EQ(110u, buffer->size());
+  buffer.reset();
+  EXPECT_EQ("aaaaa", snapshot.ToString());
+}
+
+TEST(TextSnapshot, ReadsWhileTheBufferChanges) {
+  const std::string text(1 << 16, 'x');
+  std::unique_ptr<TextBuffer> buffer(MakeBuffer(text));
+  TextSnapshot snapshot = buffer->Snapshot();
+  std::thread reader([snapshot, &text] {
+    for (int i = 0; i < 16; ++i)
+      EXPECT_EQ(text, snapshot.ToString());
+  });
+  for (size_t i = 0; i < 1000; ++i) {
+    buffer->InsertCharacter(TextPosition((i * 7919) % buffer->size()), 'y');
+    // Keep taking snapshots so that the buffer copies more than once.
+    if (i % 100 == 0)
+      snapshot = buffer->Snapshot();
+  }
+  reader.join();
+  EXPECT_EQ(text.size() + 1000, buffer->size());
+}
+
+TEST(TextSnapshot, Slice) {
+  TextSnapshot snapshot("one\ntwo\n");
+  TextSnapshot slice = snapshot.Slice(4, 8);
+  EXPECT_EQ("two\n", slice.ToString());
+  snapshot = TextSnapshot();
+  // The slice keeps the bytes alive.
+  EXPECT_EQ("two\n", slice.ToString());
+  EXPECT_EQ(0u, TextSnapshot().Slice(0, 4).size());
+}
+
+}  // namespace
+}  // namespace zi
@@ -14,6 +14,10 @@
 
 #include "text/text_view.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 namespace zi {
 
 TextView::TextView() = default;
@@ -27,6 +31,52 @@ TextView::TextView(const StringView& left, const StringView& right)
 
 TextView::~TextView() = default;
 
+size_t TextView::Find(char c, size_t pos) const {
+  const size_t left_length = left_.length();
+  if (pos < left_length) {
+    const char* found = static_cast<const char*>(
+        memchr(left_.data() + pos, c, left_length - pos));
+    if (found)
+      return found - left_.data();
+    pos = left_length;
+  }
+  pos -= left_length;
+  if (pos < right_.length()) {
+    const char* found = static_cast<const char*>(
+        memchr(right_.data() + pos, c, right_.length() - pos));
+    if (found)
+      return left_length + (found - right_.data());
+  }
+  return std::string::npos;
+}
+
+size_t TextView::Find(const StringView& pattern, size_t pos) const {
+  const size_t length = pattern.length();
+  if (!length)
+    return pos <= this->length() ? pos : std::string::npos;
+  const size_t left_length = left_.length();
+  if (pos < left_length) {
+    const char* found = static_cast<const char*>(
+        memmem(left_.data() + pos, left_length - pos, pattern.data(), length));
+    if (found)
+      return found - left_.data();
+    const size_t straddle = left_length - std::min(left_length, length - 1);
+    for (size_t i = std::max(pos, straddle); i < left_length; ++i) {
+      if (MatchesAcrossHalves(i, pattern))
+        return i;
+    }
+    pos = left_length;
+  }
+  pos -= left_length;
+  if (pos < right_.length()) {
+    const char* found = static_cast<const char*>(memmem(
+        right_.data() + pos, right_.length() - pos, pattern.data(), length));
+    if (found)
+      return left_length + (found - right_.data());
+  }
+  return std::string::npos;
+}
+
 std::string TextView::ToString() const {
   std::string result;
   const size_t left_length = left_.length();
@@ -39,4 +89,29 @@ std::string TextView::ToString() const {
   return result;
 }
 
+TextView TextView::Slice(size_t begin, size_t end) const {
+  const size_t left_length = left_.length();
+  end = std::min(end, length());
+  begin = std::min(begin, end);
+  auto slice = [](const StringView& half, size_t begin, size_t end) {
+    return StringView(half.data() + begin, half.data() + end);
+  };
+  if (end <= left_length)
+    return TextView(slice(left_, begin, end));
+  if (begin >= left_length)
+    return TextView(slice(right_, begin - left_length, end - left_length));
+  return TextView(slice(left_, begin, left_length),
+                  slice(right_, 0, end - left_length));
+}
+
+// Whether |pattern| starts at |pos| in the left half and ends in the right.
+bool TextView::MatchesAcrossHalves(size_t pos,
+                                   const StringView& pattern) const {
+  const size_t head = left_.length() - pos;
+  const size_t tail = pattern.length() - head;
+  return tail <= right_.length() &&
+         memcmp(left_.data() + pos, pattern.data(), head) == 0 &&
+         memcmp(right_.data(), pattern.data() + head, tail) == 0;
+}
+
 }  // namespace zi
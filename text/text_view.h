@@ -33,9 +33,24 @@ class TextView {
 
   bool is_empty() const { return left_.is_empty() && right_.is_empty(); }
 
+  char At(size_t pos) const {
+    return pos < left_.length() ? left_.data()[pos]
+                                : right_.data()[pos - left_.length()];
+  }
+
+  // Returns std::string::npos if there is no match at or after |pos|. Matches
+  // can straddle the two halves.
+  size_t Find(char c, size_t pos = 0u) const;
+  size_t Find(const StringView& pattern, size_t pos = 0u) const;
+
+  // Returns the text in [begin, end), clamped to the text.
+  TextView Slice(size_t begin, size_t end) const;
+
   std::string ToString() const;
 
  private:
+  bool MatchesAcrossHalves(size_t pos, const StringView& pattern) const;
+
   StringView left_;
   StringView right_;
 };
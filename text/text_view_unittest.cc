@@ -67,5 +67,45 @@ TEST(TextView, StringConstructor) {
   EXPECT_EQ(text, view.ToString());
 }
 
+TEST(TextView, Find) {
+  std::string text1 = "one two\nth";
+  std::string text2 = "ree two";
+  StringView left(text1);
+  StringView right(text2);
+  TextView view(left, right);
+  EXPECT_EQ(7u, view.Find('\n'));
+  EXPECT_EQ(9u, view.Find('h', 9));
+  EXPECT_EQ(10u, view.Find('r'));
+  EXPECT_EQ(std::string::npos, view.Find('x'));
+  EXPECT_EQ(std::string::npos, view.Find('o', 18));
+
+  EXPECT_EQ(4u, view.Find(StringView(std::string("two"))));
+  EXPECT_EQ(14u, view.Find(StringView(std::string("two")), 5));
+  // Straddles the halves.
+  EXPECT_EQ(8u, view.Find(StringView(std::string("three"))));
+  EXPECT_EQ(9u, view.Find(StringView(std::string("hr")), 9));
+  EXPECT_EQ(std::string::npos, view.Find(StringView(std::string("three")), 9));
+  EXPECT_EQ(std::string::npos, view.Find(StringView(std::string("twos"))));
+  EXPECT_EQ(3u, view.Find(StringView(), 3));
+
+  TextView short_right(left, StringView(text2.data(), text2.data() + 1));
+  EXPECT_EQ(std::string::npos,
+            short_right.Find(StringView(std::string("three"))));
+}
+
+TEST(TextView, Slice) {
+  std::string text1 = "Hello, ";
+  std::string text2 = "world";
+  StringView left(text1);
+  StringView right(text2);
+  TextView view(left, right);
+  EXPECT_EQ("Hello", view.Slice(0, 5).ToString());
+  EXPECT_TRUE(view.Slice(2, 5).right().is_empty());
+  EXPECT_EQ("wor", view.Slice(7, 10).ToString());
+  EXPECT_EQ(", wo", view.Slice(5, 9).ToString());
+  EXPECT_EQ("ld", view.Slice(10, 100).ToString());
+  EXPECT_EQ("", view.Slice(9, 3).ToString());
+}
+
 }  // namespace
 }  // namespace zi
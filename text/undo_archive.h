@@ -0,0 +1,52 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+
+#include "zen/string_view.h"
+
+namespace zi {
+class TextBuffer;
+
+// The steps that came before the ones an UndoHistory holds in memory, e.g.,
+// the steps of earlier sessions kept on disk. The history undoes its own
+// steps before the archived ones and redoes the archived steps before its
+// own.
+class UndoArchive {
+ public:
+  // Reverts the newest archived step that is not undone, or reapplies the
+  // oldest one that is, and stores the offset where the step starts in
+  // |offset|. Returns false if there is no such step.
+  virtual bool Undo(TextBuffer* text, size_t* offset) = 0;
+  virtual bool Redo(TextBuffer* text, size_t* offset) = 0;
+
+  // Adds a record after the archived steps, which must all be redone. The
+  // views are only valid during the call.
+  virtual void Append(size_t offset,
+                      const StringView& deleted,
+                      const StringView& inserted,
+                      bool starts_step) = 0;
+  // Forgets the steps that are undone, e.g., because of a new edit.
+  virtual void DiscardRedo() = 0;
+  // Forgets every step, e.g., because the history forgot the steps that
+  // connected them to the text.
+  virtual void Clear() = 0;
+
+ protected:
+  virtual ~UndoArchive() = default;
+};
+
+}  // namespace zi
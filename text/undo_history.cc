@@ -0,0 +1,234 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/undo_history.h"
+
+#include <algorithm>
+
+#include "text/text_buffer.h"
+#include "zen/trace_event.h"
+
+namespace zi {
+namespace {
+
+// Enough for the edits of a typical session without reallocating.
+constexpr size_t kReservedRecordCount = 1024;
+constexpr size_t kReservedByteCount = 1 << 16;
+
+}  // namespace
+
+UndoHistory::UndoHistory(size_t budget) : budget_(budget) {
+  records_.reserve(kReservedRecordCount);
+  bytes_.reserve(std::min(budget, kReservedByteCount));
+}
+
+UndoHistory::~UndoHistory() = default;
+
+void UndoHistory::WillReplace(size_t offset,
+                              const TextView& deleted,
+                              const StringView& inserted) {
+  if (applying_)
+    return;
+  // A new edit makes the steps that were undone unreachable.
+  if (archive_ && !can_undo())
+    archive_->DiscardRedo();
+  if (can_redo()) {
+    bytes_.resize(records_[undo_end_].bytes_start);
+    records_.resize(undo_end_);
+    sealed_ = true;
+  }
+  const bool is_typing = deleted.is_empty() && inserted.length() == 1;
+  if (is_typing && !sealed_ && can_undo()) {
+    Record& last = records_.back();
+    if (last.deleted_length == 0 &&
+        last.offset + last.inserted_length == offset) {
+      bytes_.push_back(*inserted.begin());
+      ++last.inserted_length;
+      DropOldSteps();
+      return;
+    }
+  }
+  Record record;
+  record.offset = offset;
+  record.deleted_length = deleted.length();
+  record.inserted_length = inserted.length();
+  record.bytes_start = bytes_.size();
+  record.starts_step = group_depth_ == 0 || !group_started_;
+  group_started_ = group_depth_ > 0;
+  if (record.starts_step)
+    last_step_ = records_.size();
+  bytes_.append(deleted.left().begin(), deleted.left().length());
+  bytes_.append(deleted.right().begin(), deleted.right().length());
+  bytes_.append(inserted.begin(), inserted.length());
+  records_.push_back(record);
+  undo_end_ = records_.size();
+  sealed_ = !is_typing;
+  DropOldSteps();
+}
+
+void UndoHistory::BeginGroup() {
+  if (group_depth_++ == 0) {
+    group_started_ = false;
+    sealed_ = true;
+  }
+}
+
+void UndoHistory::EndGroup() {
+  if (group_depth_ > 0 && --group_depth_ == 0)
+    sealed_ = true;
+}
+
+bool UndoHistory::Undo(TextBuffer* text, size_t* offset) {
+  if (!can_undo()) {
+    if (!archive_)
+      return false;
+    applying_ = true;
+    const bool undone = archive_->Undo(text, offset);
+    applying_ = false;
+    group_started_ = false;
+    sealed_ = true;
+    return undone;
+  }
+  TRACE_EVENT0("text", "UndoHistory::Undo");
+  applying_ = true;
+  size_t index = undo_end_;
+  do {
+    const Record& record = records_[--index];
+    Apply(text, record.offset, record.inserted_length,
+          &bytes_[record.bytes_start], record.deleted_length);
+  } while (index > first_ && !records_[index].starts_step);
+  applying_ = false;
+  undo_end_ = index;
+  *offset = records_[index].offset;
+  // Later edits start a step of their own, even within a group.
+  group_started_ = false;
+  sealed_ = true;
+  return true;
+}
+
+bool UndoHistory::Redo(TextBuffer* text, size_t* offset) {
+  if (archive_ && !can_undo()) {
+    applying_ = true;
+    const bool redone = archive_->Redo(text, offset);
+    applying_ = false;
+    group_started_ = false;
+    sealed_ = true;
+    if (redone)
+      return true;
+  }
+  if (!can_redo())
+    return false;
+  TRACE_EVENT0("text", "UndoHistory::Redo");
+  applying_ = true;
+  *offset = records_[undo_end_].offset;
+  size_t index = undo_end_;
+  do {
+    const Record& record = records_[index++];
+    Apply(text, record.offset, record.deleted_length,
+          &bytes_[record.bytes_start + record.deleted_length],
+          record.inserted_length);
+  } while (index < records_.size() && !records_[index].starts_step);
+  applying_ = false;
+  undo_end_ = index;
+  group_started_ = false;
+  sealed_ = true;
+  return true;
+}
+
+void UndoHistory::ArchiveSteps() {
+  if (!archive_)
+    return;
+  TRACE_EVENT0("text", "UndoHistory::ArchiveSteps");
+  if (!can_undo()) {
+    archive_->DiscardRedo();
+    records_.resize(undo_end_);
+    bytes_.resize(first_byte_);
+  }
+  for (size_t i = first_; i < undo_end_; ++i) {
+    const Record& record = records_[i];
+    const char* deleted = &bytes_[record.bytes_start];
+    const char* inserted = deleted + record.deleted_length;
+    // A step never spans the archive and the memory.
+    archive_->Append(record.offset,
+                     StringView(deleted, inserted),
+                     StringView(inserted, inserted + record.inserted_length),
+                     record.starts_step || i == first_);
+  }
+  const size_t kept_byte =
+      can_redo() ? records_[undo_end_].bytes_start : bytes_.size();
+  records_.erase(records_.begin(), records_.begin() + undo_end_);
+  for (Record& record : records_)
+    record.bytes_start -= kept_byte;
+  bytes_.erase(0, kept_byte);
+  last_step_ = last_step_ > undo_end_ ? last_step_ - undo_end_ : 0;
+  first_ = 0;
+  first_byte_ = 0;
+  undo_end_ = 0;
+  group_started_ = false;
+  sealed_ = true;
+}
+
+void UndoHistory::Clear() {
+  records_.clear();
+  bytes_.clear();
+  first_ = 0;
+  last_step_ = 0;
+  first_byte_ = 0;
+  undo_end_ = 0;
+  group_started_ = false;
+  sealed_ = true;
+}
+
+void UndoHistory::Apply(TextBuffer* text,
+                        size_t offset,
+                        size_t delete_length,
+                        const char* insert_begin,
+                        size_t insert_length) {
+  if (delete_length)
+    text->DeleteRange(TextBufferRange(offset, offset + delete_length));
+  if (insert_length) {
+    text->InsertText(TextPosition(offset),
+                     StringView(insert_begin, insert_begin + insert_length));
+  }
+}
+
+// Drops the oldest steps until the history fits its budget, but always keeps
+// the latest step.
+void UndoHistory::DropOldSteps() {
+  while (size() > budget_ && last_step_ > first_) {
+    size_t next = first_ + 1;
+    while (next < undo_end_ && !records_[next].starts_step)
+      ++next;
+    if (next >= undo_end_)
+      break;
+    // The archived steps led up to the step that is dropped.
+    if (archive_)
+      archive_->Clear();
+    first_ = next;
+    first_byte_ = records_[first_].bytes_start;
+  }
+  // Reclaim the storage of the dropped steps once they take half of it.
+  if (first_ == 0 || first_ < records_.size() / 2)
+    return;
+  records_.erase(records_.begin(), records_.begin() + first_);
+  for (Record& record : records_)
+    record.bytes_start -= first_byte_;
+  bytes_.erase(0, first_byte_);
+  undo_end_ -= first_;
+  last_step_ -= first_;
+  first_ = 0;
+  first_byte_ = 0;
+}
+
+}  // namespace zi
@@ -0,0 +1,126 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "text/text_buffer_observer.h"
+#include "text/undo_archive.h"
+#include "zen/macros.h"
+
+namespace zi {
+class TextBuffer;
+
+// Records the edits to a TextBuffer as deltas so that they can be undone and
+// redone. Each record keeps the offset of an edit with the text it deleted
+// and the text it inserted, so undoing or redoing an edit costs as much as
+// the edit did, however large the buffer is.
+//
+// Consecutive characters typed one after another coalesce into one record,
+// and the records between BeginGroup and EndGroup (e.g., an insert session or
+// a macro replay) undo as one step. Outside a group, each record is a step of
+// its own. Once the history outgrows its budget, the oldest steps are
+// dropped. Steps can also be moved out of memory into an UndoArchive, which
+// keeps undoing past them possible.
+class UndoHistory : public TextBufferObserver {
+ public:
+  explicit UndoHistory(size_t budget);
+  ~UndoHistory() override;
+
+  // TextBufferObserver:
+  void WillReplace(size_t offset,
+                   const TextView& deleted,
+                   const StringView& inserted) override;
+
+  // Groups nest. Only the outermost group counts.
+  void BeginGroup();
+  void EndGroup();
+  // Keeps the next edit from coalescing with the last one.
+  void Seal() { sealed_ = true; }
+
+  // Reverts the last step, or reapplies the last step undone, and stores the
+  // offset where the step starts in |offset|. Returns false if there is no
+  // such step.
+  bool Undo(TextBuffer* text, size_t* offset);
+  bool Redo(TextBuffer* text, size_t* offset);
+
+  // |archive| must outlive the history or be replaced first.
+  void SetArchive(UndoArchive* archive) { archive_ = archive; }
+  // Moves the steps that can be undone into the archive. Any steps undone in
+  // the archive are forgotten, along with the ones in memory after them.
+  void ArchiveSteps();
+
+  // Whether there are steps in memory to undo.
+  bool can_undo() const { return undo_end_ > first_; }
+  bool can_redo() const { return undo_end_ < records_.size(); }
+
+  // The memory the steps that are kept take.
+  size_t size() const {
+    return bytes_.size() - first_byte_ +
+           (records_.size() - first_) * sizeof(Record);
+  }
+  size_t budget() const { return budget_; }
+
+  // Forgets the steps in memory but not the archive.
+  void Clear();
+
+ private:
+  struct Record {
+    size_t offset;
+    size_t deleted_length;
+    size_t inserted_length;
+    // Where the deleted text, followed by the inserted text, starts in
+    // |bytes_|.
+    size_t bytes_start;
+    // Whether this record is the first of a step.
+    bool starts_step;
+  };
+
+  void Apply(TextBuffer* text,
+             size_t offset,
+             size_t delete_length,
+             const char* insert_begin,
+             size_t insert_length);
+  void DropOldSteps();
+
+  const size_t budget_;
+  UndoArchive* archive_ = nullptr;
+
+  // The records and their text, oldest first. The records from |first_| to
+  // |undo_end_| can be undone and the ones after |undo_end_| redone. The
+  // storage is reserved up front and reused, so typing does not allocate.
+  std::vector<Record> records_;
+  std::string bytes_;
+  size_t first_ = 0;
+  size_t first_byte_ = 0;
+  size_t undo_end_ = 0;
+  // The record that starts the newest step. A step that is over the budget
+  // by itself cannot be dropped, and this saves looking through it for the
+  // next step on every edit.
+  size_t last_step_ = 0;
+
+  int group_depth_ = 0;
+  bool group_started_ = false;
+  bool sealed_ = true;
+  // Set while undoing or redoing, so that those edits are not recorded.
+  bool applying_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(UndoHistory);
+};
+
+}  // namespace zi
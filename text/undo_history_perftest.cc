@@ -0,0 +1,58 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/undo_history.h"
+
+#include <string>
+#include <vector>
+
+#include "text/text_buffer.h"
+#include "zen/benchmark.h"
+
+namespace zi {
+namespace {
+
+constexpr size_t kTextSize = 1 << 24;
+
+// Undoes and redoes a paste of |arg| bytes into the middle of a large buffer.
+void UndoHistory_UndoPaste(BenchmarkState* state) {
+  TextBuffer text(std::vector<char>(kTextSize, 'a'));
+  UndoHistory history(1 << 30);
+  text.AddObserver(&history);
+  text.InsertText(TextPosition(kTextSize / 2), std::string(state->arg(), 'x'));
+  size_t offset = 0;
+  while (state->KeepRunning()) {
+    history.Undo(&text, &offset);
+    history.Redo(&text, &offset);
+  }
+  state->SetBytesProcessed(state->iterations() * state->arg());
+  text.RemoveObserver(&history);
+}
+BENCHMARK(UndoHistory_UndoPaste, 64, 4096, 1 << 20);
+
+// Types characters one after another, which coalesce into one record.
+void UndoHistory_Typing(BenchmarkState* state) {
+  TextBuffer text(std::vector<char>(1 << 20, 'a'));
+  UndoHistory history(1 << 30);
+  text.AddObserver(&history);
+  size_t position = text.size() / 2;
+  while (state->KeepRunning())
+    text.InsertCharacter(TextPosition(position++), 'x');
+  state->SetItemsProcessed(state->iterations());
+  text.RemoveObserver(&history);
+}
+BENCHMARK(UndoHistory_Typing);
+
+}  // namespace
+}  // namespace zi
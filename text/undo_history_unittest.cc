@@ -0,0 +1,150 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "text/undo_history.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "text/text_buffer.h"
+
+namespace zi {
+namespace {
+
+std::vector<char> MakeText(const std::string& text) {
+  return std::vector<char>(text.begin(), text.end());
+}
+
+TEST(UndoHistory, UndoAndRedo) {
+  TextBuffer text(MakeText("Hello, world"));
+  UndoHistory history(1 << 20);
+  text.AddObserver(&history);
+  EXPECT_FALSE(history.can_undo());
+
+  text.InsertText(TextPosition(5), std::string(" there"));
+  text.DeleteRange(TextBufferRange(0, 6));
+  EXPECT_EQ("there, world", text.ToString());
+
+  size_t offset = 42;
+  EXPECT_TRUE(history.Undo(&text, &offset));
+  EXPECT_EQ("Hello there, world", text.ToString());
+  EXPECT_EQ(0u, offset);
+  EXPECT_TRUE(history.Undo(&text, &offset));
+  EXPECT_EQ("Hello, world", text.ToString());
+  EXPECT_EQ(5u, offset);
+  EXPECT_FALSE(history.Undo(&text, &offset));
+
+  EXPECT_TRUE(history.Redo(&text, &offset));
+  EXPECT_EQ("Hello there, world", text.ToString());
+  EXPECT_TRUE(history.Redo(&text, &offset));
+  EXPECT_EQ("there, world", text.ToString());
+  EXPECT_FALSE(history.Redo(&text, &offset));
+
+  // A new edit discards the steps that were undone.
+  EXPECT_TRUE(history.Undo(&text, &offset));
+  text.InsertCharacter(TextPosition(0), '!');
+  EXPECT_FALSE(history.can_redo());
+  EXPECT_TRUE(history.Undo(&text, &offset));
+  EXPECT_TRUE(history.Undo(&text, &offset));
+  EXPECT_EQ("Hello, world", text.ToString());
+
+  text.RemoveObserver(&history);
+}
+
+TEST(UndoHistory, CoalescesTyping) {
+  TextBuffer text(MakeText("ab"));
+  UndoHistory history(1 << 20);
+  text.AddObserver(&history);
+
+  for (char c : std::string("xyz"))
+    text.InsertCharacter(TextPosition(1 + c - 'x'), c);
+  // Typing somewhere else starts a new step.
+  text.InsertCharacter(TextPosition(0), '>');
+  text.InsertCharacter(TextPosition(1), '>');
+  // So does typing after the history is sealed.
+  history.Seal();
+  text.InsertCharacter(TextPosition(2), '>');
+  EXPECT_EQ(">>>axyzb", text.ToString());
+
+  size_t offset = 0;
+  history.Undo(&text, &offset);
+  EXPECT_EQ(">>axyzb", text.ToString());
+  history.Undo(&text, &offset);
+  EXPECT_EQ("axyzb", text.ToString());
+  history.Undo(&text, &offset);
+  EXPECT_EQ("ab", text.ToString());
+  EXPECT_FALSE(history.can_undo());
+
+  text.RemoveObserver(&history);
+}
+
+TEST(UndoHistory, Groups) {
+  TextBuffer text(MakeText("abc"));
+  UndoHistory history(1 << 20);
+  text.AddObserver(&history);
+
+  history.BeginGroup();
+  text.InsertCharacter(TextPosition(3), 'd');
+  history.BeginGroup();
+  text.DeleteRange(TextBufferRange(0, 1));
+  history.EndGroup();
+  text.InsertText(TextPosition(0), std::string("xy"));
+  history.EndGroup();
+  text.InsertCharacter(TextPosition(0), 'z');
+  EXPECT_EQ("zxybcd", text.ToString());
+
+  size_t offset = 0;
+  history.Undo(&text, &offset);
+  EXPECT_EQ("xybcd", text.ToString());
+  history.Undo(&text, &offset);
+  EXPECT_EQ("abc", text.ToString());
+  EXPECT_EQ(3u, offset);
+  EXPECT_FALSE(history.can_undo());
+  history.Redo(&text, &offset);
+  EXPECT_EQ("xybcd", text.ToString());
+  EXPECT_EQ(3u, offset);
+
+  text.RemoveObserver(&history);
+}
+
+TEST(UndoHistory, DropsOldStepsOverBudget) {
+  TextBuffer text;
+  UndoHistory history(4096);
+  text.AddObserver(&history);
+
+  const std::string line(100, 'x');
+  for (int i = 0; i < 100; ++i)
+    text.InsertText(TextPosition(text.size()), line);
+  EXPECT_LE(history.size(), history.budget());
+
+  size_t offset = 0;
+  size_t steps = 0;
+  while (history.Undo(&text, &offset))
+    ++steps;
+  EXPECT_GT(steps, 10u);
+  EXPECT_LT(steps, 100u);
+  EXPECT_EQ((100 - steps) * line.size(), text.size());
+
+  // The latest step is kept even if it is over budget on its own.
+  history.Clear();
+  text.InsertText(TextPosition(0), std::string(8192, 'y'));
+  EXPECT_TRUE(history.Undo(&text, &offset));
+  EXPECT_EQ((100 - steps) * line.size(), text.size());
+
+  text.RemoveObserver(&history);
+}
+
+}  // namespace
+}  // namespace zi
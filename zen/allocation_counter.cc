@@ -0,0 +1,42 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "zen/allocation_counter.h"
+
+#include <new>
+
+namespace zi {
+namespace {
+
+thread_local uint64_t g_allocation_count = 0;
+
+}  // namespace
+
+uint64_t GetThreadAllocationCount() {
+  return g_allocation_count;
+}
+
+bool IsAllocationCountingEnabled() {
+  // Calling the allocation function directly, rather than through a
+  // new-expression, keeps the compiler from eliding the allocation.
+  const uint64_t before = g_allocation_count;
+  ::operator delete(::operator new(1));
+  return g_allocation_count != before;
+}
+
+void CountAllocation() {
+  ++g_allocation_count;
+}
+
+}  // namespace zi
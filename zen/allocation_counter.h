@@ -0,0 +1,41 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stdint.h>
+
+namespace zi {
+
+// Counts the heap allocations that the current thread makes with operator new.
+// The count only moves in binaries that link //zen:allocation_hooks, which
+// replaces the global operator new; elsewhere it stays at zero.
+uint64_t GetThreadAllocationCount();
+bool IsAllocationCountingEnabled();
+
+// Called by the replacement operator new.
+void CountAllocation();
+
+// The number of allocations the current thread made since construction.
+class ScopedAllocationCounter {
+ public:
+  ScopedAllocationCounter() : start_(GetThreadAllocationCount()) {}
+
+  uint64_t count() const { return GetThreadAllocationCount() - start_; }
+
+ private:
+  uint64_t start_;
+};
+
+}  // namespace zi
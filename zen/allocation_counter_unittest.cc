@@ -0,0 +1,41 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "zen/allocation_counter.h"
+
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+TEST(AllocationCounter, CountsThisThread) {
+  ASSERT_TRUE(IsAllocationCountingEnabled());
+  ScopedAllocationCounter counter;
+  std::string text(100, 'a');
+  EXPECT_EQ(1u, counter.count());
+
+  std::thread thread([]() { std::string other(100, 'b'); });
+  const uint64_t before_join = counter.count();
+  thread.join();
+  // Allocations on the other thread are not ours, but starting the thread
+  // might allocate here.
+  EXPECT_EQ(before_join, counter.count());
+  EXPECT_EQ('a', text[50]);
+}
+
+}  // namespace
+}  // namespace zi
@@ -0,0 +1,241 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "zen/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace zi {
+namespace {
+
+constexpr int64_t kMaxIterations = 1000000000;
+
+struct Benchmark {
+  std::string name;
+  BenchmarkFunction function;
+  std::vector<size_t> args;
+};
+
+struct BenchmarkResult {
+  std::string name;
+  int64_t iterations = 0;
+  double nanoseconds_per_iteration = 0;
+  double bytes_per_second = 0;
+  double items_per_second = 0;
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+struct BenchmarkOptions {
+  std::string filter;
+  double min_time = 0.5;
+  bool json = false;
+  std::string out_path;
+};
+
+std::vector<Benchmark>& GetBenchmarks() {
+  static std::vector<Benchmark>* benchmarks = new std::vector<Benchmark>();
+  return *benchmarks;
+}
+
+bool ParseFlag(const char* arg, const char* name, std::string* value) {
+  size_t length = strlen(name);
+  if (strncmp(arg, name, length) != 0 || arg[length] != '=')
+    return false;
+  *value = arg + length + 1;
+  return true;
+}
+
+bool ParseOptions(int argc, char** argv, BenchmarkOptions* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string value;
+    if (ParseFlag(argv[i], "--benchmark_filter", &value)) {
+      options->filter = value;
+    } else if (ParseFlag(argv[i], "--benchmark_min_time", &value)) {
+      options->min_time = atof(value.c_str());
+    } else if (ParseFlag(argv[i], "--benchmark_format", &value)) {
+      if (value != "console" && value != "json")
+        return false;
+      options->json = value == "json";
+    } else if (ParseFlag(argv[i], "--benchmark_out", &value)) {
+      options->out_path = value;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+BenchmarkResult Run(const std::string& name,
+                    BenchmarkFunction function,
+                    size_t arg,
+                    double min_time) {
+  BenchmarkResult result;
+  result.name = name;
+  for (int64_t iterations = 1;;) {
+    BenchmarkState state(arg, iterations);
+    function(&state);
+    const double seconds = state.elapsed_seconds();
+    if (seconds >= min_time || iterations >= kMaxIterations) {
+      result.iterations = iterations;
+      result.nanoseconds_per_iteration = seconds * 1e9 / iterations;
+      if (seconds > 0) {
+        result.bytes_per_second = state.bytes_processed() / seconds;
+        result.items_per_second = state.items_processed() / seconds;
+      }
+      result.counters = state.counters();
+      return result;
+    }
+    // Aim a little past the minimum time so we usually need one more round.
+    double multiplier = seconds > 0 ? min_time * 1.4 / seconds : 10;
+    multiplier = std::min(std::max(multiplier, 2.0), 10.0);
+    iterations = std::min(
+        kMaxIterations, static_cast<int64_t>(iterations * multiplier));
+  }
+}
+
+void PrintConsoleResult(FILE* file, const BenchmarkResult& result) {
+  fprintf(file, "%-48s %14.1f ns %12lld", result.name.c_str(),
+          result.nanoseconds_per_iteration,
+          static_cast<long long>(result.iterations));
+  if (result.bytes_per_second)
+    fprintf(file, " %10.1f MB/s", result.bytes_per_second / (1 << 20));
+  if (result.items_per_second)
+    fprintf(file, " %12.0f items/s", result.items_per_second);
+  for (const auto& counter : result.counters)
+    fprintf(file, " %s=%.1f", counter.first.c_str(), counter.second);
+  fprintf(file, "\n");
+}
+
+void PrintJSONResults(FILE* file, const std::vector<BenchmarkResult>& results) {
+  char date[64];
+  time_t now = time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+  fprintf(file, "{\n  \"context\": {\n");
+  fprintf(file, "    \"date\": \"%s\",\n", date);
+  fprintf(file, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+#ifdef NDEBUG
+  fprintf(file, "    \"library_build_type\": \"release\"\n");
+#else
+  fprintf(file, "    \"library_build_type\": \"debug\"\n");
+#endif
+  fprintf(file, "  },\n  \"benchmarks\": [");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchmarkResult& result = results[i];
+    fprintf(file, "%s\n    {\n", i ? "," : "");
+    fprintf(file, "      \"name\": \"%s\",\n", result.name.c_str());
+    fprintf(file, "      \"run_type\": \"iteration\",\n");
+    fprintf(file, "      \"iterations\": %lld,\n",
+            static_cast<long long>(result.iterations));
+    fprintf(file, "      \"real_time\": %.3f,\n",
+            result.nanoseconds_per_iteration);
+    if (result.bytes_per_second)
+      fprintf(file, "      \"bytes_per_second\": %.0f,\n",
+              result.bytes_per_second);
+    if (result.items_per_second)
+      fprintf(file, "      \"items_per_second\": %.0f,\n",
+              result.items_per_second);
+    for (const auto& counter : result.counters)
+      fprintf(file, "      \"%s\": %f,\n", counter.first.c_str(),
+              counter.second);
+    fprintf(file, "      \"time_unit\": \"ns\"\n    }");
+  }
+  fprintf(file, "\n  ]\n}\n");
+}
+
+}  // namespace
+
+BenchmarkState::BenchmarkState(size_t arg, int64_t iterations)
+    : arg_(arg),
+      iterations_(iterations),
+      remaining_(iterations),
+      elapsed_(0) {}
+
+BenchmarkState::~BenchmarkState() = default;
+
+void BenchmarkState::PauseTiming() {
+  if (!running_)
+    return;
+  elapsed_ += Clock::now() - start_;
+  running_ = false;
+}
+
+void BenchmarkState::ResumeTiming() {
+  if (running_)
+    return;
+  running_ = true;
+  start_ = Clock::now();
+}
+
+void BenchmarkState::SetCounter(const std::string& name, double value) {
+  counters_.push_back(std::make_pair(name, value));
+}
+
+BenchmarkRegistration::BenchmarkRegistration(
+    const char* name,
+    BenchmarkFunction function,
+    std::initializer_list<size_t> args) {
+  GetBenchmarks().push_back(Benchmark{name, function, args});
+}
+
+int RunBenchmarks(int argc, char** argv) {
+  BenchmarkOptions options;
+  if (!ParseOptions(argc, argv, &options)) {
+    fprintf(stderr,
+            "usage: %s [--benchmark_filter=<substring>] "
+            "[--benchmark_min_time=<seconds>] "
+            "[--benchmark_format=console|json] [--benchmark_out=<path>]\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::vector<BenchmarkResult> results;
+  for (const Benchmark& benchmark : GetBenchmarks()) {
+    std::vector<size_t> args = benchmark.args;
+    const bool has_args = !args.empty();
+    if (!has_args)
+      args.push_back(0);
+    for (size_t arg : args) {
+      std::string name = benchmark.name;
+      if (has_args)
+        name += "/" + std::to_string(arg);
+      if (name.find(options.filter) == std::string::npos)
+        continue;
+      results.push_back(
+          Run(name, benchmark.function, arg, options.min_time));
+      if (!options.json)
+        PrintConsoleResult(stdout, results.back());
+    }
+  }
+
+  if (options.json)
+    PrintJSONResults(stdout, results);
+  if (!options.out_path.empty()) {
+    FILE* file = fopen(options.out_path.c_str(), "w");
+    if (!file) {
+      fprintf(stderr, "error: Unable to open %s.\n", options.out_path.c_str());
+      return 1;
+    }
+    PrintJSONResults(file, results);
+    fclose(file);
+  }
+  return 0;
+}
+
+}  // namespace zi
@@ -0,0 +1,119 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zen/macros.h"
+
+namespace zi {
+
+// A small benchmark harness modeled on Google Benchmark. A benchmark is a
+// function that runs its body while |state->KeepRunning()| returns true:
+//
+//   void TextBuffer_Find(BenchmarkState* state) {
+//     TextBuffer text = ...;
+//     while (state->KeepRunning())
+//       DoNotOptimize(text.Find('x'));
+//   }
+//   BENCHMARK(TextBuffer_Find, 1 << 10, 1 << 20);
+//
+// The runner calls the function once per argument with increasing iteration
+// counts until the timed region runs for the minimum time, then reports the
+// time per iteration. Results are printed to the console or as JSON in the
+// same shape Google Benchmark uses, so its tools can compare runs.
+class BenchmarkState {
+ public:
+  BenchmarkState(size_t arg, int64_t iterations);
+  ~BenchmarkState();
+
+  size_t arg() const { return arg_; }
+  int64_t iterations() const { return iterations_; }
+
+  bool KeepRunning() {
+    if (!started_) {
+      started_ = true;
+      ResumeTiming();
+    }
+    if (remaining_-- > 0)
+      return true;
+    PauseTiming();
+    return false;
+  }
+
+  // Excludes the work between these calls from the measurement.
+  void PauseTiming();
+  void ResumeTiming();
+
+  void SetBytesProcessed(int64_t bytes) { bytes_processed_ = bytes; }
+  void SetItemsProcessed(int64_t items) { items_processed_ = items; }
+  // Reports an additional named value, such as bytes per frame.
+  void SetCounter(const std::string& name, double value);
+
+  double elapsed_seconds() const { return elapsed_.count(); }
+  int64_t bytes_processed() const { return bytes_processed_; }
+  int64_t items_processed() const { return items_processed_; }
+  const std::vector<std::pair<std::string, double>>& counters() const {
+    return counters_;
+  }
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  const size_t arg_;
+  const int64_t iterations_;
+  int64_t remaining_;
+  bool started_ = false;
+  bool running_ = false;
+  Clock::time_point start_;
+  std::chrono::duration<double> elapsed_;
+  int64_t bytes_processed_ = 0;
+  int64_t items_processed_ = 0;
+  std::vector<std::pair<std::string, double>> counters_;
+
+  DISALLOW_COPY_AND_ASSIGN(BenchmarkState);
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState* state);
+
+class BenchmarkRegistration {
+ public:
+  BenchmarkRegistration(const char* name,
+                        BenchmarkFunction function,
+                        std::initializer_list<size_t> args);
+};
+
+// Runs the registered benchmarks as directed by the command line. Returns the
+// process exit code.
+int RunBenchmarks(int argc, char** argv);
+
+// Keeps the compiler from discarding a value that is otherwise unused.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}  // namespace zi
+
+#define BENCHMARK(function, ...)                      \
+  static ::zi::BenchmarkRegistration function##_registration( \
+      #function, function, {__VA_ARGS__})
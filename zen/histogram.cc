@@ -0,0 +1,95 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "zen/histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace zi {
+namespace {
+
+// Values below kSubBucketCount get a bucket each. Above that, each power of two
+// is split into kSubBucketHalfCount buckets of equal width.
+constexpr int kSubBucketBits = 5;
+constexpr size_t kSubBucketCount = 1 << kSubBucketBits;
+constexpr size_t kSubBucketHalfCount = kSubBucketCount / 2;
+constexpr size_t kBucketCount =
+    kSubBucketCount + (64 - kSubBucketBits) * kSubBucketHalfCount;
+
+int HighestBit(uint64_t value) {
+  return 63 - __builtin_clzll(value);
+}
+
+}  // namespace
+
+Histogram::Histogram() : counts_(kBucketCount) {}
+
+Histogram::~Histogram() = default;
+
+void Histogram::Record(uint64_t value) {
+  ++counts_[GetIndex(value)];
+  min_ = count_ ? std::min(min_, value) : value;
+  max_ = std::max(max_, value);
+  ++count_;
+}
+
+void Histogram::Clear() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  count_ = 0;
+  min_ = 0;
+  max_ = 0;
+}
+
+uint64_t Histogram::ValueAtPercentile(double percentile) const {
+  if (!count_)
+    return 0;
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100 * count_));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    seen += counts_[i];
+    if (seen >= rank)
+      return std::min(GetHighestValue(i), max_);
+  }
+  return max_;
+}
+
+size_t Histogram::GetIndex(uint64_t value) {
+  if (value < kSubBucketCount)
+    return value;
+  const int shift = HighestBit(value) - (kSubBucketBits - 1);
+  const size_t sub_bucket = value >> shift;
+  return kSubBucketCount + (shift - 1) * kSubBucketHalfCount +
+         (sub_bucket - kSubBucketHalfCount);
+}
+
+uint64_t Histogram::GetLowestValue(size_t index) {
+  if (index < kSubBucketCount)
+    return index;
+  const size_t offset = index - kSubBucketCount;
+  const int shift = offset / kSubBucketHalfCount + 1;
+  const uint64_t sub_bucket =
+      offset % kSubBucketHalfCount + kSubBucketHalfCount;
+  return sub_bucket << shift;
+}
+
+uint64_t Histogram::GetHighestValue(size_t index) {
+  if (index + 1 == kBucketCount)
+    return UINT64_MAX;
+  return GetLowestValue(index + 1) - 1;
+}
+
+}  // namespace zi
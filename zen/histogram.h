@@ -0,0 +1,65 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace zi {
+
+// A histogram in the style of HdrHistogram. Values are grouped into buckets
+// whose width grows with the magnitude of the value, so every recorded value
+// is known to within about 6% regardless of range, and recording is O(1) with
+// a fixed amount of memory.
+class Histogram {
+ public:
+  Histogram();
+  ~Histogram();
+
+  void Record(uint64_t value);
+  void Clear();
+
+  uint64_t count() const { return count_; }
+  uint64_t min() const { return count_ ? min_ : 0; }
+  uint64_t max() const { return max_; }
+
+  // Returns the largest value that is equivalent to the value at |percentile|,
+  // which is between 0 and 100.
+  uint64_t ValueAtPercentile(double percentile) const;
+
+  // Calls |callback| with the range and count of each non-empty bucket in
+  // ascending order.
+  template <typename Callback>
+  void ForEachBucket(Callback callback) const {
+    for (size_t i = 0; i < counts_.size(); ++i) {
+      if (counts_[i])
+        callback(GetLowestValue(i), GetHighestValue(i), counts_[i]);
+    }
+  }
+
+ private:
+  static size_t GetIndex(uint64_t value);
+  static uint64_t GetLowestValue(size_t index);
+  static uint64_t GetHighestValue(size_t index);
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  uint64_t min_ = 0;
+  uint64_t max_ = 0;
+};
+
+}  // namespace zi
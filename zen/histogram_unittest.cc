@@ -0,0 +1,76 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "zen/histogram.h"
+
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+TEST(Histogram, Empty) {
+  Histogram histogram;
+  EXPECT_EQ(0u, histogram.count());
+  EXPECT_EQ(0u, histogram.min());
+  EXPECT_EQ(0u, histogram.max());
+  EXPECT_EQ(0u, histogram.ValueAtPercentile(50));
+}
+
+TEST(Histogram, SmallValuesAreExact) {
+  Histogram histogram;
+  for (uint64_t i = 1; i <= 20; ++i)
+    histogram.Record(i);
+  EXPECT_EQ(20u, histogram.count());
+  EXPECT_EQ(1u, histogram.min());
+  EXPECT_EQ(20u, histogram.max());
+  EXPECT_EQ(10u, histogram.ValueAtPercentile(50));
+  EXPECT_EQ(19u, histogram.ValueAtPercentile(95));
+  EXPECT_EQ(20u, histogram.ValueAtPercentile(100));
+}
+
+TEST(Histogram, Precision) {
+  Histogram histogram;
+  for (uint64_t i = 1; i <= 1000000; ++i)
+    histogram.Record(i * 1000);
+  const uint64_t p50 = histogram.ValueAtPercentile(50);
+  const uint64_t p99 = histogram.ValueAtPercentile(99);
+  EXPECT_GE(p50, 500000000u);
+  EXPECT_LE(p50, 500000000u * 1.07);
+  EXPECT_GE(p99, 990000000u);
+  EXPECT_LE(p99, 990000000u * 1.07);
+  EXPECT_EQ(1000000000u, histogram.ValueAtPercentile(100));
+}
+
+TEST(Histogram, Buckets) {
+  Histogram histogram;
+  histogram.Record(0);
+  histogram.Record(33);
+  histogram.Record(1000);
+  histogram.Record(UINT64_MAX);
+  uint64_t previous_high = 0;
+  uint64_t total = 0;
+  histogram.ForEachBucket([&](uint64_t low, uint64_t high, uint64_t count) {
+    EXPECT_LE(low, high);
+    EXPECT_TRUE(total == 0 || low > previous_high);
+    previous_high = high;
+    total += count;
+  });
+  EXPECT_EQ(4u, total);
+  EXPECT_EQ(UINT64_MAX, previous_high);
+  histogram.Clear();
+  EXPECT_EQ(0u, histogram.count());
+}
+
+}  // namespace
+}  // namespace zi
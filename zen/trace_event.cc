@@ -0,0 +1,179 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "zen/trace_event.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace zi {
+namespace {
+
+std::atomic<uint64_t> g_next_log_id(1);
+
+}  // namespace
+
+class TraceLog::ThreadBuffer {
+ public:
+  ThreadBuffer(std::thread::id thread, int thread_id, size_t capacity)
+      : thread_(thread), thread_id_(thread_id), events_(capacity) {}
+
+  std::thread::id thread() const { return thread_; }
+  int thread_id() const { return thread_id_; }
+
+  void Add(const TraceEvent& event) {
+    std::lock_guard<std::mutex> guard(lock_);
+    events_[next_ % events_.size()] = event;
+    ++next_;
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return std::min(next_, events_.size());
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> guard(lock_);
+    next_ = 0;
+  }
+
+  // Calls |callback| with the retained events from oldest to newest.
+  template <typename Callback>
+  void ForEach(Callback callback) const {
+    std::lock_guard<std::mutex> guard(lock_);
+    const size_t count = std::min(next_, events_.size());
+    for (size_t i = next_ - count; i < next_; ++i)
+      callback(events_[i % events_.size()]);
+  }
+
+ private:
+  const std::thread::id thread_;
+  const int thread_id_;
+  // Only contended while the log is being read.
+  mutable std::mutex lock_;
+  std::vector<TraceEvent> events_;
+  size_t next_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadBuffer);
+};
+
+constexpr size_t TraceLog::kDefaultEventsPerThread;
+
+TraceLog::TraceLog(size_t events_per_thread)
+    : id_(g_next_log_id++),
+      events_per_thread_(std::max<size_t>(events_per_thread, 1)),
+      epoch_(std::chrono::steady_clock::now()),
+      enabled_(false) {}
+
+TraceLog::~TraceLog() = default;
+
+TraceLog* TraceLog::GetInstance() {
+  static TraceLog* instance = new TraceLog();
+  return instance;
+}
+
+void TraceLog::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t TraceLog::Now() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - epoch_)
+      .count();
+}
+
+void TraceLog::AddEvent(const char* category,
+                        const char* name,
+                        uint64_t start,
+                        uint64_t end) {
+  TraceEvent event;
+  event.category = category;
+  event.name = name;
+  event.start = start;
+  event.duration = end - start;
+  GetThreadBuffer()->Add(event);
+}
+
+TraceLog::ThreadBuffer* TraceLog::GetThreadBuffer() {
+  // Remember the buffer of the log this thread used last so that the common
+  // case of a single log does not take |lock_|.
+  static thread_local uint64_t cached_log_id = 0;
+  static thread_local ThreadBuffer* cached_buffer = nullptr;
+  if (cached_log_id == id_)
+    return cached_buffer;
+  const std::thread::id thread = std::this_thread::get_id();
+  std::lock_guard<std::mutex> guard(lock_);
+  ThreadBuffer* result = nullptr;
+  for (const auto& buffer : buffers_) {
+    if (buffer->thread() == thread)
+      result = buffer.get();
+  }
+  if (!result) {
+    const int thread_id = static_cast<int>(buffers_.size()) + 1;
+    buffers_.emplace_back(
+        new ThreadBuffer(thread, thread_id, events_per_thread_));
+    result = buffers_.back().get();
+  }
+  cached_log_id = id_;
+  cached_buffer = result;
+  return result;
+}
+
+size_t TraceLog::GetEventCount() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  size_t count = 0;
+  for (const auto& buffer : buffers_)
+    count += buffer->size();
+  return count;
+}
+
+void TraceLog::Clear() {
+  std::lock_guard<std::mutex> guard(lock_);
+  for (const auto& buffer : buffers_)
+    buffer->Clear();
+}
+
+std::string TraceLog::GetJSON() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  std::string result = "{\"traceEvents\":[";
+  bool first = true;
+  char line[256];
+  for (const auto& buffer : buffers_) {
+    const int thread_id = buffer->thread_id();
+    buffer->ForEach([&](const TraceEvent& event) {
+      snprintf(line, sizeof(line),
+               "%s\n{\"cat\":\"%s\",\"name\":\"%s\",\"ph\":\"X\","
+               "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+               first ? "" : ",", event.category, event.name,
+               event.start / 1e3, event.duration / 1e3, thread_id);
+      result += line;
+      first = false;
+    });
+  }
+  result += "\n],\"displayTimeUnit\":\"ns\"}\n";
+  return result;
+}
+
+bool TraceLog::WriteToFile(const std::string& path) const {
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file)
+    return false;
+  const std::string json = GetJSON();
+  const bool success = fwrite(json.data(), 1, json.size(), file) == json.size();
+  return fclose(file) == 0 && success;
+}
+
+}  // namespace zi
@@ -0,0 +1,135 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "zen/macros.h"
+
+// Scoped trace events in the Chrome trace-event format. The macros compile to
+// nothing unless ZI_ENABLE_TRACING is defined (set zi_enable_tracing = true in
+// the GN args) and record nothing until the TraceLog is enabled at runtime.
+//
+// |category| and |name| must be string literals because only the pointers are
+// stored.
+#if defined(ZI_ENABLE_TRACING)
+#define TRACE_EVENT0(category, name) \
+  ::zi::ScopedTraceEvent ZI_TRACE_UID(trace_event_)(category, name)
+#else
+#define TRACE_EVENT0(category, name) \
+  do {                               \
+  } while (0)
+#endif
+
+#define ZI_TRACE_UID(prefix) ZI_TRACE_UID2(prefix, __LINE__)
+#define ZI_TRACE_UID2(prefix, line) ZI_TRACE_UID3(prefix, line)
+#define ZI_TRACE_UID3(prefix, line) prefix##line
+
+namespace zi {
+
+#if defined(ZI_ENABLE_TRACING)
+constexpr bool kTraceEventsCompiledIn = true;
+#else
+constexpr bool kTraceEventsCompiledIn = false;
+#endif
+
+struct TraceEvent {
+  const char* category;
+  const char* name;
+  // In nanoseconds since the TraceLog was created.
+  uint64_t start;
+  uint64_t duration;
+};
+
+// Collects trace events into a fixed-size ring buffer per thread so that
+// recording never allocates or contends after a thread's first event and a
+// long session keeps only its most recent events.
+class TraceLog {
+ public:
+  static constexpr size_t kDefaultEventsPerThread = 1 << 15;
+
+  explicit TraceLog(size_t events_per_thread = kDefaultEventsPerThread);
+  ~TraceLog();
+
+  static TraceLog* GetInstance();
+
+  void SetEnabled(bool enabled);
+  bool is_enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  uint64_t Now() const;
+  void AddEvent(const char* category,
+                const char* name,
+                uint64_t start,
+                uint64_t end);
+
+  // The number of events currently held across all threads.
+  size_t GetEventCount() const;
+  void Clear();
+
+  // Returns the events as a JSON object that chrome://tracing and Perfetto can
+  // open, with one complete ("X") event per scope.
+  std::string GetJSON() const;
+  bool WriteToFile(const std::string& path) const;
+
+ private:
+  class ThreadBuffer;
+
+  ThreadBuffer* GetThreadBuffer();
+
+  const uint64_t id_;
+  const size_t events_per_thread_;
+  const std::chrono::steady_clock::time_point epoch_;
+  std::atomic<bool> enabled_;
+
+  mutable std::mutex lock_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceLog);
+};
+
+class ScopedTraceEvent {
+ public:
+  ScopedTraceEvent(const char* category, const char* name)
+      : log_(TraceLog::GetInstance()) {
+    if (log_->is_enabled()) {
+      category_ = category;
+      name_ = name;
+      start_ = log_->Now();
+    }
+  }
+
+  ~ScopedTraceEvent() {
+    if (category_)
+      log_->AddEvent(category_, name_, start_, log_->Now());
+  }
+
+ private:
+  TraceLog* log_;
+  const char* category_ = nullptr;
+  const char* name_ = nullptr;
+  uint64_t start_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedTraceEvent);
+};
+
+}  // namespace zi
@@ -0,0 +1,70 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "zen/trace_event.h"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace zi {
+namespace {
+
+TEST(TraceLog, DisabledByDefault) {
+  TraceLog* log = TraceLog::GetInstance();
+  log->Clear();
+  { ScopedTraceEvent event("test", "Disabled"); }
+  EXPECT_EQ(0u, log->GetEventCount());
+}
+
+TEST(TraceLog, ScopedEvent) {
+  TraceLog* log = TraceLog::GetInstance();
+  log->Clear();
+  log->SetEnabled(true);
+  { ScopedTraceEvent event("test", "Scoped"); }
+  log->SetEnabled(false);
+  EXPECT_EQ(1u, log->GetEventCount());
+  const std::string json = log->GetJSON();
+  EXPECT_NE(std::string::npos,
+            json.find("\"cat\":\"test\",\"name\":\"Scoped\",\"ph\":\"X\""));
+  log->Clear();
+}
+
+TEST(TraceLog, RingBufferKeepsNewestEvents) {
+  TraceLog log(2);
+  log.AddEvent("test", "first", 0, 1000);
+  log.AddEvent("test", "second", 1000, 3000);
+  log.AddEvent("test", "third", 3000, 3500);
+  EXPECT_EQ(2u, log.GetEventCount());
+  EXPECT_EQ(
+      "{\"traceEvents\":[\n"
+      "{\"cat\":\"test\",\"name\":\"second\",\"ph\":\"X\",\"ts\":1.000,"
+      "\"dur\":2.000,\"pid\":1,\"tid\":1},\n"
+      "{\"cat\":\"test\",\"name\":\"third\",\"ph\":\"X\",\"ts\":3.000,"
+      "\"dur\":0.500,\"pid\":1,\"tid\":1}\n"
+      "],\"displayTimeUnit\":\"ns\"}\n",
+      log.GetJSON());
+}
+
+TEST(TraceLog, BufferPerThread) {
+  TraceLog log(4);
+  log.AddEvent("test", "main", 0, 1);
+  std::thread thread([&log]() { log.AddEvent("test", "worker", 0, 1); });
+  thread.join();
+  EXPECT_EQ(2u, log.GetEventCount());
+  EXPECT_NE(std::string::npos, log.GetJSON().find("\"tid\":2"));
+}
+
+}  // namespace
+}  // namespace zi
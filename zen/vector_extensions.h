@@ -14,6 +14,11 @@
 
 #pragma once
 
+#include <stddef.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
 #include <vector>
 
 namespace zi {
@@ -29,14 +34,37 @@ bool EraseValue(std::vector<T>* vector, const T& value) {
   return false;
 }
 
+// Erases the elements of |vector| that match |predicate|. Returns whether
+// any did.
+template <typename T, typename Predicate>
+bool EraseIf(std::vector<T>* vector, Predicate predicate) {
+  auto it = std::remove_if(vector->begin(), vector->end(), predicate);
+  if (it == vector->end())
+    return false;
+  vector->erase(it, vector->end());
+  return true;
+}
+
+// Erases the elements of |vector| that are in [begin, end) in one pass, so
+// that erasing many values does not take time proportional to their product.
+// A few values are looked up directly, which keeps the common case of erasing
+// one value free of allocations.
 template <typename T, typename Iterator>
 bool EraseAllValues(std::vector<T>* vector, Iterator begin, Iterator end) {
-  bool modified = false;
-  for (Iterator it = begin; it != end; ++it) {
-    if (EraseValue(vector, *it))
-      modified = true;
+  constexpr ptrdiff_t kMaxValuesToScan = 8;
+  if (begin == end)
+    return false;
+  if (std::distance(begin, end) <= kMaxValuesToScan) {
+    return EraseIf(vector, [begin, end](const T& value) {
+      return std::find(begin, end, value) != end;
+    });
   }
-  return modified;
+  std::vector<T> values(begin, end);
+  std::sort(values.begin(), values.end(), std::less<T>());
+  return EraseIf(vector, [&values](const T& value) {
+    return std::binary_search(values.begin(), values.end(), value,
+                              std::less<T>());
+  });
 }
 
 }  // namespace zi
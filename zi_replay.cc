@@ -0,0 +1,266 @@
+// Copyright (c) 2016, Google Inc.
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "files/file_util.h"
+#include "files/scoped_fd.h"
+#include "shell/input_trace.h"
+#include "shell/shell.h"
+#include "terminal/virtual_terminal.h"
+#include "zen/allocation_counter.h"
+#include "zen/trace_event.h"
+
+namespace {
+
+struct EventResult {
+  size_t input_size = 0;
+  double micros = 0;
+  // Zero if the event did not paint a frame.
+  size_t frame_size = 0;
+  size_t escape_count = 0;
+  uint64_t allocation_count = 0;
+};
+
+double Percentile(std::vector<double> values, double percentile) {
+  if (values.empty())
+    return 0;
+  std::sort(values.begin(), values.end());
+  size_t index = static_cast<size_t>(percentile * (values.size() - 1));
+  return values[index];
+}
+
+bool ParseSizeFlag(const char* arg, const char* name, size_t* value) {
+  size_t length = strlen(name);
+  if (strncmp(arg, name, length) != 0 || arg[length] != '=')
+    return false;
+  *value = strtoul(arg + length + 1, nullptr, 10);
+  return true;
+}
+
+// A directory under /tmp that is removed along with everything in it.
+class ScratchDirectory {
+ public:
+  ScratchDirectory() {
+    char path[] = "/tmp/zi_replay_XXXXXX";
+    if (mkdtemp(path))
+      path_ = path;
+  }
+
+  ~ScratchDirectory() {
+    if (path_.empty())
+      return;
+    if (DIR* dir = opendir(path_.c_str())) {
+      while (struct dirent* entry = readdir(dir)) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+          unlink((path_ + "/" + entry->d_name).c_str());
+      }
+      closedir(dir);
+    }
+    rmdir(path_.c_str());
+  }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+// Copies the file at |path| into |directory| under the same name, so that the
+// saves, journal and undo history of a replay land next to the copy rather
+// than the original. Returns the path of the copy, or an empty string.
+std::string CopyIntoDirectory(const std::string& path,
+                              const std::string& directory) {
+  size_t size = 0;
+  if (directory.empty() || !zi::GetFileSize(path, &size))
+    return std::string();
+  const size_t slash = path.rfind('/');
+  const std::string copy_path =
+      directory + "/" +
+      (slash == std::string::npos ? path : path.substr(slash + 1));
+  zi::ScopedFD from(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  zi::ScopedFD to(
+      open(copy_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600));
+  if (!from.is_valid() || !to.is_valid() ||
+      !zi::CopyFileRange(from.get(), 0, size, to.get()))
+    return std::string();
+  return copy_path;
+}
+
+void PrintUsage() {
+  fprintf(stderr,
+          "usage: zi_replay [--cols=N] [--rows=N] [--diff] [--events] "
+          "[--trace=<path>] <trace> [<file>]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t cols = 0;
+  size_t rows = 0;
+  bool print_events = false;
+  std::string trace_event_path;
+  zi::RenderMode render_mode = zi::RenderMode::FullRedraw;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    if (ParseSizeFlag(argv[i], "--cols", &cols) ||
+        ParseSizeFlag(argv[i], "--rows", &rows))
+      continue;
+    if (strcmp(argv[i], "--events") == 0)
+      print_events = true;
+    else if (strcmp(argv[i], "--diff") == 0)
+      render_mode = zi::RenderMode::Diffed;
+    else if (strncmp(argv[i], "--trace=", 8) == 0)
+      trace_event_path = argv[i] + 8;
+    else
+      args.push_back(argv[i]);
+  }
+  if (args.empty() || args.size() > 2) {
+    PrintUsage();
+    return 1;
+  }
+
+  zi::InputTrace trace;
+  if (!zi::ReadInputTrace(args[0], &trace)) {
+    fprintf(stderr, "error: Unable to read input trace %s.\n",
+            args[0].c_str());
+    return 1;
+  }
+  cols = cols ? cols : trace.cols;
+  rows = rows ? rows : trace.rows;
+
+  // Trace events are only recorded in builds with zi_enable_tracing.
+  if (!trace_event_path.empty())
+    zi::TraceLog::GetInstance()->SetEnabled(true);
+
+  // The trace is replayed on a copy of the file, so that saving or quitting
+  // cannot change the original and its journal and undo history neither
+  // change the replay nor are changed by it. Declared before the shell, which
+  // closes its journal when it goes away.
+  ScratchDirectory scratch;
+  std::string file_path;
+  if (args.size() > 1) {
+    file_path = CopyIntoDirectory(args[1], scratch.path());
+    if (file_path.empty()) {
+      fprintf(stderr, "error: Unable to copy %s.\n", args[1].c_str());
+      return 1;
+    }
+  }
+
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+  std::vector<EventResult> results;
+  zi::VirtualTerminal terminal(cols, rows);
+  zi::Shell shell(&terminal, cols, rows);
+  shell.SetRenderMode(render_mode);
+  double open_millis = 0;
+  double load_millis = 0;
+  if (args.size() > 1) {
+    const Clock::time_point open_start = Clock::now();
+    shell.OpenFile(file_path);
+    open_millis = std::chrono::duration<double, std::milli>(Clock::now() -
+                                                            open_start)
+                      .count();
+    // Replay against the whole file so that runs are comparable.
+    shell.FinishLoading();
+    load_millis = std::chrono::duration<double, std::milli>(Clock::now() -
+                                                            open_start)
+                      .count();
+  }
+  for (const auto& event : trace.events) {
+    if (shell.should_quit())
+      break;
+    const size_t bytes_written = terminal.bytes_written();
+    const size_t escape_count = terminal.escape_count();
+    const zi::ScopedAllocationCounter allocations;
+    const Clock::time_point event_start = Clock::now();
+    shell.ProcessInput(event.data.data(), event.data.size());
+    EventResult result;
+    result.input_size = event.data.size();
+    result.micros =
+        std::chrono::duration<double, std::micro>(Clock::now() - event_start)
+            .count();
+    result.frame_size = terminal.bytes_written() - bytes_written;
+    result.escape_count = terminal.escape_count() - escape_count;
+    result.allocation_count = allocations.count();
+    results.push_back(result);
+  }
+  // Count background saves toward the total.
+  shell.FinishSaving();
+  const double total_millis =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  std::vector<double> micros;
+  std::vector<double> frame_sizes;
+  size_t input_bytes = 0;
+  size_t escape_count = 0;
+  uint64_t allocation_count = 0;
+  uint64_t max_allocation_count = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const EventResult& result = results[i];
+    if (print_events) {
+      printf("event %zu: input=%zu time=%.1fus frame=%zu escapes=%zu "
+             "allocations=%llu\n",
+             i, result.input_size, result.micros, result.frame_size,
+             result.escape_count,
+             static_cast<unsigned long long>(result.allocation_count));
+    }
+    input_bytes += result.input_size;
+    micros.push_back(result.micros);
+    escape_count += result.escape_count;
+    allocation_count += result.allocation_count;
+    max_allocation_count =
+        std::max(max_allocation_count, result.allocation_count);
+    if (result.frame_size)
+      frame_sizes.push_back(result.frame_size);
+  }
+  double frame_bytes = 0;
+  for (double size : frame_sizes)
+    frame_bytes += size;
+
+  printf("events: %zu (%zu bytes)\n", results.size(), input_bytes);
+  printf("frames: %zu (%.0f bytes, max %.0f bytes, %zu escapes)\n",
+         frame_sizes.size(), frame_bytes, Percentile(frame_sizes, 1.0),
+         escape_count);
+  printf("event time: p50 %.1fus, p99 %.1fus, max %.1fus\n",
+         Percentile(micros, 0.5), Percentile(micros, 0.99),
+         Percentile(micros, 1.0));
+  printf("allocations: %llu (max %llu per event)\n",
+         static_cast<unsigned long long>(allocation_count),
+         static_cast<unsigned long long>(max_allocation_count));
+  if (args.size() > 1)
+    printf("open: %.1fms (loaded in %.1fms)\n", open_millis, load_millis);
+  printf("total: %.1fms\n", total_millis);
+  for (int i = 0; i < zi::LatencyStats::kPhaseCount; ++i) {
+    printf("%s\n", shell.stats()
+                       .GetSummary(static_cast<zi::LatencyStats::Phase>(i))
+                       .c_str());
+  }
+  if (!trace_event_path.empty() &&
+      !zi::TraceLog::GetInstance()->WriteToFile(trace_event_path)) {
+    fprintf(stderr, "error: Unable to write %s.\n", trace_event_path.c_str());
+    return 1;
+  }
+  return 0;
+}